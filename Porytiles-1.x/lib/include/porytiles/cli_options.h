@@ -107,6 +107,20 @@ DISABLE_ATTRIBUTE_GENERATION
 )}.substr(1);
 constexpr int DISABLE_ATTRIBUTE_GENERATION_VAL = 1003;
 
+const std::string JOBS = "jobs";
+const std::string JOBS_DESC = std::string{fmt::format(R"(
+        -{}=<N>
+            Use up to N worker threads for the parallel parts of compilation,
+            e.g. tile normalization and the palette assignment parameter
+            search matrix. The result, and the order of any warnings, does not
+            depend on N. Defaults to the number of hardware threads on your
+            machine. Use `-{}=1' to run single-threaded. N may be at most 16
+            times the number of hardware threads.
+)",
+JOBS, JOBS
+)}.substr(1);
+constexpr int JOBS_VAL = 1004;
+
 
 /*
  * Tileset Compilation and Decompilation Options
@@ -220,8 +234,14 @@ constexpr int PRESERVE_TRANSPARENCY_VAL = 2008;
 const std::string ASSIGN_ALGO = "assign-algorithm";
 const std::string ASSIGN_ALGO_DESC = std::string{fmt::format(R"(
         -{}=<ALGORITHM>
-            Select the palette assignment algorithm. Valid options are `dfs' and
-            `bfs'. Default is `dfs'.
+            Select the palette assignment algorithm. Valid options are `dfs',
+            `bfs', `beam', and `local'. Default is `dfs'. The `beam' algorithm
+            is a breadth first search that only keeps the most promising states
+            at each depth, see `-beam-width'. The `local' algorithm runs a
+            local search over complete assignments, it cannot prove that no
+            assignment exists but it may find one on tilesets that are too dense
+            for the tree searches. For `local', the explore cutoff counts
+            iterations instead of tree nodes.
 )",
 ASSIGN_ALGO
 )}.substr(1);
@@ -252,6 +272,29 @@ BEST_BRANCHES
 constexpr int BEST_BRANCHES_VAL = 3002;
 const std::string SMART_PRUNE = "smart";
 
+const std::string BEAM_WIDTH = "beam-width";
+const std::string BEAM_WIDTH_DESC = std::string{fmt::format(R"(
+        -{}=<N>
+            Keep at most N states at each depth of the assignment tree when
+            using the `beam' algorithm. Wider beams are less likely to miss a
+            solution, but use more memory. Default is 1000.
+)",
+BEAM_WIDTH
+)}.substr(1);
+constexpr int BEAM_WIDTH_VAL = 3008;
+
+const std::string ASSIGN_SEED = "assign-seed";
+const std::string ASSIGN_SEED_DESC = std::string{fmt::format(R"(
+        -{}=<N>
+            Seed used to break ties between equally good palettes when the
+            `dfs' algorithm picks which branch to try first. Default is 0, which
+            keeps the standard order. The parameter search matrix saves the seed
+            of a successful restart here so later builds can replay it.
+)",
+ASSIGN_SEED
+)}.substr(1);
+constexpr int ASSIGN_SEED_VAL = 3010;
+
 const std::string DISABLE_ASSIGN_CACHING = "disable-assign-caching";
 const std::string DISABLE_ASSIGN_CACHING_DESC = std::string{fmt::format(R"(
         -{}
@@ -273,6 +316,48 @@ FORCE_ASSIGN_PARAM_MATRIX
 )}.substr(1);
 constexpr int FORCE_ASSIGN_PARAM_MATRIX_VAL = 3004;
 
+const std::string DISABLE_GREEDY_ASSIGN = "disable-greedy-assign";
+const std::string DISABLE_GREEDY_ASSIGN_DESC = std::string{fmt::format(R"(
+        -{}
+            Do not try the fast greedy palette packing before the palette
+            assignment search. The greedy packing usually picks different
+            palettes than the search would, use this to get the palettes the
+            search finds.
+)",
+DISABLE_GREEDY_ASSIGN
+)}.substr(1);
+constexpr int DISABLE_GREEDY_ASSIGN_VAL = 3014;
+
+const std::string ASSIGN_TIMEOUT = "assign-timeout";
+const std::string ASSIGN_TIMEOUT_DESC = std::string{fmt::format(R"(
+        -{}=<SECONDS>
+            Give up on palette assignment if it has not finished after SECONDS
+            seconds. The time is shared out across the attempts that are still
+            left to run, so each entry of the parameter search matrix gets its
+            turn. For `compile-secondary', the paired primary and the secondary
+            share the same SECONDS. Unlike the node cutoff, this bounds wall
+            time no matter how fast your machine is. Defaults to 0, which means
+            no timeout.
+)",
+ASSIGN_TIMEOUT
+)}.substr(1);
+constexpr int ASSIGN_TIMEOUT_VAL = 3012;
+
+const std::string ASSIGN_STATS = "assign-stats";
+const std::string ASSIGN_STATS_DESC = std::string{fmt::format(R"(
+        -{}=<PATH>
+            Write statistics about every palette assignment attempt to PATH as
+            JSON: the params and outcome of each attempt, nodes per second, how
+            deep the search got and where it backtracked, and which parameter
+            search matrix entry won. Useful for tuning `assign.cache' params.
+)",
+ASSIGN_STATS
+)}.substr(1);
+constexpr int ASSIGN_STATS_VAL = 3013;
+
+// These keys only appear in `assign.cache', they record the palettes the last successful assignment produced
+const std::string SOLUTION_PALETTE = "solution-palette";
+
 const std::string PRIMARY_ASSIGN_ALGO = "primary-assign-algorithm";
 const std::string PRIMARY_ASSIGN_ALGO_DESC = std::string{fmt::format(R"(
         -{}=<FACTOR>
@@ -304,6 +389,26 @@ PRIMARY_BEST_BRANCHES
 )}.substr(1);
 constexpr int PRIMARY_BEST_BRANCHES_VAL = 3007;
 
+const std::string PRIMARY_BEAM_WIDTH = "primary-beam-width";
+const std::string PRIMARY_BEAM_WIDTH_DESC = std::string{fmt::format(R"(
+        -{}=<N>
+            Same as `-beam-width', but for the paired primary set. Only to be
+            used when compiling in secondary mode via `compile-secondary'.
+)",
+PRIMARY_BEAM_WIDTH
+)}.substr(1);
+constexpr int PRIMARY_BEAM_WIDTH_VAL = 3009;
+
+const std::string PRIMARY_ASSIGN_SEED = "primary-assign-seed";
+const std::string PRIMARY_ASSIGN_SEED_DESC = std::string{fmt::format(R"(
+        -{}=<N>
+            Same as `-assign-seed', but for the paired primary set. Only to be
+            used when compiling in secondary mode via `compile-secondary'.
+)",
+PRIMARY_ASSIGN_SEED
+)}.substr(1);
+constexpr int PRIMARY_ASSIGN_SEED_VAL = 3011;
+
 
 /*
  * Fieldmap Override Options
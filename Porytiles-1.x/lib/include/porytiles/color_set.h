@@ -0,0 +1,347 @@
+#ifndef PORYTILES_COLOR_SET_H
+#define PORYTILES_COLOR_SET_H
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+
+/**
+ * A fixed width set of color indexes, laid out as whole 64-bit words. This is what palette assignment spends nearly all
+ * of its time on: every node of the search unions, intersects and counts a handful of these. std::bitset can do all of
+ * that, but its count() is a generic loop that only becomes a hardware popcount if the whole program is built for a CPU
+ * that has one, and it has no way to count a union or an intersection without building a temporary first.
+ *
+ * The interface mirrors the parts of std::bitset the compiler uses, so it drops in where a bitset was, plus a few fused
+ * operations like countOr() and isSubsetOf() for the hot loops.
+ */
+
+namespace porytiles {
+
+namespace detail {
+
+// True once startup has found a POPCNT instruction on this CPU. Until then it reads false, which is slower but correct.
+extern const bool hasHardwarePopcount;
+
+// Only called when hasHardwarePopcount is set, this one is compiled to use the POPCNT instruction
+std::size_t popcountWordsHardware(const std::uint64_t *words, std::size_t wordCount);
+
+/*
+ * Bit twiddling popcount for CPUs without a POPCNT instruction. std::popcount would fall back to something like this
+ * anyway, but spelling it out keeps the fallback branch free of calls into libgcc.
+ */
+constexpr std::size_t popcountWordPortable(std::uint64_t word)
+{
+  word = word - ((word >> 1) & 0x5555555555555555ULL);
+  word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+  word = (word + (word >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<std::size_t>((word * 0x0101010101010101ULL) >> 56);
+}
+
+template <std::size_t WordCount> std::size_t popcountWords(const std::array<std::uint64_t, WordCount> &words)
+{
+#if defined(__POPCNT__) || defined(__AVX2__) ||                                                                        \
+    !(defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86))
+  // Either the build already targets a CPU with POPCNT, or this is not x86 and std::popcount is the native instruction
+  std::size_t total = 0;
+  for (std::uint64_t word : words) {
+    total += std::popcount(word);
+  }
+  return total;
+#else
+  if (hasHardwarePopcount) {
+    return popcountWordsHardware(words.data(), WordCount);
+  }
+  std::size_t total = 0;
+  for (std::uint64_t word : words) {
+    total += popcountWordPortable(word);
+  }
+  return total;
+#endif
+}
+
+} // namespace detail
+
+template <std::size_t Bits> class ColorBitSet {
+public:
+  static constexpr std::size_t WORD_BITS = 64;
+  static constexpr std::size_t WORD_COUNT = (Bits + WORD_BITS - 1) / WORD_BITS;
+
+  constexpr ColorBitSet() : words{} {}
+  constexpr ColorBitSet(unsigned long long value) : words{}
+  {
+    words[0] = value;
+    trim();
+  }
+
+  // Resize from a set of another width, colors past the new width are dropped
+  template <std::size_t OtherBits> explicit constexpr ColorBitSet(const ColorBitSet<OtherBits> &other) : words{}
+  {
+    for (std::size_t i = 0; i < WORD_COUNT && i < ColorBitSet<OtherBits>::WORD_COUNT; i++) {
+      words[i] = other.word(i);
+    }
+    trim();
+  }
+
+  [[nodiscard]] constexpr std::size_t size() const { return Bits; }
+
+  [[nodiscard]] std::size_t count() const { return detail::popcountWords(words); }
+
+  [[nodiscard]] constexpr bool any() const
+  {
+    std::uint64_t merged = 0;
+    for (std::uint64_t word : words) {
+      merged |= word;
+    }
+    return merged != 0;
+  }
+
+  [[nodiscard]] constexpr bool none() const { return !any(); }
+
+  [[nodiscard]] constexpr bool all() const { return *this == ~ColorBitSet{}; }
+
+  [[nodiscard]] constexpr bool test(std::size_t pos) const
+  {
+    if (pos >= Bits) {
+      throw std::out_of_range{"ColorBitSet::test: pos " + std::to_string(pos) + " out of range"};
+    }
+    return (*this)[pos];
+  }
+
+  constexpr bool operator[](std::size_t pos) const { return (words[pos / WORD_BITS] >> (pos % WORD_BITS)) & 1; }
+
+  // Raw access to the underlying words, least significant first. Bits past size() are always zero.
+  [[nodiscard]] constexpr std::uint64_t word(std::size_t i) const { return words[i]; }
+
+  constexpr ColorBitSet &set()
+  {
+    words.fill(~std::uint64_t{0});
+    trim();
+    return *this;
+  }
+
+  constexpr ColorBitSet &set(std::size_t pos, bool value = true)
+  {
+    if (pos >= Bits) {
+      throw std::out_of_range{"ColorBitSet::set: pos " + std::to_string(pos) + " out of range"};
+    }
+    std::uint64_t mask = std::uint64_t{1} << (pos % WORD_BITS);
+    if (value) {
+      words[pos / WORD_BITS] |= mask;
+    }
+    else {
+      words[pos / WORD_BITS] &= ~mask;
+    }
+    return *this;
+  }
+
+  constexpr ColorBitSet &reset()
+  {
+    words.fill(0);
+    return *this;
+  }
+
+  constexpr ColorBitSet &reset(std::size_t pos) { return set(pos, false); }
+
+  constexpr ColorBitSet &flip()
+  {
+    for (std::uint64_t &word : words) {
+      word = ~word;
+    }
+    trim();
+    return *this;
+  }
+
+  constexpr ColorBitSet &flip(std::size_t pos) { return set(pos, !test(pos)); }
+
+  /*
+   * The bitwise operators are plain loops over the words. Compilers turn them into SSE2 (or AVX2, when the build allows
+   * it) on their own, which beats dispatching each one at runtime: a single op is only a few instructions, less than
+   * the cost of an indirect call.
+   */
+  constexpr ColorBitSet &operator&=(const ColorBitSet &other)
+  {
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      words[i] &= other.words[i];
+    }
+    return *this;
+  }
+
+  constexpr ColorBitSet &operator|=(const ColorBitSet &other)
+  {
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      words[i] |= other.words[i];
+    }
+    return *this;
+  }
+
+  constexpr ColorBitSet &operator^=(const ColorBitSet &other)
+  {
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      words[i] ^= other.words[i];
+    }
+    return *this;
+  }
+
+  constexpr ColorBitSet operator~() const { return ColorBitSet{*this}.flip(); }
+
+  constexpr ColorBitSet &operator<<=(std::size_t shift)
+  {
+    if (shift >= Bits) {
+      return reset();
+    }
+    std::size_t wordShift = shift / WORD_BITS;
+    std::size_t bitShift = shift % WORD_BITS;
+    for (std::size_t i = WORD_COUNT; i-- > 0;) {
+      std::uint64_t word = 0;
+      if (i >= wordShift) {
+        word = words[i - wordShift] << bitShift;
+        if (bitShift != 0 && i > wordShift) {
+          word |= words[i - wordShift - 1] >> (WORD_BITS - bitShift);
+        }
+      }
+      words[i] = word;
+    }
+    trim();
+    return *this;
+  }
+
+  constexpr ColorBitSet &operator>>=(std::size_t shift)
+  {
+    if (shift >= Bits) {
+      return reset();
+    }
+    std::size_t wordShift = shift / WORD_BITS;
+    std::size_t bitShift = shift % WORD_BITS;
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      std::uint64_t word = 0;
+      if (i + wordShift < WORD_COUNT) {
+        word = words[i + wordShift] >> bitShift;
+        if (bitShift != 0 && i + wordShift + 1 < WORD_COUNT) {
+          word |= words[i + wordShift + 1] << (WORD_BITS - bitShift);
+        }
+      }
+      words[i] = word;
+    }
+    return *this;
+  }
+
+  constexpr ColorBitSet operator<<(std::size_t shift) const { return ColorBitSet{*this} <<= shift; }
+  constexpr ColorBitSet operator>>(std::size_t shift) const { return ColorBitSet{*this} >>= shift; }
+
+  constexpr bool operator==(const ColorBitSet &other) const = default;
+
+  [[nodiscard]] unsigned long long to_ullong() const
+  {
+    for (std::size_t i = 1; i < WORD_COUNT; i++) {
+      if (words[i] != 0) {
+        throw std::overflow_error{"ColorBitSet::to_ullong: value does not fit in unsigned long long"};
+      }
+    }
+    return words[0];
+  }
+
+  [[nodiscard]] std::string to_string(char zero = '0', char one = '1') const
+  {
+    std::string result(Bits, zero);
+    for (std::size_t pos = 0; pos < Bits; pos++) {
+      if ((*this)[pos]) {
+        result[Bits - 1 - pos] = one;
+      }
+    }
+    return result;
+  }
+
+  /*
+   * Fused versions of the expressions the palette assignment searches evaluate at every node. Each one makes a single
+   * pass over the words instead of building a temporary ColorBitSet and then walking it again.
+   */
+
+  // Same as (*this & other).count()
+  [[nodiscard]] std::size_t countAnd(const ColorBitSet &other) const
+  {
+    std::array<std::uint64_t, WORD_COUNT> merged{};
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      merged[i] = words[i] & other.words[i];
+    }
+    return detail::popcountWords(merged);
+  }
+
+  // Same as (*this | other).count()
+  [[nodiscard]] std::size_t countOr(const ColorBitSet &other) const
+  {
+    std::array<std::uint64_t, WORD_COUNT> merged{};
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      merged[i] = words[i] | other.words[i];
+    }
+    return detail::popcountWords(merged);
+  }
+
+  // Same as (*this & other).any()
+  [[nodiscard]] constexpr bool intersects(const ColorBitSet &other) const
+  {
+    std::uint64_t merged = 0;
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      merged |= words[i] & other.words[i];
+    }
+    return merged != 0;
+  }
+
+  // Same as (*this & ~other).none(), i.e. every color in this set is also in other
+  [[nodiscard]] constexpr bool isSubsetOf(const ColorBitSet &other) const
+  {
+    std::uint64_t extra = 0;
+    for (std::size_t i = 0; i < WORD_COUNT; i++) {
+      extra |= words[i] & ~other.words[i];
+    }
+    return extra == 0;
+  }
+
+private:
+  std::array<std::uint64_t, WORD_COUNT> words;
+
+  // Keep the bits past the logical size zeroed, so count(), == and hashing never see them
+  constexpr void trim()
+  {
+    if constexpr (Bits % WORD_BITS != 0) {
+      words[WORD_COUNT - 1] &= (std::uint64_t{1} << (Bits % WORD_BITS)) - 1;
+    }
+  }
+};
+
+template <std::size_t Bits>
+constexpr ColorBitSet<Bits> operator&(const ColorBitSet<Bits> &lhs, const ColorBitSet<Bits> &rhs)
+{
+  return ColorBitSet<Bits>{lhs} &= rhs;
+}
+
+template <std::size_t Bits>
+constexpr ColorBitSet<Bits> operator|(const ColorBitSet<Bits> &lhs, const ColorBitSet<Bits> &rhs)
+{
+  return ColorBitSet<Bits>{lhs} |= rhs;
+}
+
+template <std::size_t Bits>
+constexpr ColorBitSet<Bits> operator^(const ColorBitSet<Bits> &lhs, const ColorBitSet<Bits> &rhs)
+{
+  return ColorBitSet<Bits>{lhs} ^= rhs;
+}
+
+} // namespace porytiles
+
+template <std::size_t Bits> struct std::hash<porytiles::ColorBitSet<Bits>> {
+  std::size_t operator()(const porytiles::ColorBitSet<Bits> &colors) const noexcept
+  {
+    std::uint64_t hash = 0;
+    for (std::size_t i = 0; i < porytiles::ColorBitSet<Bits>::WORD_COUNT; i++) {
+      hash = (hash ^ colors.word(i)) * 0x100000001b3ULL;
+      hash ^= hash >> 29;
+    }
+    return static_cast<std::size_t>(hash);
+  }
+};
+
+#endif // PORYTILES_COLOR_SET_H
@@ -1,10 +1,10 @@
 #ifndef PORYTILES_COMPILER_H
 #define PORYTILES_COMPILER_H
 
-#include <bitset>
 #include <memory>
 #include <tuple>
 
+#include "color_set.h"
 #include "porytiles_context.h"
 #include "types.h"
 
@@ -38,9 +38,10 @@ std::unique_ptr<CompiledTileset> compile(PorytilesContext &ctx, CompilerMode com
  * code a bit more readable.
  */
 // ColorSets won't account for transparency color, we will handle that at the end
-using ColorSet = std::bitset<porytiles::MAX_BG_PALETTES *(porytiles::PAL_SIZE - 1)>;
+using ColorSet = porytiles::ColorBitSet<porytiles::MAX_BG_PALETTES *(porytiles::PAL_SIZE - 1)>;
 // using DecompiledIndex = std::size_t;
 using IndexAndNormTile = std::pair<porytiles::DecompiledIndex, porytiles::NormalizedTile>;
-using IndexedNormTileWithColorSet = std::tuple<porytiles::DecompiledIndex, porytiles::NormalizedTile, ColorSet>;
+// The std::size_t is the position of the matched tile in its IndexAndNormTile vector
+using IndexedNormTileWithColorSet = std::tuple<porytiles::DecompiledIndex, std::size_t, ColorSet>;
 
 #endif // PORYTILES_COMPILER_H
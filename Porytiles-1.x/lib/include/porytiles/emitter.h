@@ -56,6 +56,11 @@ void emitDecompiled(PorytilesContext &ctx, DecompilerMode mode, png::image<png::
                     const std::unordered_map<std::uint8_t, std::string> &behaviorReverseMap);
 
 void emitAssignCache(PorytilesContext &ctx, const CompilerMode &mode, std::ostream &out);
+
+/**
+ * Write the `-assign-stats' report for every palette assignment attempt made so far, as JSON.
+ */
+void emitAssignStats(PorytilesContext &ctx, std::ostream &out);
 } // namespace porytiles
 
 #endif // PORYTILES_EMITTER_H
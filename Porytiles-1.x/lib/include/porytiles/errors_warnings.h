@@ -203,9 +203,17 @@ void fatalerror_tooManyUniqueTiles(const ErrorsAndWarnings &err, const CompilerS
 void fatalerror_assignExploreCutoffReached(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs,
                                            CompilerMode mode, AssignAlgorithm algo, std::size_t maxRecurses);
 
+void fatalerror_assignTimeoutReached(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs, CompilerMode mode,
+                                     std::size_t timeoutSeconds, std::size_t timedOutAttempts,
+                                     std::size_t skippedAttempts, std::size_t totalAttempts, std::size_t required,
+                                     std::size_t available);
+
 void fatalerror_noPossiblePaletteAssignment(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs,
                                             CompilerMode mode);
 
+void fatalerror_paletteAssignmentNeedsMorePalettes(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs,
+                                                   CompilerMode mode, std::size_t required, std::size_t available);
+
 void fatalerror_tooManyMetatiles(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs, CompilerMode mode,
                                  std::size_t numMetatiles, std::size_t metatileLimit);
 
@@ -1,7 +1,14 @@
 #ifndef PORYTILES_PALETTE_ASSIGNMENT_H
 #define PORYTILES_PALETTE_ASSIGNMENT_H
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <stdexcept>
 #include <vector>
 
 #include "compiler.h"
@@ -13,12 +20,111 @@ namespace porytiles {
 constexpr std::size_t EXPLORATION_CUTOFF_MULTIPLIER = 1'000'000;
 constexpr std::size_t EXPLORATION_MAX_CUTOFF = 100 * EXPLORATION_CUTOFF_MULTIPLIER;
 
-struct AssignState {
+/*
+ * splitmix64 finalizer. Cheap enough to compute on the fly, so the Zobrist keys below don't need a table.
+ */
+constexpr std::uint64_t mixHash64(std::uint64_t x)
+{
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+/*
+ * Zobrist hash of a ColorSet: the XOR of one random key per color in the set. Toggling colors just XORs their keys in
+ * or out, which is what lets HardwarePalettes keep its hashes up to date as colors are added.
+ */
+template <std::size_t Bits> std::uint64_t zobristColorSetHash(const ColorBitSet<Bits> &colors)
+{
+  std::uint64_t hash = 0;
+  for (std::size_t i = 0; i < ColorBitSet<Bits>::WORD_COUNT; i++) {
+    std::size_t base = i * ColorBitSet<Bits>::WORD_BITS;
+    std::uint64_t word = colors.word(i);
+    while (word != 0) {
+      hash ^= mixHash64(base + std::countr_zero(word));
+      word &= word - 1;
+    }
+  }
+  return hash;
+}
+
+/*
+ * Fixed capacity stand-in for std::vector<ColorSet> that keeps every hardware palette inline. The assignment searches
+ * create and copy states constantly, and keeping the palettes off the heap turns each of those into a plain memcpy.
+ *
+ * Alongside the palettes we keep a Zobrist hash of each palette plus a fingerprint of the whole set. The fingerprint is
+ * the wrapping sum of the mixed palette hashes, so it does not depend on palette order and, unlike a plain XOR, two
+ * identical palettes do not cancel out. Palettes may only be written through set/merge/swap, which keep both hashes in
+ * sync in time proportional to the number of colors that changed.
+ */
+template <typename ColorSetType> struct BasicHardwarePalettes {
+  std::array<ColorSetType, MAX_BG_PALETTES> palettes;
+  std::array<std::uint64_t, MAX_BG_PALETTES> paletteHashes;
+  std::size_t count;
+  std::uint64_t fingerprint;
+
+  BasicHardwarePalettes() : palettes{}, paletteHashes{}, count{0}, fingerprint{0} {}
+
+  explicit BasicHardwarePalettes(std::size_t count) : palettes{}, paletteHashes{}, count{count}, fingerprint{0}
+  {
+    if (count > MAX_BG_PALETTES) {
+      throw std::out_of_range{"HardwarePalettes count exceeds MAX_BG_PALETTES"};
+    }
+    fingerprint = count * mixHash64(0);
+  }
+
+  // Implicit on purpose, so states can still be brace-initialized from a vector of palettes
+  BasicHardwarePalettes(const std::vector<ColorSetType> &palettes) : BasicHardwarePalettes{palettes.size()}
+  {
+    for (std::size_t i = 0; i < count; i++) {
+      set(i, palettes[i]);
+    }
+  }
+
+  [[nodiscard]] std::size_t size() const { return count; }
+
+  [[nodiscard]] const ColorSetType &at(std::size_t i) const
+  {
+    if (i >= count) {
+      throw std::out_of_range{"HardwarePalettes index out of range"};
+    }
+    return palettes[i];
+  }
+
+  const ColorSetType &operator[](std::size_t i) const { return palettes[i]; }
+
+  [[nodiscard]] const ColorSetType *begin() const { return palettes.data(); }
+  [[nodiscard]] const ColorSetType *end() const { return palettes.data() + count; }
+
+  void set(std::size_t i, const ColorSetType &palette)
+  {
+    std::uint64_t newHash = paletteHashes[i] ^ zobristColorSetHash(palettes[i] ^ palette);
+    fingerprint += mixHash64(newHash) - mixHash64(paletteHashes[i]);
+    palettes[i] = palette;
+    paletteHashes[i] = newHash;
+  }
+
+  void merge(std::size_t i, const ColorSetType &colors) { set(i, palettes[i] | colors); }
+
+  void swap(std::size_t i, std::size_t j)
+  {
+    std::swap(palettes[i], palettes[j]);
+    std::swap(paletteHashes[i], paletteHashes[j]);
+  }
+
+  auto operator==(const BasicHardwarePalettes &other) const
+  {
+    return count == other.count && fingerprint == other.fingerprint && std::equal(begin(), end(), other.begin());
+  }
+};
+
+template <typename ColorSetType> struct BasicAssignState {
   /*
    * One color set for each hardware palette, bits in color set will indicate which colors this HW palette will have.
-   * The size of the vector should be fixed to maxPalettes.
+   * The size should be fixed to maxPalettes.
    */
-  std::vector<ColorSet> hardwarePalettes;
+  BasicHardwarePalettes<ColorSetType> hardwarePalettes;
 
   // The count of unassigned palettes
   std::size_t unassignedCount;
@@ -26,29 +132,197 @@ struct AssignState {
   // The count of unassigned primer palettes
   std::size_t unassignedPrimerCount;
 
-  auto operator==(const AssignState &other) const
+  auto operator==(const BasicAssignState &other) const
   {
     return this->hardwarePalettes == other.hardwarePalettes && this->unassignedCount == other.unassignedCount &&
            this->unassignedPrimerCount == other.unassignedPrimerCount;
   }
 };
 
-enum class AssignResult { SUCCESS, EXPLORE_CUTOFF_REACHED, NO_SOLUTION_POSSIBLE };
-} // namespace porytiles
+/*
+ * The searches are templated on the ColorSet type they run with. Most tilesets use far fewer than the 240 colors a
+ * ColorSet can hold, and a narrower set makes every state smaller to copy and store, and every union and count shorter.
+ * runPaletteAssignmentMatrix picks the narrowest of these that fits the tileset's colors, ColorSet itself is the widest.
+ */
+using ColorSet64 = ColorBitSet<64>;
+using ColorSet128 = ColorBitSet<128>;
+using HardwarePalettes = BasicHardwarePalettes<ColorSet>;
+using AssignState = BasicAssignState<ColorSet>;
+
+enum class AssignResult { SUCCESS, EXPLORE_CUTOFF_REACHED, NO_SOLUTION_POSSIBLE, CANCELLED };
+
+struct AssignParams {
+  AssignAlgorithm assignAlgorithm;
+  std::size_t exploredNodeCutoff;
+  std::size_t bestBranches;
+  bool smartPrune;
+
+  // Only used by beam search, defaulted so the other algorithms can leave it out
+  std::size_t beamWidth = DEFAULT_BEAM_WIDTH;
+
+  // Depth first search only: breaks ties in the branch order, 0 keeps the plain order
+  std::uint64_t seed = 0;
+
+  /*
+   * Depth first search only: run in short bursts on a Luby schedule, each burst with its own seed. A successful run
+   * rewrites its params to a plain run with the winning seed, so caching them replays that burst directly.
+   */
+  bool restarts = false;
+};
+
+/*
+ * Cooperative cancellation flag for a running search. Tokens can be chained: a token also counts as cancelled once any
+ * of its parents has been cancelled, so cancelling a whole search also stops all the tasks it spawned. A token may also
+ * carry a deadline, the earliest deadline along the chain is the one that applies.
+ */
+struct AssignCancelToken {
+  using Clock = std::chrono::steady_clock;
+
+  std::atomic_bool cancelled;
+  const AssignCancelToken *parent;
+  // Clock::time_point::max() means no deadline
+  Clock::time_point deadline;
+
+  AssignCancelToken() : cancelled{false}, parent{nullptr}, deadline{Clock::time_point::max()} {}
+  explicit AssignCancelToken(const AssignCancelToken *parent)
+      : cancelled{false}, parent{parent}, deadline{Clock::time_point::max()}
+  {
+  }
+
+  void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+  [[nodiscard]] bool isCancelled() const
+  {
+    return cancelled.load(std::memory_order_relaxed) || (parent != nullptr && parent->isCancelled());
+  }
+
+  [[nodiscard]] Clock::time_point effectiveDeadline() const
+  {
+    return parent == nullptr ? deadline : std::min(deadline, parent->effectiveDeadline());
+  }
+
+  [[nodiscard]] bool deadlinePassed() const
+  {
+    Clock::time_point effective = effectiveDeadline();
+    return effective != Clock::time_point::max() && Clock::now() >= effective;
+  }
+};
+
+// Reading the clock costs a lot more than exploring a node, so searches only look at their deadline this often
+constexpr std::size_t DEADLINE_CHECK_INTERVAL = 1024;
+
+struct NogoodTable;
+
+/*
+ * Bookkeeping for a single run of an assignment algorithm. Every run owns its own AssignSearch instead of sharing the
+ * node counter in CompilerContext, which is what lets the parameter search matrix run several attempts at once.
+ */
+struct AssignSearch {
+  AssignParams params;
+  std::size_t exploredNodeCounter;
 
-template <> struct std::hash<porytiles::AssignState> {
-  std::size_t operator()(const porytiles::AssignState &state) const noexcept
+  // If set, the search bails out with AssignResult::CANCELLED as soon as this token is cancelled
+  const AssignCancelToken *cancelToken;
+
+  /*
+   * If set, exploredNodeCutoff applies to the total of every search tallying into this counter rather than to this
+   * search alone. Nodes are added in batches, the last total we saw is kept in sharedExploredNodeTotal.
+   */
+  std::atomic_size_t *sharedExploredNodeCounter;
+  std::size_t sharedExploredNodeTotal;
+  std::size_t flushedExploredNodes;
+
+  // If set, depth first search remembers the states it has seen fail here and skips them when they come up again
+  NogoodTable *nogoods;
+
+  // Set once the search sees its deadline pass, a CANCELLED result with this set means we ran out of time
+  bool timedOut;
+  std::size_t deadlineCheckCountdown;
+
+  // If set, the search records what it sees here for the `-assign-stats' report
+  AssignStats *stats;
+
+  // Take only the covering palette for ColorSets one already holds, when that is sound. Tests clear it to compare
+  bool coveringMoves;
+
+  explicit AssignSearch(const AssignParams &params)
+      : params{params}, exploredNodeCounter{0}, cancelToken{nullptr}, sharedExploredNodeCounter{nullptr},
+        sharedExploredNodeTotal{0}, flushedExploredNodes{0}, nogoods{nullptr}, timedOut{false},
+        deadlineCheckCountdown{0}, stats{nullptr}, coveringMoves{true}
+  {
+  }
+
+  [[nodiscard]] bool isCancelled()
   {
-    std::size_t hashValue = 0;
-    for (auto bitset : state.hardwarePalettes) {
-      hashValue ^= std::hash<std::bitset<240>>{}(bitset);
+    if (cancelToken == nullptr) {
+      return false;
+    }
+    if (timedOut || cancelToken->isCancelled()) {
+      return true;
+    }
+    if (deadlineCheckCountdown == 0) {
+      deadlineCheckCountdown = DEADLINE_CHECK_INTERVAL;
+      timedOut = cancelToken->deadlinePassed();
     }
-    hashValue ^= std::hash<std::bitset<240>>{}(state.unassignedCount);
-    return hashValue;
+    deadlineCheckCountdown--;
+    return timedOut;
+  }
+};
+} // namespace porytiles
+
+template <typename ColorSetType> struct std::hash<porytiles::BasicAssignState<ColorSetType>> {
+  std::size_t operator()(const porytiles::BasicAssignState<ColorSetType> &state) const noexcept
+  {
+    std::uint64_t counts = (static_cast<std::uint64_t>(state.unassignedCount) << 32) ^ state.unassignedPrimerCount;
+    return state.hardwarePalettes.fingerprint ^ porytiles::mixHash64(counts);
   }
 };
 
 namespace porytiles {
+AssignParams assignParamsFromConfig(const CompilerConfig &config, CompilerMode compilerMode);
+
+/*
+ * Hardware palettes are interchangeable, so two states holding the same palettes in a different order are really the
+ * same state. Returns a copy of the state with its palettes in a canonical order, for use as a visited set key.
+ */
+template <typename ColorSetType>
+BasicAssignState<ColorSetType> canonicalAssignState(const BasicAssignState<ColorSetType> &state);
+
+template <typename ColorSetType>
+AssignResult assignDepthFirst(const PorytilesContext &ctx, AssignSearch &search, BasicAssignState<ColorSetType> &state,
+                              std::vector<ColorSetType> &solution, const std::vector<ColorSetType> &primaryPalettes,
+                              const std::vector<ColorSetType> &unassigneds,
+                              const std::vector<ColorSetType> &unassignedPrimers);
+template <typename ColorSetType>
+AssignResult assignBreadthFirst(const PorytilesContext &ctx, AssignSearch &search,
+                                BasicAssignState<ColorSetType> &initialState, std::vector<ColorSetType> &solution,
+                                const std::vector<ColorSetType> &primaryPalettes,
+                                const std::vector<ColorSetType> &unassigneds,
+                                const std::vector<ColorSetType> &unassignedPrimers);
+template <typename ColorSetType>
+AssignResult assignBeamSearch(const PorytilesContext &ctx, AssignSearch &search,
+                              BasicAssignState<ColorSetType> &initialState, std::vector<ColorSetType> &solution,
+                              const std::vector<ColorSetType> &primaryPalettes,
+                              const std::vector<ColorSetType> &unassigneds,
+                              const std::vector<ColorSetType> &unassignedPrimers);
+template <typename ColorSetType>
+AssignResult assignLocalSearch(const PorytilesContext &ctx, AssignSearch &search,
+                               BasicAssignState<ColorSetType> &state, std::vector<ColorSetType> &solution,
+                               const std::vector<ColorSetType> &primaryPalettes,
+                               const std::vector<ColorSetType> &unassigneds,
+                               const std::vector<ColorSetType> &unassignedPrimers);
+template <typename ColorSetType>
+AssignResult assignDepthFirstParallel(const PorytilesContext &ctx, AssignSearch &search, std::size_t jobs,
+                                      BasicAssignState<ColorSetType> &state, std::vector<ColorSetType> &solution,
+                                      const std::vector<ColorSetType> &primaryPalettes,
+                                      const std::vector<ColorSetType> &unassigneds,
+                                      const std::vector<ColorSetType> &unassignedPrimers);
+template <typename ColorSetType>
+AssignResult assignDepthFirstRestarts(const PorytilesContext &ctx, AssignSearch &search,
+                                      BasicAssignState<ColorSetType> &state, std::vector<ColorSetType> &solution,
+                                      const std::vector<ColorSetType> &primaryPalettes,
+                                      const std::vector<ColorSetType> &unassigneds,
+                                      const std::vector<ColorSetType> &unassignedPrimers);
 AssignResult assignDepthFirst(PorytilesContext &ctx, CompilerMode compilerMode, AssignState &state,
                               std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
                               const std::vector<ColorSet> &unassigneds, const std::vector<ColorSet> &unassignedPrimers);
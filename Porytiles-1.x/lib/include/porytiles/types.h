@@ -3,6 +3,7 @@
 
 #include <algorithm>
 #include <array>
+#include <chrono>
 #include <compare>
 #include <cstdint>
 #include <filesystem>
@@ -10,6 +11,7 @@
 #include <png.hpp>
 #include <stdint.h>
 #include <string>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <vector>
@@ -546,28 +548,10 @@ struct NormalizedTile {
   bool vFlip;
 
   /*
-   * Metadata Fields:
-   * These are used by the various components to track metadata around the usage context of a NormalizedTile. Allows
-   * Porytiles to give much more detailed error messages.
+   * Unlike RGBATile, there are no metadata fields here. The compiler moves normalized tiles around a lot, and only needs
+   * the metadata for error messages and metatile attributes, so it stays with the RGBATile in the DecompiledTileset.
+   * Look it up there with the tile's DecompiledIndex.
    */
-  TileType type;
-
-  // raw tile index, used for FREESTANDING and ANIM types
-  std::size_t tileIndex;
-
-  // LAYERED specific metadata
-  TileLayer layer;
-  std::size_t metatileIndex;
-  Subtile subtile;
-
-  // ANIM specific metadata
-  std::string anim;
-
-  // PRIMER specific metadata
-  std::string primer;
-
-  // Metatile attributes for this tile
-  Attributes attributes;
 
   explicit NormalizedTile(RGBA32 transparency) : frames{}, palette{}, hFlip{}, vFlip{}
   {
@@ -576,18 +560,6 @@ struct NormalizedTile {
     frames.resize(1);
   }
 
-  void copyMetadataFrom(const RGBATile &tile)
-  {
-    this->type = tile.type;
-    this->tileIndex = tile.tileIndex;
-    this->layer = tile.layer;
-    this->metatileIndex = tile.metatileIndex;
-    this->subtile = tile.subtile;
-    this->anim = tile.anim;
-    this->primer = tile.primer;
-    this->attributes = tile.attributes;
-  }
-
   [[nodiscard]] bool transparent() const { return palette.size == 1; }
 
   void setPixel(std::size_t frame, std::size_t row, std::size_t col, uint8_t value)
@@ -640,7 +612,15 @@ enum class Subcommand { DECOMPILE_PRIMARY, DECOMPILE_SECONDARY, COMPILE_PRIMARY,
 
 enum class CompilerMode { PRIMARY, SECONDARY };
 
-enum class AssignAlgorithm { DFS, BFS };
+/*
+ * GREEDY and COMPONENTS are not searches, they only ever show up in `assign.cache'. They record that the greedy pre-pass
+ * or the split into independent components produced the cached palettes, so the next compile reruns that step rather
+ * than a search the palettes never came from.
+ */
+enum class AssignAlgorithm { DFS, BFS, BEAM, LOCAL, GREEDY, COMPONENTS };
+
+// How many states the beam search keeps at each depth unless told otherwise
+constexpr std::size_t DEFAULT_BEAM_WIDTH = 1'000;
 
 enum class DecompilerMode { PRIMARY, SECONDARY };
 
@@ -903,34 +883,63 @@ struct CompilerConfig {
   bool tripleLayer;
   bool cacheAssign;
   bool forceParamSearchMatrix;
+  // Try the greedy palette packing before searching, if it places every tile the search never runs
+  bool greedyAssign;
   bool providedAssignCacheOverride;
   bool providedPrimaryAssignCacheOverride;
   std::string defaultBehavior;
   std::string defaultEncounterType;
   std::string defaultTerrainType;
 
+  // Number of worker threads for the parallel parts of compilation, 0 means use every available hardware thread
+  std::size_t jobs;
+
+  // Wall time limit for each palette assignment in seconds, 0 means no limit
+  std::size_t assignTimeout;
+
+  // If not empty, write statistics for every palette assignment attempt to this path as JSON
+  std::string assignStatsPath;
+
   // Palette assignment algorithm configuration
   AssignAlgorithm primaryAssignAlgorithm;
   std::size_t primaryExploredNodeCutoff;
   std::size_t primaryBestBranches;
   bool primarySmartPrune;
+  std::size_t primaryBeamWidth;
+  std::uint64_t primaryAssignSeed;
+  // Colors of each hardware palette from the last successful assignment
+  std::vector<std::vector<BGR15>> primaryCachedSolution;
   bool readPrimaryAssignCache;
   AssignAlgorithm secondaryAssignAlgorithm;
   std::size_t secondaryExploredNodeCutoff;
   std::size_t secondaryBestBranches;
   bool secondarySmartPrune;
+  std::size_t secondaryBeamWidth;
+  std::uint64_t secondaryAssignSeed;
+  std::vector<std::vector<BGR15>> secondaryCachedSolution;
   bool readSecondaryAssignCache;
 
   CompilerConfig()
       : transparencyColor{RGBA_MAGENTA}, tripleLayer{true}, cacheAssign{true}, forceParamSearchMatrix{false},
-        providedAssignCacheOverride{false}, providedPrimaryAssignCacheOverride{false}, defaultBehavior{"0"},
-        defaultEncounterType{"0"}, defaultTerrainType{"0"}, primaryAssignAlgorithm{AssignAlgorithm::DFS},
-        primaryExploredNodeCutoff{2'000'000}, primaryBestBranches{SIZE_MAX}, primarySmartPrune{false},
-        readPrimaryAssignCache{false}, secondaryAssignAlgorithm{AssignAlgorithm::DFS},
-        secondaryExploredNodeCutoff{2'000'000}, secondaryBestBranches{SIZE_MAX}, secondarySmartPrune{false},
-        readSecondaryAssignCache{false}
+        greedyAssign{true}, providedAssignCacheOverride{false}, providedPrimaryAssignCacheOverride{false}, defaultBehavior{"0"},
+        defaultEncounterType{"0"}, defaultTerrainType{"0"}, jobs{0}, assignTimeout{0}, assignStatsPath{},
+        primaryAssignAlgorithm{AssignAlgorithm::DFS}, primaryExploredNodeCutoff{2'000'000},
+        primaryBestBranches{SIZE_MAX}, primarySmartPrune{false}, primaryBeamWidth{DEFAULT_BEAM_WIDTH},
+        primaryAssignSeed{0}, primaryCachedSolution{}, readPrimaryAssignCache{false},
+        secondaryAssignAlgorithm{AssignAlgorithm::DFS}, secondaryExploredNodeCutoff{2'000'000},
+        secondaryBestBranches{SIZE_MAX}, secondarySmartPrune{false}, secondaryBeamWidth{DEFAULT_BEAM_WIDTH},
+        secondaryAssignSeed{0}, secondaryCachedSolution{}, readSecondaryAssignCache{false}
   {
   }
+
+  [[nodiscard]] std::size_t effectiveJobs() const
+  {
+    if (jobs != 0) {
+      return jobs;
+    }
+    // hardware_concurrency may return 0 if it cannot tell, so always fall back to at least one job
+    return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+  }
 };
 
 struct DecompilerConfig {
@@ -939,13 +948,105 @@ struct DecompilerConfig {
   DecompilerConfig() : normalizeTransparency{true}, normalizeTransparencyColor{RGBA_MAGENTA} {}
 };
 
+/*
+ * What a palette assignment search saw while it ran. Searches only fill this in when `-assign-stats' is set, so the
+ * bookkeeping costs nothing otherwise. Depth is the number of ColorSets assigned so far. Not every algorithm fills in
+ * every field: the queues and the visited set are specific to breadth first and beam search.
+ */
+struct AssignStats {
+  std::size_t exploredNodes;
+  double seconds;
+  std::size_t maxDepth;
+  // How often the search hit a dead end at each depth and had to back out
+  std::vector<std::size_t> backtracksPerDepth;
+  // How many expanded nodes had each number of children we could branch into
+  std::vector<std::size_t> branchFactorHistogram;
+  std::size_t queueHighWater;
+  std::size_t lowPriorityQueueHighWater;
+  std::size_t visitedStates;
+  double visitedLoadFactor;
+
+  AssignStats()
+      : exploredNodes{0}, seconds{0}, maxDepth{0}, backtracksPerDepth{}, branchFactorHistogram{}, queueHighWater{0},
+        lowPriorityQueueHighWater{0}, visitedStates{0}, visitedLoadFactor{0}
+  {
+  }
+};
+
+/*
+ * One palette assignment attempt for the `-assign-stats' report: where its params came from, what they were, how it
+ * ended, and what the search saw along the way.
+ */
+struct AssignAttemptReport {
+  CompilerMode mode;
+  // One of `override', `cache', `incremental' or `matrix'
+  std::string source;
+  // Index into the param search matrix, only meaningful if source is `matrix'
+  std::size_t matrixEntry;
+  AssignAlgorithm assignAlgorithm;
+  std::size_t exploredNodeCutoff;
+  std::size_t bestBranches;
+  bool smartPrune;
+  std::size_t beamWidth;
+  std::uint64_t seed;
+  bool restarts;
+  std::string result;
+  // Whether the palettes from this attempt are the ones we went with
+  bool won;
+  AssignStats stats;
+};
+
+/*
+ * The RGBA color a BGR color was last seen as, and the tile pixel it came from. Normalization records one of these for
+ * every color of every tile, but only reads the tile back when `-Wcolor-precision-loss' fires. So instead of a full
+ * RGBATile copy, with its pixels and strings, this keeps the tile metadata getTilePrettyString needs, and the anim,
+ * frame and primer names as indexes into CompilerContext::provenanceNames.
+ */
+struct ColorProvenance {
+  RGBA32 rgba;
+  TileType type;
+  TileLayer layer;
+  Subtile subtile;
+  std::size_t tileIndex;
+  std::size_t metatileIndex;
+  std::uint32_t anim;
+  std::uint32_t frame;
+  std::uint32_t primer;
+  std::uint8_t row;
+  std::uint8_t col;
+
+  bool operator==(const ColorProvenance &other) const = default;
+};
+
 struct CompilerContext {
   std::unique_ptr<CompiledTileset> pairedPrimaryTileset;
   std::unique_ptr<CompiledTileset> resultTileset;
-  std::unordered_map<BGR15, std::tuple<RGBA32, RGBATile, std::size_t, std::size_t>> bgrToRgba;
+  std::unordered_map<BGR15, ColorProvenance> bgrToRgba;
+  // Names the ColorProvenance entries point at, index 0 is always the empty name
+  std::vector<std::string> provenanceNames;
+  std::unordered_map<std::string, std::uint32_t> provenanceNameIndexes;
   std::size_t exploredNodeCounter;
+  // Only filled in when `-assign-stats' is set
+  std::vector<AssignAttemptReport> assignReports;
+  // When `-assign-timeout' runs out for the whole compile, time_point::max() until the first assignment sets it
+  std::chrono::steady_clock::time_point assignDeadline;
+
+  CompilerContext()
+      : pairedPrimaryTileset{nullptr}, resultTileset{nullptr}, bgrToRgba{}, provenanceNames{""},
+        provenanceNameIndexes{{"", 0}}, exploredNodeCounter{}, assignReports{},
+        assignDeadline{std::chrono::steady_clock::time_point::max()}
+  {
+  }
+
+  // Record that `bgr' was last seen as `rgba' at the given pixel of `tile'
+  void recordColor(const BGR15 &bgr, const RGBA32 &rgba, const RGBATile &tile, std::size_t row, std::size_t col);
+
+  // Rebuild the color, tile and pixel of a recorded color, in the form warn_colorPrecisionLoss reports it
+  [[nodiscard]] std::tuple<RGBA32, RGBATile, std::size_t, std::size_t>
+  colorUse(const ColorProvenance &provenance) const;
 
-  CompilerContext() : pairedPrimaryTileset{nullptr}, resultTileset{nullptr}, bgrToRgba{}, exploredNodeCounter{} {}
+  // Index of `name' in provenanceNames, adding it if this is its first use
+  std::uint32_t provenanceName(const std::string &name);
 };
 
 struct DecompilerContext {
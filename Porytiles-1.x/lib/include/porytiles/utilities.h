@@ -2,7 +2,10 @@
 #define PORYTILES_UTILITIES_H
 
 #include <filesystem>
+#include <limits>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 
 #define FMT_HEADER_ONLY
@@ -18,7 +21,24 @@ template <typename T> T parseInteger(const char *integerString)
 {
   try {
     std::size_t pos;
-    T arg = std::stoi(integerString, &pos, 0);
+    T arg;
+    if constexpr (std::is_unsigned_v<T>) {
+      // stoi cannot hold every std::size_t or std::uint64_t value, so read unsigned types at full width
+      std::string_view digits{integerString};
+      std::size_t signPos = digits.find_first_not_of(" \t\n\v\f\r");
+      if (signPos != std::string_view::npos && digits[signPos] == '-') {
+        // stoull would wrap a negative value around to a huge one instead of failing
+        throw std::runtime_error{"negative value for unsigned integral: " + std::string{integerString}};
+      }
+      unsigned long long wide = std::stoull(integerString, &pos, 0);
+      if (wide > std::numeric_limits<T>::max()) {
+        throw std::runtime_error{"integral value out of range: " + std::string{integerString}};
+      }
+      arg = static_cast<T>(wide);
+    }
+    else {
+      arg = std::stoi(integerString, &pos, 0);
+    }
     if (std::string{integerString}.size() != pos) {
       // throw here so it catches below and prints an error message
       throw std::runtime_error{"invalid integral string: " + std::string{integerString}};
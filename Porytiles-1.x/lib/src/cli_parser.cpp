@@ -7,6 +7,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_set>
 
 #define FMT_HEADER_ONLY
@@ -205,6 +206,7 @@ OPTIONS
 {}
 {}
 {}
+{}
 {}
     Tileset Compilation Options
 {}
@@ -218,6 +220,11 @@ OPTIONS
 {}
 {}
 {}
+{}
+{}
+{}
+{}
+{}
 {}
     Fieldmap Override Options
 {}
@@ -235,11 +242,11 @@ OPTIONS
 )",
 COMPILE_PRIMARY_COMMAND, COMPILATION_INPUT_DIRECTORY_FORMAT,
 // Driver options
-OUTPUT_DESC, TILES_OUTPUT_PAL_DESC, DISABLE_METATILE_GENERATION_DESC, DISABLE_ATTRIBUTE_GENERATION_DESC,
+OUTPUT_DESC, TILES_OUTPUT_PAL_DESC, DISABLE_METATILE_GENERATION_DESC, DISABLE_ATTRIBUTE_GENERATION_DESC, JOBS_DESC,
 // Tileset compilation options
 TARGET_BASE_GAME_DESC, DUAL_LAYER_DESC, TRANSPARENCY_COLOR_DESC, DEFAULT_BEHAVIOR_DESC, DEFAULT_ENCOUNTER_TYPE_DESC, DEFAULT_TERRAIN_TYPE_DESC,
 // Palette assignment config options
-ASSIGN_ALGO_DESC, EXPLORE_CUTOFF_DESC, BEST_BRANCHES_DESC, DISABLE_ASSIGN_CACHING_DESC, FORCE_ASSIGN_PARAM_MATRIX_DESC,
+ASSIGN_ALGO_DESC, EXPLORE_CUTOFF_DESC, BEST_BRANCHES_DESC, BEAM_WIDTH_DESC, ASSIGN_SEED_DESC, DISABLE_ASSIGN_CACHING_DESC, FORCE_ASSIGN_PARAM_MATRIX_DESC, DISABLE_GREEDY_ASSIGN_DESC, ASSIGN_TIMEOUT_DESC, ASSIGN_STATS_DESC,
 // Fieldmap override options
 TILES_PRIMARY_OVERRIDE_DESC, TILES_TOTAL_OVERRIDE_DESC, METATILES_PRIMARY_OVERRIDE_DESC, METATILES_TOTAL_OVERRIDE_DESC, PALS_PRIMARY_OVERRIDE_DESC, PALS_TOTAL_OVERRIDE_DESC,
 // Warning options
@@ -285,6 +292,7 @@ OPTIONS
 {}
 {}
 {}
+{}
 {}
     Tileset Compilation Options
 {}
@@ -298,10 +306,17 @@ OPTIONS
 {}
 {}
 {}
+{}
+{}
+{}
+{}
+{}
 {}
     Primary Palette Assignment Config Options
 {}
 {}
+{}
+{}
 {}
     Fieldmap Override Options
 {}
@@ -319,13 +334,13 @@ OPTIONS
 )",
 COMPILE_SECONDARY_COMMAND, COMPILATION_INPUT_DIRECTORY_FORMAT,
 // Driver options
-OUTPUT_DESC, TILES_OUTPUT_PAL_DESC, DISABLE_METATILE_GENERATION_DESC, DISABLE_ATTRIBUTE_GENERATION_DESC,
+OUTPUT_DESC, TILES_OUTPUT_PAL_DESC, DISABLE_METATILE_GENERATION_DESC, DISABLE_ATTRIBUTE_GENERATION_DESC, JOBS_DESC,
 // Tileset compilation options
 TARGET_BASE_GAME_DESC, DUAL_LAYER_DESC, TRANSPARENCY_COLOR_DESC, DEFAULT_BEHAVIOR_DESC, DEFAULT_ENCOUNTER_TYPE_DESC, DEFAULT_TERRAIN_TYPE_DESC,
 // Palette assignment config options
-ASSIGN_ALGO_DESC, EXPLORE_CUTOFF_DESC, BEST_BRANCHES_DESC, DISABLE_ASSIGN_CACHING_DESC, FORCE_ASSIGN_PARAM_MATRIX_DESC,
+ASSIGN_ALGO_DESC, EXPLORE_CUTOFF_DESC, BEST_BRANCHES_DESC, BEAM_WIDTH_DESC, ASSIGN_SEED_DESC, DISABLE_ASSIGN_CACHING_DESC, FORCE_ASSIGN_PARAM_MATRIX_DESC, DISABLE_GREEDY_ASSIGN_DESC, ASSIGN_TIMEOUT_DESC, ASSIGN_STATS_DESC,
 // Primary palette assignment config options
-PRIMARY_ASSIGN_ALGO_DESC, PRIMARY_EXPLORE_CUTOFF_DESC, PRIMARY_BEST_BRANCHES_DESC,
+PRIMARY_ASSIGN_ALGO_DESC, PRIMARY_EXPLORE_CUTOFF_DESC, PRIMARY_BEST_BRANCHES_DESC, PRIMARY_BEAM_WIDTH_DESC, PRIMARY_ASSIGN_SEED_DESC,
 // Fieldmap override options
 TILES_PRIMARY_OVERRIDE_DESC, TILES_TOTAL_OVERRIDE_DESC, METATILES_PRIMARY_OVERRIDE_DESC, METATILES_TOTAL_OVERRIDE_DESC, PALS_PRIMARY_OVERRIDE_DESC, PALS_TOTAL_OVERRIDE_DESC,
 // Warning options
@@ -464,6 +479,7 @@ std::unordered_map<std::string, std::unordered_set<Subcommand>> supportedSubcomm
     {TILES_OUTPUT_PAL, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {DISABLE_METATILE_GENERATION, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {DISABLE_ATTRIBUTE_GENERATION, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
+    {JOBS, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {TARGET_BASE_GAME,
      {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY, Subcommand::DECOMPILE_PRIMARY,
       Subcommand::DECOMPILE_SECONDARY}},
@@ -477,11 +493,18 @@ std::unordered_map<std::string, std::unordered_set<Subcommand>> supportedSubcomm
     {ASSIGN_ALGO, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {EXPLORE_CUTOFF, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {BEST_BRANCHES, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
+    {BEAM_WIDTH, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
+    {ASSIGN_SEED, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {DISABLE_ASSIGN_CACHING, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {FORCE_ASSIGN_PARAM_MATRIX, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
+    {DISABLE_GREEDY_ASSIGN, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
+    {ASSIGN_TIMEOUT, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
+    {ASSIGN_STATS, {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY}},
     {PRIMARY_ASSIGN_ALGO, {Subcommand::COMPILE_SECONDARY}},
     {PRIMARY_EXPLORE_CUTOFF, {Subcommand::COMPILE_SECONDARY}},
     {PRIMARY_BEST_BRANCHES, {Subcommand::COMPILE_SECONDARY}},
+    {PRIMARY_BEAM_WIDTH, {Subcommand::COMPILE_SECONDARY}},
+    {PRIMARY_ASSIGN_SEED, {Subcommand::COMPILE_SECONDARY}},
     {TILES_PRIMARY_OVERRIDE,
      {Subcommand::COMPILE_PRIMARY, Subcommand::COMPILE_SECONDARY, Subcommand::DECOMPILE_PRIMARY,
       Subcommand::DECOMPILE_SECONDARY}},
@@ -554,6 +577,18 @@ void parseOptions(PorytilesContext &ctx, int argc, char *const *argv)
   }
 }
 
+/*
+ * Every job gets its own thread and its own share of the assignment search state, so an absurd job count only burns
+ * memory and overflows the per-job task math. Allow some oversubscription past the hardware threads, but no more.
+ */
+static constexpr std::size_t MAX_JOBS_PER_HARDWARE_THREAD = 16;
+
+static std::size_t maxJobs()
+{
+  // hardware_concurrency may return 0 if it cannot tell, so count at least one hardware thread
+  return MAX_JOBS_PER_HARDWARE_THREAD * std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+}
+
 template <typename T>
 static T parseIntegralOption(const ErrorsAndWarnings &err, const std::string &optionName, const char *optarg)
 {
@@ -647,6 +682,12 @@ static AssignAlgorithm parseAssignAlgorithm(const ErrorsAndWarnings &err, const
   else if (optargString == assignAlgorithmString(AssignAlgorithm::BFS)) {
     return AssignAlgorithm::BFS;
   }
+  else if (optargString == assignAlgorithmString(AssignAlgorithm::BEAM)) {
+    return AssignAlgorithm::BEAM;
+  }
+  else if (optargString == assignAlgorithmString(AssignAlgorithm::LOCAL)) {
+    return AssignAlgorithm::LOCAL;
+  }
   else {
     fatalerror(err, fmt::format("invalid argument `{}' for option `{}'", fmt::styled(optargString, fmt::emphasis::bold),
                                 fmt::styled(optionName, fmt::emphasis::bold)));
@@ -750,6 +791,7 @@ static void parseSubcommandOptions(PorytilesContext &ctx, int argc, char *const
       {PRESERVE_TRANSPARENCY.c_str(), no_argument, nullptr, PRESERVE_TRANSPARENCY_VAL},
       {DISABLE_METATILE_GENERATION.c_str(), no_argument, nullptr, DISABLE_METATILE_GENERATION_VAL},
       {DISABLE_ATTRIBUTE_GENERATION.c_str(), no_argument, nullptr, DISABLE_ATTRIBUTE_GENERATION_VAL},
+      {JOBS.c_str(), required_argument, nullptr, JOBS_VAL},
 
       // Tileset generation options
       {TARGET_BASE_GAME.c_str(), required_argument, nullptr, TARGET_BASE_GAME_VAL},
@@ -763,11 +805,18 @@ static void parseSubcommandOptions(PorytilesContext &ctx, int argc, char *const
       {EXPLORE_CUTOFF.c_str(), required_argument, nullptr, EXPLORE_CUTOFF_VAL},
       {ASSIGN_ALGO.c_str(), required_argument, nullptr, ASSIGN_ALGO_VAL},
       {BEST_BRANCHES.c_str(), required_argument, nullptr, BEST_BRANCHES_VAL},
+      {BEAM_WIDTH.c_str(), required_argument, nullptr, BEAM_WIDTH_VAL},
+      {ASSIGN_SEED.c_str(), required_argument, nullptr, ASSIGN_SEED_VAL},
       {DISABLE_ASSIGN_CACHING.c_str(), no_argument, nullptr, DISABLE_ASSIGN_CACHING_VAL},
       {FORCE_ASSIGN_PARAM_MATRIX.c_str(), no_argument, nullptr, FORCE_ASSIGN_PARAM_MATRIX_VAL},
+      {DISABLE_GREEDY_ASSIGN.c_str(), no_argument, nullptr, DISABLE_GREEDY_ASSIGN_VAL},
+      {ASSIGN_TIMEOUT.c_str(), required_argument, nullptr, ASSIGN_TIMEOUT_VAL},
+      {ASSIGN_STATS.c_str(), required_argument, nullptr, ASSIGN_STATS_VAL},
       {PRIMARY_EXPLORE_CUTOFF.c_str(), required_argument, nullptr, PRIMARY_EXPLORE_CUTOFF_VAL},
       {PRIMARY_ASSIGN_ALGO.c_str(), required_argument, nullptr, PRIMARY_ASSIGN_ALGO_VAL},
       {PRIMARY_BEST_BRANCHES.c_str(), required_argument, nullptr, PRIMARY_BEST_BRANCHES_VAL},
+      {PRIMARY_BEAM_WIDTH.c_str(), required_argument, nullptr, PRIMARY_BEAM_WIDTH_VAL},
+      {PRIMARY_ASSIGN_SEED.c_str(), required_argument, nullptr, PRIMARY_ASSIGN_SEED_VAL},
 
       // Fieldmap override options
       {TILES_PRIMARY_OVERRIDE.c_str(), required_argument, nullptr, TILES_PRIMARY_OVERRIDE_VAL},
@@ -895,6 +944,7 @@ static void parseSubcommandOptions(PorytilesContext &ctx, int argc, char *const
   std::size_t palettesTotalOverride = 0;
 
   std::size_t exploreCutoff;
+  std::size_t beamWidth;
 
   while (true) {
     const auto opt = getopt_long_only(argc, argv, shortOptions.c_str(), longOptions, nullptr);
@@ -921,6 +971,17 @@ static void parseSubcommandOptions(PorytilesContext &ctx, int argc, char *const
       validateSubcommandContext(ctx, DISABLE_ATTRIBUTE_GENERATION);
       ctx.output.disableAttributeGeneration = true;
       break;
+    case JOBS_VAL:
+      validateSubcommandContext(ctx, JOBS);
+      ctx.compilerConfig.jobs = parseIntegralOption<std::size_t>(ctx.err, JOBS, optarg);
+      if (ctx.compilerConfig.jobs == 0) {
+        fatalerror(ctx.err, fmt::format("option `{}' argument cannot be 0", fmt::styled(JOBS, fmt::emphasis::bold)));
+      }
+      if (ctx.compilerConfig.jobs > maxJobs()) {
+        fatalerror(ctx.err, fmt::format("option `{}' argument cannot be more than {}, {} per hardware thread",
+                                        fmt::styled(JOBS, fmt::emphasis::bold), maxJobs(), MAX_JOBS_PER_HARDWARE_THREAD));
+      }
+      break;
 
     // Tileset (de)compilation options
     case TARGET_BASE_GAME_VAL:
@@ -1024,6 +1085,31 @@ static void parseSubcommandOptions(PorytilesContext &ctx, int argc, char *const
         }
       }
       break;
+    case BEAM_WIDTH_VAL:
+      validateSubcommandContext(ctx, BEAM_WIDTH);
+      ctx.compilerConfig.providedAssignCacheOverride = true;
+      beamWidth = parseIntegralOption<std::size_t>(ctx.err, BEAM_WIDTH, optarg);
+      if (beamWidth == 0) {
+        fatalerror(ctx.err,
+                   fmt::format("option `{}' argument cannot be 0", fmt::styled(BEAM_WIDTH, fmt::emphasis::bold)));
+      }
+      if (ctx.subcommand == Subcommand::COMPILE_PRIMARY) {
+        ctx.compilerConfig.primaryBeamWidth = beamWidth;
+      }
+      else if (ctx.subcommand == Subcommand::COMPILE_SECONDARY) {
+        ctx.compilerConfig.secondaryBeamWidth = beamWidth;
+      }
+      break;
+    case ASSIGN_SEED_VAL:
+      validateSubcommandContext(ctx, ASSIGN_SEED);
+      ctx.compilerConfig.providedAssignCacheOverride = true;
+      if (ctx.subcommand == Subcommand::COMPILE_PRIMARY) {
+        ctx.compilerConfig.primaryAssignSeed = parseIntegralOption<std::uint64_t>(ctx.err, ASSIGN_SEED, optarg);
+      }
+      else if (ctx.subcommand == Subcommand::COMPILE_SECONDARY) {
+        ctx.compilerConfig.secondaryAssignSeed = parseIntegralOption<std::uint64_t>(ctx.err, ASSIGN_SEED, optarg);
+      }
+      break;
     case DISABLE_ASSIGN_CACHING_VAL:
       validateSubcommandContext(ctx, DISABLE_ASSIGN_CACHING);
       ctx.compilerConfig.cacheAssign = false;
@@ -1032,6 +1118,18 @@ static void parseSubcommandOptions(PorytilesContext &ctx, int argc, char *const
       validateSubcommandContext(ctx, FORCE_ASSIGN_PARAM_MATRIX);
       ctx.compilerConfig.forceParamSearchMatrix = true;
       break;
+    case DISABLE_GREEDY_ASSIGN_VAL:
+      validateSubcommandContext(ctx, DISABLE_GREEDY_ASSIGN);
+      ctx.compilerConfig.greedyAssign = false;
+      break;
+    case ASSIGN_TIMEOUT_VAL:
+      validateSubcommandContext(ctx, ASSIGN_TIMEOUT);
+      ctx.compilerConfig.assignTimeout = parseIntegralOption<std::size_t>(ctx.err, ASSIGN_TIMEOUT, optarg);
+      break;
+    case ASSIGN_STATS_VAL:
+      validateSubcommandContext(ctx, ASSIGN_STATS);
+      ctx.compilerConfig.assignStatsPath = optarg;
+      break;
     case PRIMARY_EXPLORE_CUTOFF_VAL:
       validateSubcommandContext(ctx, PRIMARY_EXPLORE_CUTOFF);
       ctx.compilerConfig.providedPrimaryAssignCacheOverride = true;
@@ -1068,6 +1166,26 @@ static void parseSubcommandOptions(PorytilesContext &ctx, int argc, char *const
         }
       }
       break;
+    case PRIMARY_BEAM_WIDTH_VAL:
+      validateSubcommandContext(ctx, PRIMARY_BEAM_WIDTH);
+      ctx.compilerConfig.providedPrimaryAssignCacheOverride = true;
+      beamWidth = parseIntegralOption<std::size_t>(ctx.err, PRIMARY_BEAM_WIDTH, optarg);
+      if (beamWidth == 0) {
+        fatalerror(ctx.err, fmt::format("option `{}' argument cannot be 0",
+                                        fmt::styled(PRIMARY_BEAM_WIDTH, fmt::emphasis::bold)));
+      }
+      if (ctx.subcommand == Subcommand::COMPILE_SECONDARY) {
+        ctx.compilerConfig.primaryBeamWidth = beamWidth;
+      }
+      break;
+    case PRIMARY_ASSIGN_SEED_VAL:
+      validateSubcommandContext(ctx, PRIMARY_ASSIGN_SEED);
+      ctx.compilerConfig.providedPrimaryAssignCacheOverride = true;
+      if (ctx.subcommand == Subcommand::COMPILE_SECONDARY) {
+        ctx.compilerConfig.primaryAssignSeed =
+            parseIntegralOption<std::uint64_t>(ctx.err, PRIMARY_ASSIGN_SEED, optarg);
+      }
+      break;
 
     // Fieldmap override options
     case TILES_PRIMARY_OVERRIDE_VAL:
@@ -1847,4 +1965,80 @@ TEST_CASE("parseCompile should work as expected with all command lines")
     CHECK(ctx.err.attributeFormatMismatch == porytiles::WarningMode::OFF);
     CHECK(ctx.err.missingAttributesCsv == porytiles::WarningMode::OFF);
   }
+
+  SUBCASE("-assign-seed should take seeds that do not fit in an int")
+  {
+    porytiles::PorytilesContext ctx{};
+    ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+
+    optind = 1;
+
+    char bufCmd[64];
+    strcpy(bufCmd, "compile-primary");
+
+    char bufSeed[64];
+    strcpy(bufSeed, "-assign-seed=18364758544493064720");
+
+    char bufPath[64];
+    strcpy(bufPath, "/home/foo/pokeemerald");
+
+    char bufHeader[64];
+    strcpy(bufHeader, "/home/foo/metatile_behaviors.h");
+
+    char *const argv[] = {bufCmd, bufSeed, bufPath, bufHeader};
+    porytiles::parseSubcommandOptions(ctx, 4, argv);
+
+    CHECK(ctx.compilerConfig.providedAssignCacheOverride);
+    CHECK(ctx.compilerConfig.primaryAssignSeed == 0xfedcba9876543210);
+  }
+
+  SUBCASE("-assign-seed should reject negative seeds instead of wrapping them")
+  {
+    porytiles::PorytilesContext ctx{};
+    ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+    ctx.err.printErrors = false;
+
+    optind = 1;
+
+    char bufCmd[64];
+    strcpy(bufCmd, "compile-primary");
+
+    char bufSeed[64];
+    strcpy(bufSeed, "-assign-seed=-1");
+
+    char bufPath[64];
+    strcpy(bufPath, "/home/foo/pokeemerald");
+
+    char bufHeader[64];
+    strcpy(bufHeader, "/home/foo/metatile_behaviors.h");
+
+    char *const argv[] = {bufCmd, bufSeed, bufPath, bufHeader};
+    CHECK_THROWS_AS(porytiles::parseSubcommandOptions(ctx, 4, argv), porytiles::PorytilesException);
+  }
+
+  SUBCASE("-jobs should reject negative and oversized job counts")
+  {
+    for (const std::string &jobs : {std::string{"-1"}, std::string{"-0"}, std::to_string(SIZE_MAX)}) {
+      porytiles::PorytilesContext ctx{};
+      ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+      ctx.err.printErrors = false;
+
+      optind = 1;
+
+      char bufCmd[64];
+      strcpy(bufCmd, "compile-primary");
+
+      char bufJobs[64];
+      strcpy(bufJobs, ("-jobs=" + jobs).c_str());
+
+      char bufPath[64];
+      strcpy(bufPath, "/home/foo/pokeemerald");
+
+      char bufHeader[64];
+      strcpy(bufHeader, "/home/foo/metatile_behaviors.h");
+
+      char *const argv[] = {bufCmd, bufJobs, bufPath, bufHeader};
+      CHECK_THROWS_AS(porytiles::parseSubcommandOptions(ctx, 4, argv), porytiles::PorytilesException);
+    }
+  }
 }
@@ -0,0 +1,214 @@
+#include "color_set.h"
+
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
+#include <array>
+#include <bitset>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <doctest.h>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace porytiles {
+
+namespace detail {
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+static bool cpuHasPopcount()
+{
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("popcnt");
+}
+
+__attribute__((target("popcnt"))) std::size_t popcountWordsHardware(const std::uint64_t *words, std::size_t wordCount)
+{
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < wordCount; i++) {
+    total += __builtin_popcountll(words[i]);
+  }
+  return total;
+}
+
+#elif defined(_MSC_VER) && defined(_M_X64)
+
+static bool cpuHasPopcount()
+{
+  // CPUID leaf 1 reports POPCNT in bit 23 of ECX
+  int info[4];
+  __cpuid(info, 1);
+  return (info[2] & (1 << 23)) != 0;
+}
+
+std::size_t popcountWordsHardware(const std::uint64_t *words, std::size_t wordCount)
+{
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < wordCount; i++) {
+    total += __popcnt64(words[i]);
+  }
+  return total;
+}
+
+#else
+
+// No runtime detection here, either std::popcount is already native or we stick with the portable version
+static bool cpuHasPopcount() { return false; }
+
+std::size_t popcountWordsHardware(const std::uint64_t *words, std::size_t wordCount)
+{
+  std::size_t total = 0;
+  for (std::size_t i = 0; i < wordCount; i++) {
+    total += popcountWordPortable(words[i]);
+  }
+  return total;
+}
+
+#endif
+
+const bool hasHardwarePopcount = cpuHasPopcount();
+
+} // namespace detail
+
+} // namespace porytiles
+
+// --------------------
+// |    TEST CASES    |
+// --------------------
+
+TEST_CASE("ColorBitSet should count the same with and without hardware popcount")
+{
+  std::mt19937_64 rng{42};
+  for (std::size_t trial = 0; trial < 1000; trial++) {
+    std::array<std::uint64_t, 4> words{rng(), rng(), rng(), rng()};
+    std::size_t expected = 0;
+    for (std::uint64_t word : words) {
+      expected += std::bitset<64>{word}.count();
+    }
+    std::size_t portable = 0;
+    for (std::uint64_t word : words) {
+      portable += porytiles::detail::popcountWordPortable(word);
+    }
+    CHECK(portable == expected);
+    CHECK(porytiles::detail::popcountWords(words) == expected);
+    if (porytiles::detail::hasHardwarePopcount) {
+      CHECK(porytiles::detail::popcountWordsHardware(words.data(), words.size()) == expected);
+    }
+  }
+}
+
+TEST_CASE("ColorBitSet should behave like a std::bitset of the same size")
+{
+  constexpr std::size_t BITS = 240;
+  std::mt19937 rng{1234};
+  std::uniform_int_distribution<std::size_t> bitDist{0, BITS - 1};
+  auto randomPair = [&]() {
+    porytiles::ColorBitSet<BITS> colors{};
+    std::bitset<BITS> reference{};
+    for (std::size_t i = 0; i < 20; i++) {
+      std::size_t bit = bitDist(rng);
+      colors.set(bit);
+      reference.set(bit);
+    }
+    return std::pair{colors, reference};
+  };
+  auto matches = [](const porytiles::ColorBitSet<BITS> &colors, const std::bitset<BITS> &reference) {
+    return colors.to_string() == reference.to_string();
+  };
+
+  for (std::size_t trial = 0; trial < 200; trial++) {
+    auto [a, refA] = randomPair();
+    auto [b, refB] = randomPair();
+    std::size_t shift = bitDist(rng);
+
+    CHECK(matches(a & b, refA & refB));
+    CHECK(matches(a | b, refA | refB));
+    CHECK(matches(a ^ b, refA ^ refB));
+    CHECK(matches(~a, ~refA));
+    CHECK(matches(a << shift, refA << shift));
+    CHECK(matches(a >> shift, refA >> shift));
+    CHECK(a.count() == refA.count());
+    CHECK((~a).count() == (~refA).count());
+    CHECK(a.countAnd(b) == (refA & refB).count());
+    CHECK(a.countOr(b) == (refA | refB).count());
+    CHECK(a.intersects(b) == (refA & refB).any());
+    CHECK(a.isSubsetOf(b) == (refA & ~refB).none());
+    CHECK((a & b).isSubsetOf(a));
+    CHECK(a.isSubsetOf(a | b));
+    CHECK(((a >> 64) & porytiles::ColorBitSet<BITS>{~0ULL}).to_ullong() ==
+          ((refA >> 64) & std::bitset<BITS>{~0ULL}).to_ullong());
+  }
+}
+
+TEST_CASE("ColorBitSet should keep bits past its size cleared")
+{
+  porytiles::ColorBitSet<240> colors{};
+  CHECK(colors.none());
+  CHECK((~colors).count() == 240);
+  CHECK((~colors).all());
+  CHECK((~colors).word(3) == (std::uint64_t{1} << 48) - 1);
+  CHECK((~colors << 10).count() == 230);
+  CHECK(colors.set().count() == 240);
+  CHECK(colors.reset().none());
+  CHECK_THROWS_AS(colors.set(240), std::out_of_range);
+  CHECK_THROWS_AS(static_cast<void>(colors.test(240)), std::out_of_range);
+  CHECK_THROWS_AS(static_cast<void>((~colors).to_ullong()), std::overflow_error);
+}
+
+TEST_CASE("benchmark ColorBitSet against std::bitset on the palette assignment fit checks" * doctest::skip())
+{
+  constexpr std::size_t BITS = 240;
+  constexpr std::size_t SET_COUNT = 4096;
+  constexpr std::size_t ROUNDS = 2000;
+  std::mt19937 rng{1234};
+  std::uniform_int_distribution<std::size_t> bitDist{0, BITS - 1};
+  std::uniform_int_distribution<std::size_t> sizeDist{1, 15};
+  std::vector<porytiles::ColorBitSet<BITS>> colorSets{};
+  std::vector<std::bitset<BITS>> bitsets{};
+  for (std::size_t i = 0; i < SET_COUNT; i++) {
+    porytiles::ColorBitSet<BITS> colors{};
+    std::bitset<BITS> bitset{};
+    for (std::size_t size = sizeDist(rng); size > 0; size--) {
+      std::size_t bit = bitDist(rng);
+      colors.set(bit);
+      bitset.set(bit);
+    }
+    colorSets.push_back(colors);
+    bitsets.push_back(bitset);
+  }
+
+  // The same three checks each search node makes against every palette: intersection size, fit and coverage
+  auto run = [&](const auto &sets, auto &&checks) {
+    std::size_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t round = 0; round < ROUNDS; round++) {
+      const auto &toAssign = sets[round % SET_COUNT];
+      for (const auto &palette : sets) {
+        checksum += checks(palette, toAssign);
+      }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return std::pair{checksum, elapsed.count()};
+  };
+  auto [bitsetChecksum, bitsetSeconds] = run(bitsets, [](const auto &palette, const auto &toAssign) {
+    return (palette & toAssign).count() + ((palette | toAssign).count() <= 15) + (toAssign & ~palette).none();
+  });
+  auto [colorSetChecksum, colorSetSeconds] = run(colorSets, [](const auto &palette, const auto &toAssign) {
+    return palette.countAnd(toAssign) + (palette.countOr(toAssign) <= 15) + toAssign.isSubsetOf(palette);
+  });
+  CHECK(bitsetChecksum == colorSetChecksum);
+
+  double checks = static_cast<double>(ROUNDS * SET_COUNT);
+  MESSAGE(fmt::format("hardware popcount: {}", porytiles::detail::hasHardwarePopcount));
+  MESSAGE(fmt::format("std::bitset<{}>: {:.3f}s, {:.1f} ns/check", BITS, bitsetSeconds, bitsetSeconds * 1e9 / checks));
+  MESSAGE(fmt::format("ColorBitSet<{}>: {:.3f}s, {:.1f} ns/check", BITS, colorSetSeconds,
+                      colorSetSeconds * 1e9 / checks));
+}
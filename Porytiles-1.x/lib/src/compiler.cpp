@@ -1,13 +1,22 @@
 #include "compiler.h"
 
+#define FMT_HEADER_ONLY
+#include <fmt/format.h>
+
 #include <algorithm>
+#include <atomic>
 #include <bitset>
+#include <chrono>
 #include <deque>
 #include <doctest.h>
+#include <exception>
 #include <filesystem>
 #include <memory>
+#include <mutex>
 #include <png.hpp>
+#include <span>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
 #include <unordered_set>
@@ -24,131 +33,361 @@
 #include "types.h"
 
 namespace porytiles {
-static std::size_t insertRGBA(PorytilesContext &ctx, CompilerMode compilerMode, const RGBATile &rgbaFrame,
-                              const RGBA32 &transparencyColor, NormalizedPalette &palette, const RGBA32 &rgba,
-                              std::size_t row, std::size_t col, bool errWarn)
+static void logNormalizedTile(PorytilesContext &ctx, const RGBATile &rgbaFrame, const NormalizedTile &normalizedTile)
 {
-  auto transparencyBgr = rgbaToBgr(transparencyColor);
-  if (rgba != transparencyColor && rgbaToBgr(rgba) == transparencyBgr && errWarn) {
-    /*
-     * If we hit this case, it's almost certainly a user mistake so let's push an error. We would prefer to err on the
-     * side of forcing the user to be explicit, especially when it comes to transparency handling.
-     */
-    warn_nonTransparentRgbaCollapsedToTransparentBgr(ctx.err, compilerMode, rgbaFrame, row, col, rgba,
-                                                     transparencyColor);
+  if (rgbaFrame.type != TileType::LAYERED) {
+    return;
   }
-  /*
-   * Insert an rgba32 color into a normalized palette. The color will be converted to bgr15 format in the process,
-   * and possibly deduped (depending on user settings). Transparent alpha pixels will be treated as transparent, as
-   * will pixels that are of transparent color (again, set by the user but default to magenta). Fails if a tile
-   * contains too many unique colors or if an invalid alpha value is detected.
-   */
-  if (rgba.alpha == ALPHA_TRANSPARENT || rgba == transparencyColor) {
-    return 0;
+  if (normalizedTile.transparent()) {
+    pt_logln(ctx, stderr, "{}:{}:{} = transparent", layerString(rgbaFrame.layer), rgbaFrame.metatileIndex,
+             subtileString(rgbaFrame.subtile));
   }
-  else if (rgba.alpha == ALPHA_OPAQUE) {
-    auto bgr = rgbaToBgr(rgba);
+  else {
+    pt_logln(ctx, stderr, "{}:{}:{} = [hFlip: {}, vFlip: {}]", layerString(rgbaFrame.layer), rgbaFrame.metatileIndex,
+             subtileString(rgbaFrame.subtile), normalizedTile.hFlip, normalizedTile.vFlip);
+  }
+}
 
-    if (ctx.compilerContext.bgrToRgba.contains(bgr) && std::get<0>(ctx.compilerContext.bgrToRgba.at(bgr)) != rgba) {
-      /*
-       * We lost color precision here, so let's warn the user that two distinct RGBA colors they used
-       * in the master sheet are going to collapse to one BGR color on the GBA.
-       */
-      if (errWarn) {
-        warn_colorPrecisionLoss(ctx.err, compilerMode, rgbaFrame, row, col, bgr, rgba,
-                                ctx.compilerContext.bgrToRgba.at(bgr));
+/*
+ * What normalize tracks for each BGR color of a tile: the RGBA color, frame and pixel that recorded it last, and its
+ * index in the unflipped palette.
+ */
+struct NormalizeColor {
+  BGR15 bgr;
+  RGBA32 rgba;
+  std::size_t frame;
+  std::size_t row;
+  std::size_t col;
+  std::uint8_t index;
+};
+
+enum class NormalizeDiagnosticKind {
+  // A non-transparent color that turns into the transparency color as BGR
+  TRANSPARENCY_COLLAPSE,
+  // The first pixel of a color, warns if an earlier tile used a different RGBA color for the same BGR color
+  FIRST_USE,
+  // Two RGBA colors of this tile that collapse to one BGR color
+  PRECISION_LOSS,
+  TOO_MANY_COLORS,
+  INVALID_ALPHA
+};
+
+/*
+ * A warning or error normalize found at one pixel. Which of them fire only depends on the tile itself, except for
+ * FIRST_USE, which has to be checked against the colors of the tiles recorded before this one.
+ */
+struct NormalizeDiagnostic {
+  NormalizeDiagnosticKind kind;
+  std::size_t frame;
+  std::size_t row;
+  std::size_t col;
+  RGBA32 rgba;
+  // For PRECISION_LOSS, the pixel that used the other RGBA color last
+  std::size_t previousFrame;
+  std::size_t previousRow;
+  std::size_t previousCol;
+  RGBA32 previousRgba;
+};
+
+/*
+ * Everything normalizing a tile produces. The normal form, the diagnostics in pixel order and the color provenance all
+ * depend on the tile's pixels alone, so this part can run on any thread. Only recordNormalization touches the context,
+ * and it runs in input order, which keeps warnings and bgrToRgba the same as a serial build.
+ */
+struct TileNormalization {
+  NormalizedTile normalizedTile;
+  std::vector<NormalizeDiagnostic> diagnostics;
+  std::vector<NormalizeColor> colors;
+};
+
+/*
+ * Read `source' through the given flips, numbering its colors in order of first appearance. `labels' maps the source
+ * indexes to the new ones and carries over between calls, so the frames of a tile share one numbering.
+ */
+static NormalizedPixels relabelFlipped(const NormalizedPixels &source, bool hFlip, bool vFlip,
+                                       std::array<std::uint8_t, PAL_SIZE> &labels, std::uint8_t &labelCount)
+{
+  NormalizedPixels flipped{};
+  for (std::size_t row = 0; row < TILE_SIDE_LENGTH_PIX; row++) {
+    std::size_t sourceRow = vFlip ? TILE_SIDE_LENGTH_PIX - 1 - row : row;
+    for (std::size_t col = 0; col < TILE_SIDE_LENGTH_PIX; col++) {
+      std::size_t sourceCol = hFlip ? TILE_SIDE_LENGTH_PIX - 1 - col : col;
+      std::uint8_t index = source.colorIndexes[sourceRow * TILE_SIDE_LENGTH_PIX + sourceCol];
+      if (labels[index] == INVALID_INDEX_PIXEL_VALUE) {
+        labels[index] = labelCount++;
       }
-      ctx.compilerContext.bgrToRgba.at(bgr) =
-          std::tuple<RGBA32, RGBATile, std::size_t, std::size_t>{rgba, rgbaFrame, row, col};
+      flipped.colorIndexes[row * TILE_SIDE_LENGTH_PIX + col] = labels[index];
     }
-    ctx.compilerContext.bgrToRgba.insert_or_assign(
-        bgr, std::tuple<RGBA32, RGBATile, std::size_t, std::size_t>{rgba, rgbaFrame, row, col});
+  }
+  return flipped;
+}
 
-    auto itrAtBgr = std::find(std::begin(palette.colors) + 1, std::begin(palette.colors) + palette.size, bgr);
-    auto bgrPosInPalette = itrAtBgr - std::begin(palette.colors);
-    if (bgrPosInPalette == palette.size) {
-      // palette size will grow as we add to it
-      if (palette.size == PAL_SIZE) {
-        if (errWarn) {
-          error_tooManyUniqueColorsInTile(ctx.err, rgbaFrame, row, col);
+static TileNormalization normalizeTile(const RGBA32 &transparencyColor, std::span<const RGBATile> rgbaFrames)
+{
+  /*
+   * Normalize the given tile by checking each of the 4 possible flip states, and choosing the one that comes first in
+   * "lexicographic" order, where this order is determined by the std::array spaceship operator.
+   *
+   * This gives the same result as building a candidate tile for each flip and taking the smallest, like the reference
+   * implementation in the tests does, with the same warnings and errors. But it converts and looks up each pixel only
+   * once. Every candidate numbers its colors in order of first appearance, and the unflipped indexes already tell the
+   * colors apart, so the flipped candidates are relabelings of the unflipped one.
+   */
+  const BGR15 transparencyBgr = rgbaToBgr(transparencyColor);
+  TileNormalization normalization{NormalizedTile{transparencyColor}, {}, {}};
+  NormalizedTile &noFlipsTile = normalization.normalizedTile;
+  noFlipsTile.frames.resize(rgbaFrames.size());
+  std::vector<NormalizeColor> &colors = normalization.colors;
+  auto diagnose = [&normalization](NormalizeDiagnosticKind kind, std::size_t frame, std::size_t row, std::size_t col,
+                                   const RGBA32 &rgba) {
+    normalization.diagnostics.push_back(NormalizeDiagnostic{kind, frame, row, col, rgba, 0, 0, 0, RGBA32{}});
+  };
+  bool invalidPixels = false;
+
+  for (std::size_t frame = 0; frame < rgbaFrames.size(); frame++) {
+    const RGBATile &rgbaFrame = rgbaFrames[frame];
+    for (std::size_t row = 0; row < TILE_SIDE_LENGTH_PIX; row++) {
+      for (std::size_t col = 0; col < TILE_SIDE_LENGTH_PIX; col++) {
+        const RGBA32 &rgba = rgbaFrame.pixels[row * TILE_SIDE_LENGTH_PIX + col];
+        BGR15 bgr = rgbaToBgr(rgba);
+        if (rgba != transparencyColor && bgr == transparencyBgr) {
+          diagnose(NormalizeDiagnosticKind::TRANSPARENCY_COLLAPSE, frame, row, col, rgba);
         }
-        return INVALID_INDEX_PIXEL_VALUE;
+
+        std::uint8_t index = 0;
+        if (rgba.alpha == ALPHA_TRANSPARENT || rgba == transparencyColor) {
+          index = 0;
+        }
+        else if (rgba.alpha == ALPHA_OPAQUE) {
+          auto color = std::find_if(std::begin(colors), std::end(colors),
+                                    [&bgr](const auto &tracked) { return tracked.bgr == bgr; });
+          if (color == std::end(colors)) {
+            diagnose(NormalizeDiagnosticKind::FIRST_USE, frame, row, col, rgba);
+            std::uint8_t newIndex = INVALID_INDEX_PIXEL_VALUE;
+            if (noFlipsTile.palette.size < static_cast<int>(PAL_SIZE)) {
+              newIndex = static_cast<std::uint8_t>(noFlipsTile.palette.size);
+              noFlipsTile.palette.colors.at(noFlipsTile.palette.size++) = bgr;
+            }
+            color = colors.insert(std::end(colors), NormalizeColor{bgr, rgba, frame, row, col, newIndex});
+          }
+          else if (color->rgba != rgba) {
+            normalization.diagnostics.push_back(NormalizeDiagnostic{NormalizeDiagnosticKind::PRECISION_LOSS, frame,
+                                                                    row, col, rgba, color->frame, color->row,
+                                                                    color->col, color->rgba});
+          }
+          color->rgba = rgba;
+          color->frame = frame;
+          color->row = row;
+          color->col = col;
+          index = color->index;
+          if (index == INVALID_INDEX_PIXEL_VALUE) {
+            diagnose(NormalizeDiagnosticKind::TOO_MANY_COLORS, frame, row, col, rgba);
+          }
+        }
+        else {
+          diagnose(NormalizeDiagnosticKind::INVALID_ALPHA, frame, row, col, rgba);
+          index = INVALID_INDEX_PIXEL_VALUE;
+        }
+        invalidPixels = invalidPixels || index == INVALID_INDEX_PIXEL_VALUE;
+        noFlipsTile.frames.at(frame).colorIndexes[row * TILE_SIDE_LENGTH_PIX + col] = index;
       }
-      palette.colors.at(palette.size++) = bgr;
     }
-    return bgrPosInPalette;
   }
-  else {
-    if (errWarn) {
-      error_invalidAlphaValue(ctx.err, rgbaFrame, rgba.alpha, row, col);
-    }
-    return INVALID_INDEX_PIXEL_VALUE;
+
+  // Short-circuit because transparent tiles are common in metatiles and trivially in normal form.
+  if (noFlipsTile.transparent()) {
+    return normalization;
   }
-}
 
-static NormalizedTile candidate(PorytilesContext &ctx, CompilerMode compilerMode, const RGBA32 &transparencyColor,
-                                const std::vector<RGBATile> &rgbaFrames, bool hFlip, bool vFlip, bool errWarn)
-{
   /*
-   * NOTE: This only produces a _candidate_ normalized tile (a different choice of hFlip/vFlip might be the normal
-   * form). We'll use this to generate candidates to find the true normal form.
+   * The flipped candidates would record every pixel again. The bothFlips one runs last and visits the pixels in
+   * reverse, so its writes are the ones left in bgrToRgba.
    */
-  NormalizedTile candidateTile{transparencyColor};
-  candidateTile.hFlip = hFlip;
-  candidateTile.vFlip = vFlip;
-  candidateTile.frames.resize(rgbaFrames.size());
+  for (std::size_t frame = 0; frame < rgbaFrames.size(); frame++) {
+    for (std::size_t pixel = 0; pixel < TILE_NUM_PIX; pixel++) {
+      const RGBA32 &rgba = rgbaFrames[frame].pixels[TILE_NUM_PIX - 1 - pixel];
+      if (rgba.alpha != ALPHA_OPAQUE || rgba == transparencyColor) {
+        continue;
+      }
+      BGR15 bgr = rgbaToBgr(rgba);
+      auto color = std::find_if(std::begin(colors), std::end(colors),
+                                [&bgr](const auto &tracked) { return tracked.bgr == bgr; });
+      color->rgba = rgba;
+      color->frame = frame;
+      color->row = pixel / TILE_SIDE_LENGTH_PIX;
+      color->col = pixel % TILE_SIDE_LENGTH_PIX;
+    }
+  }
 
-  std::size_t frame = 0;
-  for (const auto &rgba : rgbaFrames) {
-    for (std::size_t row = 0; row < TILE_SIDE_LENGTH_PIX; row++) {
-      for (std::size_t col = 0; col < TILE_SIDE_LENGTH_PIX; col++) {
-        std::size_t rowWithFlip = vFlip ? TILE_SIDE_LENGTH_PIX - 1 - row : row;
-        std::size_t colWithFlip = hFlip ? TILE_SIDE_LENGTH_PIX - 1 - col : col;
-        std::size_t pixelValue = insertRGBA(ctx, compilerMode, rgba, transparencyColor, candidateTile.palette,
-                                            rgba.getPixel(rowWithFlip, colWithFlip), row, col, errWarn);
-        candidateTile.setPixel(frame, row, col, pixelValue);
+  if (invalidPixels) {
+    // We already reported errors for this tile and compilation stops after normalizing, so its orientation is moot
+    return normalization;
+  }
+
+  // Same order the reference implementation tries the candidates in, so ties still go to the earliest one
+  constexpr std::array<std::pair<bool, bool>, 4> flips{{{false, false}, {true, false}, {false, true}, {true, true}}};
+  std::array<std::uint8_t, PAL_SIZE> labels{};
+  std::uint8_t labelCount = 1;
+  auto resetLabels = [&labels, &labelCount]() {
+    labels.fill(INVALID_INDEX_PIXEL_VALUE);
+    labels[0] = 0;
+    labelCount = 1;
+  };
+
+  // Only the key frames decide the order, so only the winner needs its other frames and its palette relabeled
+  std::size_t best = 0;
+  NormalizedPixels bestKeyFrame = noFlipsTile.keyFrame();
+  for (std::size_t flip = 1; flip < flips.size(); flip++) {
+    resetLabels();
+    NormalizedPixels keyFrame = relabelFlipped(noFlipsTile.keyFrame(), flips[flip].first, flips[flip].second, labels,
+                                               labelCount);
+    if (keyFrame < bestKeyFrame) {
+      best = flip;
+      bestKeyFrame = keyFrame;
+    }
+  }
+  if (best == 0) {
+    return normalization;
+  }
+
+  NormalizedTile normalizedTile{transparencyColor};
+  normalizedTile.hFlip = flips[best].first;
+  normalizedTile.vFlip = flips[best].second;
+  normalizedTile.frames.resize(noFlipsTile.frames.size());
+  resetLabels();
+  for (std::size_t frame = 0; frame < noFlipsTile.frames.size(); frame++) {
+    normalizedTile.frames.at(frame) =
+        relabelFlipped(noFlipsTile.frames.at(frame), normalizedTile.hFlip, normalizedTile.vFlip, labels, labelCount);
+  }
+  normalizedTile.palette.size = noFlipsTile.palette.size;
+  for (int index = 1; index < noFlipsTile.palette.size; index++) {
+    normalizedTile.palette.colors.at(labels[index]) = noFlipsTile.palette.colors.at(index);
+  }
+  normalization.normalizedTile = std::move(normalizedTile);
+  return normalization;
+}
+
+/*
+ * Report a tile's diagnostics and record its colors in bgrToRgba, as if it had just been normalized. `rgbaFrames' is
+ * the tile the diagnostics point at, which may be a repeat of the tile that was actually normalized.
+ */
+static void recordNormalization(PorytilesContext &ctx, CompilerMode compilerMode, std::span<const RGBATile> rgbaFrames,
+                                const TileNormalization &normalization)
+{
+  const RGBA32 &transparencyColor = ctx.compilerConfig.transparencyColor;
+  for (const auto &diagnostic : normalization.diagnostics) {
+    const RGBATile &rgbaFrame = rgbaFrames[diagnostic.frame];
+    switch (diagnostic.kind) {
+    case NormalizeDiagnosticKind::TRANSPARENCY_COLLAPSE:
+      warn_nonTransparentRgbaCollapsedToTransparentBgr(ctx.err, compilerMode, rgbaFrame, diagnostic.row,
+                                                       diagnostic.col, diagnostic.rgba, transparencyColor);
+      break;
+    case NormalizeDiagnosticKind::FIRST_USE: {
+      BGR15 bgr = rgbaToBgr(diagnostic.rgba);
+      auto previous = ctx.compilerContext.bgrToRgba.find(bgr);
+      if (previous != ctx.compilerContext.bgrToRgba.end() && previous->second.rgba != diagnostic.rgba) {
+        warn_colorPrecisionLoss(ctx.err, compilerMode, rgbaFrame, diagnostic.row, diagnostic.col, bgr,
+                                diagnostic.rgba, ctx.compilerContext.colorUse(previous->second));
       }
+      break;
+    }
+    case NormalizeDiagnosticKind::PRECISION_LOSS:
+      warn_colorPrecisionLoss(ctx.err, compilerMode, rgbaFrame, diagnostic.row, diagnostic.col,
+                              rgbaToBgr(diagnostic.rgba), diagnostic.rgba,
+                              std::tuple<RGBA32, RGBATile, std::size_t, std::size_t>{
+                                  diagnostic.previousRgba, rgbaFrames[diagnostic.previousFrame],
+                                  diagnostic.previousRow, diagnostic.previousCol});
+      break;
+    case NormalizeDiagnosticKind::TOO_MANY_COLORS:
+      error_tooManyUniqueColorsInTile(ctx.err, rgbaFrame, diagnostic.row, diagnostic.col);
+      break;
+    case NormalizeDiagnosticKind::INVALID_ALPHA:
+      error_invalidAlphaValue(ctx.err, rgbaFrame, diagnostic.rgba.alpha, diagnostic.row, diagnostic.col);
+      break;
     }
-    frame++;
   }
 
-  return candidateTile;
+  for (const auto &color : normalization.colors) {
+    ctx.compilerContext.recordColor(color.bgr, color.rgba, rgbaFrames[color.frame], color.row, color.col);
+  }
+  logNormalizedTile(ctx, rgbaFrames[0], normalization.normalizedTile);
 }
 
 static NormalizedTile normalize(PorytilesContext &ctx, CompilerMode compilerMode,
                                 const std::vector<RGBATile> &rgbaFrames)
 {
-  /*
-   * Normalize the given tile by checking each of the 4 possible flip states, and choosing the one that comes first in
-   * "lexicographic" order, where this order is determined by the std::array spaceship operator.
-   */
-  auto noFlipsTile = candidate(ctx, compilerMode, ctx.compilerConfig.transparencyColor, rgbaFrames, false, false, true);
+  TileNormalization normalization = normalizeTile(ctx.compilerConfig.transparencyColor, rgbaFrames);
+  recordNormalization(ctx, compilerMode, rgbaFrames, normalization);
+  return normalization.normalizedTile;
+}
 
-  // Short-circuit because transparent tiles are common in metatiles and trivially in normal form.
-  if (noFlipsTile.transparent()) {
-    if (rgbaFrames.at(0).type == TileType::LAYERED) {
-      pt_logln(ctx, stderr, "{}:{}:{} = transparent", layerString(rgbaFrames.at(0).layer),
-               rgbaFrames.at(0).metatileIndex, subtileString(rgbaFrames.at(0).subtile));
+/*
+ * Metatiles use the same few tiles over and over: transparent tiles, grass, walls. A TileNormalization only depends on
+ * the tile's pixels, so normalizeDecompTiles keeps them keyed by pixels and only records the repeats.
+ */
+struct RGBATilePixelsHash {
+  std::size_t operator()(const std::array<RGBA32, TILE_NUM_PIX> &pixels) const noexcept
+  {
+    // FNV-1a over the channels
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const auto &pixel : pixels) {
+      for (std::uint8_t channel : {pixel.red, pixel.green, pixel.blue, pixel.alpha}) {
+        hash = (hash ^ channel) * 0x100000001b3ULL;
+      }
     }
-    return noFlipsTile;
+    return static_cast<std::size_t>(hash);
   }
+};
 
-  auto hFlipTile = candidate(ctx, compilerMode, ctx.compilerConfig.transparencyColor, rgbaFrames, true, false, false);
-  auto vFlipTile = candidate(ctx, compilerMode, ctx.compilerConfig.transparencyColor, rgbaFrames, false, true, false);
-  auto bothFlipsTile =
-      candidate(ctx, compilerMode, ctx.compilerConfig.transparencyColor, rgbaFrames, true, true, false);
-
-  std::array<const NormalizedTile *, 4> candidates = {&noFlipsTile, &hFlipTile, &vFlipTile, &bothFlipsTile};
-  auto normalizedTile = std::min_element(std::begin(candidates), std::end(candidates),
-                                         [](auto tile1, auto tile2) { return tile1->keyFrame() < tile2->keyFrame(); });
+using NormalizeCache = std::unordered_map<std::array<RGBA32, TILE_NUM_PIX>, TileNormalization, RGBATilePixelsHash>;
 
-  if (rgbaFrames.at(0).type == TileType::LAYERED) {
-    pt_logln(ctx, stderr, "{}:{}:{} = [hFlip: {}, vFlip: {}]", layerString(rgbaFrames.at(0).layer),
-             rgbaFrames.at(0).metatileIndex, subtileString(rgbaFrames.at(0).subtile), (**normalizedTile).hFlip,
-             (**normalizedTile).vFlip);
+static NormalizedTile normalizeCached(PorytilesContext &ctx, CompilerMode compilerMode, NormalizeCache &cache,
+                                      const RGBATile &tile)
+{
+  std::span<const RGBATile> singleFrameTile{&tile, 1};
+  auto cached = cache.find(tile.pixels);
+  if (cached == cache.end()) {
+    cached = cache.emplace(tile.pixels, normalizeTile(ctx.compilerConfig.transparencyColor, singleFrameTile)).first;
   }
+  recordNormalization(ctx, compilerMode, singleFrameTile, cached->second);
+  return cached->second.normalizedTile;
+}
 
-  return **normalizedTile;
+/*
+ * Run `task' on every index below `taskCount', spread over the configured number of jobs. Each worker claims the next
+ * index that nobody has taken yet.
+ */
+template <typename Task> static void runNormalizeTasks(const PorytilesContext &ctx, std::size_t taskCount, Task &&task)
+{
+  std::atomic_size_t nextIndex{0};
+  std::mutex workerErrorMutex{};
+  std::exception_ptr workerError = nullptr;
+  auto worker = [&]() {
+    try {
+      for (std::size_t index = nextIndex++; index < taskCount; index = nextIndex++) {
+        task(index);
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock{workerErrorMutex};
+      if (workerError == nullptr) {
+        workerError = std::current_exception();
+      }
+      nextIndex.store(taskCount);
+    }
+  };
+  std::size_t jobs = std::min(ctx.compilerConfig.effectiveJobs(), std::max(taskCount, std::size_t{1}));
+  std::vector<std::thread> workers{};
+  for (std::size_t i = 1; i < jobs; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : workers) {
+    thread.join();
+  }
+  if (workerError != nullptr) {
+    std::rethrow_exception(workerError);
+  }
 }
 
 static std::pair<std::vector<IndexAndNormTile>, std::vector<NormalizedTile>>
@@ -158,10 +397,16 @@ normalizeDecompTiles(PorytilesContext &ctx, CompilerMode compilerMode, const Dec
   /*
    * For each tile in the decomp tileset, normalize it and tag it with its index in the decomp tileset. We tag the
    * animated tiles first, then tag the regular assignment tiles.
+   *
+   * The anim tiles and each distinct regular tile are normalized across the worker threads first. Then a single pass
+   * records them in order, so warnings, errors and bgrToRgba come out exactly as if it all ran on one thread.
    */
   std::vector<IndexAndNormTile> normalizedTiles;
   std::vector<NormalizedTile> normalizedPrimers;
+  const RGBA32 &transparencyColor = ctx.compilerConfig.transparencyColor;
 
+  std::vector<std::vector<RGBATile>> multiFrameTiles{};
+  std::vector<DecompiledIndex> multiFrameIndexes{};
   for (std::size_t animIndex = 0; animIndex < decompiledTileset.anims.size(); animIndex++) {
     const auto &anim = decompiledTileset.anims.at(animIndex);
     // We have already validated that all frames have identical dimensions, so we can use the key frame here
@@ -172,32 +417,51 @@ normalizeDecompTiles(PorytilesContext &ctx, CompilerMode compilerMode, const Dec
         multiFrameTile.push_back(anim.frames.at(frameIndex).tiles.at(tileIndex));
       }
       DecompiledIndex index{};
-      auto normalizedTile = normalize(ctx, compilerMode, multiFrameTile);
-      normalizedTile.copyMetadataFrom(multiFrameTile.at(0));
       index.animated = true;
       index.animIndex = animIndex;
       index.tileIndex = tileIndex;
-      normalizedTiles.emplace_back(index, normalizedTile);
+      multiFrameTiles.push_back(std::move(multiFrameTile));
+      multiFrameIndexes.push_back(index);
+    }
+  }
+
+  // Map entries stay put as the cache grows, so workers can fill them in through these pointers
+  NormalizeCache normalizeCache{};
+  std::vector<std::pair<const RGBATile *, TileNormalization *>> distinctTiles{};
+  for (const auto &tile : decompiledTileset.tiles) {
+    auto [entry, inserted] =
+        normalizeCache.try_emplace(tile.pixels, TileNormalization{NormalizedTile{transparencyColor}, {}, {}});
+    if (inserted) {
+      distinctTiles.emplace_back(&tile, &entry->second);
     }
   }
 
+  std::vector<TileNormalization> multiFrameNormalizations(multiFrameTiles.size(),
+                                                          TileNormalization{NormalizedTile{transparencyColor}, {}, {}});
+  runNormalizeTasks(ctx, multiFrameTiles.size() + distinctTiles.size(), [&](std::size_t task) {
+    if (task < multiFrameTiles.size()) {
+      multiFrameNormalizations.at(task) = normalizeTile(transparencyColor, multiFrameTiles.at(task));
+    }
+    else {
+      auto [tile, normalization] = distinctTiles.at(task - multiFrameTiles.size());
+      *normalization = normalizeTile(transparencyColor, std::span<const RGBATile>{tile, 1});
+    }
+  });
+
+  for (std::size_t i = 0; i < multiFrameTiles.size(); i++) {
+    recordNormalization(ctx, compilerMode, multiFrameTiles.at(i), multiFrameNormalizations.at(i));
+    normalizedTiles.emplace_back(multiFrameIndexes.at(i), std::move(multiFrameNormalizations.at(i).normalizedTile));
+  }
+
   std::size_t tileIndex = 0;
   for (const auto &tile : decompiledTileset.tiles) {
-    std::vector<RGBATile> singleFrameTile = {tile};
-    auto normalizedTile = normalize(ctx, compilerMode, singleFrameTile);
-    normalizedTile.copyMetadataFrom(tile);
     DecompiledIndex index{};
     index.tileIndex = tileIndex++;
-    normalizedTiles.emplace_back(index, normalizedTile);
+    normalizedTiles.emplace_back(index, normalizeCached(ctx, compilerMode, normalizeCache, tile));
   }
 
   for (const auto &primerTile : palettePrimers) {
-    std::vector<RGBATile> singleFramePrimerTile = {primerTile};
-    auto normalizedPrimerTile = normalize(ctx, compilerMode, singleFramePrimerTile);
-    normalizedPrimerTile.copyMetadataFrom(primerTile);
-    DecompiledIndex index{};
-    index.tileIndex = tileIndex++;
-    normalizedPrimers.emplace_back(normalizedPrimerTile);
+    normalizedPrimers.push_back(normalize(ctx, compilerMode, std::vector<RGBATile>{primerTile}));
   }
 
   if (ctx.err.errCount > 0) {
@@ -205,7 +469,7 @@ normalizeDecompTiles(PorytilesContext &ctx, CompilerMode compilerMode, const Dec
                    "errors generated during tile normalization");
   }
 
-  return std::pair{normalizedTiles, normalizedPrimers};
+  return std::pair{std::move(normalizedTiles), std::move(normalizedPrimers)};
 }
 
 static std::pair<std::unordered_map<BGR15, std::size_t>, std::unordered_map<std::size_t, BGR15>> buildColorIndexMaps(
@@ -305,10 +569,11 @@ matchNormalizedWithColorSets(const std::unordered_map<BGR15, std::size_t> &color
   std::vector<ColorSet> colorSets;
   std::unordered_set<ColorSet> uniquePrimerColorSets;
   std::vector<ColorSet> primerColorSets;
-  for (const auto &[index, normalizedTile] : indexedNormalizedTiles) {
+  for (std::size_t i = 0; i < indexedNormalizedTiles.size(); i++) {
+    const auto &[index, normalizedTile] = indexedNormalizedTiles.at(i);
     // Compute the ColorSet for this normalized tile, then add it to our indexes
     auto colorSet = toColorSet(colorIndexMap, normalizedTile.palette);
-    indexedNormTilesWithColorSets.emplace_back(index, normalizedTile, colorSet);
+    indexedNormTilesWithColorSets.emplace_back(index, i, colorSet);
     if (!uniqueColorSets.contains(colorSet)) {
       colorSets.push_back(colorSet);
       uniqueColorSets.insert(colorSet);
@@ -347,7 +612,18 @@ static GBATile makeTile(const NormalizedTile &normalizedTile, std::size_t frame,
   return gbaTile;
 }
 
+// The RGBATile a normalized tile came from, which is where its metadata lives. Anim tiles point at their key frame.
+static const RGBATile &decompiledTile(const DecompiledTileset &decompiledTileset, const DecompiledIndex &index)
+{
+  if (index.animated) {
+    return decompiledTileset.anims.at(index.animIndex).keyFrame().tiles.at(index.tileIndex);
+  }
+  return decompiledTileset.tiles.at(index.tileIndex);
+}
+
 static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
+                               const DecompiledTileset &decompiledTileset,
+                               const std::vector<IndexAndNormTile> &indexedNormTiles,
                                const std::vector<IndexedNormTileWithColorSet> &indexedNormTilesWithColorSets,
                                const std::vector<ColorSet> &assignedPalsSolution)
 {
@@ -365,8 +641,9 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
    */
   for (const auto &indexedNormTile : indexedNormTilesWithColorSets) {
     auto index = std::get<0>(indexedNormTile);
-    auto &normTile = std::get<1>(indexedNormTile);
+    const NormalizedTile &normTile = indexedNormTiles.at(std::get<1>(indexedNormTile)).second;
     auto &colorSet = std::get<2>(indexedNormTile);
+    const RGBATile &sourceTile = decompiledTile(decompiledTileset, index);
 
     // Skip regular tiles, since we will process them next
     if (!index.animated) {
@@ -378,7 +655,7 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
     auto it = std::find_if(std::begin(assignedPalsSolution), std::end(assignedPalsSolution),
                            [&colorSet](const auto &assignedPal) {
                              // Find which of the assignedSolution palettes this tile belongs to
-                             return (colorSet & ~assignedPal).none();
+                             return colorSet.isSubsetOf(assignedPal);
                            });
     if (it == std::end(assignedPalsSolution)) {
       internalerror("compiler::assignTilesPrimary it == std::end(assignedPalsSolution)");
@@ -394,8 +671,8 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
        * to tell if a user provided tile on the layer sheet referred to the true index 0 transparent tile, or if it was
        * a reference into this particular animation.
        */
-      fatalerror_transparentKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::PRIMARY, normTile.anim,
-                                         normTile.tileIndex);
+      fatalerror_transparentKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::PRIMARY, sourceTile.anim,
+                                         sourceTile.tileIndex);
     }
 
     // Insert this tile's key frame into the seen tiles map
@@ -415,8 +692,8 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
       usedKeyFrameTiles.insert(std::pair{keyFrameTile, false});
     }
     else if (tileIndexes.contains(keyFrameTile)) {
-      fatalerror_duplicateKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::PRIMARY, normTile.anim,
-                                       normTile.tileIndex);
+      fatalerror_duplicateKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::PRIMARY, sourceTile.anim,
+                                       sourceTile.tileIndex);
     }
     else {
       internalerror("compiler::assignTilesPrimary third key tile insertion branch, should be unreachable");
@@ -437,8 +714,9 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
    */
   for (const auto &indexedNormTile : indexedNormTilesWithColorSets) {
     auto index = std::get<0>(indexedNormTile);
-    auto &normTile = std::get<1>(indexedNormTile);
+    const NormalizedTile &normTile = indexedNormTiles.at(std::get<1>(indexedNormTile)).second;
     auto &colorSet = std::get<2>(indexedNormTile);
+    const RGBATile &sourceTile = decompiledTile(decompiledTileset, index);
 
     // Skip animated tiles since we already processed them
     if (index.animated) {
@@ -448,7 +726,7 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
     auto it = std::find_if(std::begin(assignedPalsSolution), std::end(assignedPalsSolution),
                            [&colorSet](const auto &assignedPal) {
                              // Find which of the assignedSolution palettes this tile belongs to
-                             return (colorSet & ~assignedPal).none();
+                             return colorSet.isSubsetOf(assignedPal);
                            });
     if (it == std::end(assignedPalsSolution)) {
       internalerror("compiler::assignTilesPrimary it == std::end(assignedPalsSolution)");
@@ -469,7 +747,7 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
     }
     std::size_t tileIndex = inserted.first->second;
     compiled.metatileEntries.at(index.tileIndex) = {tileIndex, paletteIndex, normTile.hFlip, normTile.vFlip,
-                                                    normTile.attributes};
+                                                    sourceTile.attributes};
   }
   compiled.tileIndexes = tileIndexes;
 
@@ -497,6 +775,8 @@ static void assignTilesPrimary(PorytilesContext &ctx, CompiledTileset &compiled,
 }
 
 static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compiled,
+                                 const DecompiledTileset &decompiledTileset,
+                                 const std::vector<IndexAndNormTile> &indexedNormTiles,
                                  const std::vector<IndexedNormTileWithColorSet> &indexedNormTilesWithColorSets,
                                  const std::vector<ColorSet> &primaryPaletteColorSets,
                                  const std::vector<ColorSet> &assignedPalsSolution)
@@ -513,8 +793,9 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
    */
   for (const auto &indexedNormTile : indexedNormTilesWithColorSets) {
     auto index = std::get<0>(indexedNormTile);
-    auto &normTile = std::get<1>(indexedNormTile);
+    const NormalizedTile &normTile = indexedNormTiles.at(std::get<1>(indexedNormTile)).second;
     auto &colorSet = std::get<2>(indexedNormTile);
+    const RGBATile &sourceTile = decompiledTile(decompiledTileset, index);
 
     // Skip regular tiles, since we will process them next
     if (!index.animated) {
@@ -525,7 +806,7 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
              index.animIndex, index.tileIndex);
     auto it = std::find_if(std::begin(allColorSets), std::end(allColorSets), [&colorSet](const auto &assignedPal) {
       // Find which of the allColorSets palettes this tile belongs to
-      return (colorSet & ~assignedPal).none();
+      return colorSet.isSubsetOf(assignedPal);
     });
     if (it == std::end(allColorSets)) {
       internalerror("compiler::assignTilesSecondary it == std::end(allColorSets)");
@@ -542,8 +823,8 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
          * way to tell if a transparent user provided tile on the layer sheet referred to the true index 0 transparent
          * tile, or if it was a reference into this particular animation.
          */
-        fatalerror_transparentKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::SECONDARY, normTile.anim,
-                                           normTile.tileIndex);
+        fatalerror_transparentKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::SECONDARY, sourceTile.anim,
+                                           sourceTile.tileIndex);
       }
       else {
         /*
@@ -551,8 +832,8 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
          * animation inoperable, any reference to the repTile in the secondary set will be linked to the primary tile
          * as opposed to the animation.
          */
-        fatalerror_keyFramePresentInPairedPrimary(ctx.err, ctx.compilerSrcPaths, CompilerMode::SECONDARY, normTile.anim,
-                                                  normTile.tileIndex);
+        fatalerror_keyFramePresentInPairedPrimary(ctx.err, ctx.compilerSrcPaths, CompilerMode::SECONDARY,
+                                                  sourceTile.anim, sourceTile.tileIndex);
       }
     }
 
@@ -573,8 +854,8 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
       usedKeyFrameTiles.insert(std::pair{keyFrameTile, false});
     }
     else if (tileIndexes.contains(keyFrameTile)) {
-      fatalerror_duplicateKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::SECONDARY, normTile.anim,
-                                       normTile.tileIndex);
+      fatalerror_duplicateKeyFrameTile(ctx.err, ctx.compilerSrcPaths, CompilerMode::SECONDARY, sourceTile.anim,
+                                       sourceTile.tileIndex);
     }
     else {
       internalerror("compiler::assignTilesSecondary third key tile insertion branch, should be unreachable");
@@ -595,8 +876,9 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
    */
   for (const auto &indexedNormTile : indexedNormTilesWithColorSets) {
     auto index = std::get<0>(indexedNormTile);
-    auto &normTile = std::get<1>(indexedNormTile);
+    const NormalizedTile &normTile = indexedNormTiles.at(std::get<1>(indexedNormTile)).second;
     auto &colorSet = std::get<2>(indexedNormTile);
+    const RGBATile &sourceTile = decompiledTile(decompiledTileset, index);
 
     // Skip animated tiles since we already processed them
     if (index.animated) {
@@ -605,7 +887,7 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
 
     auto it = std::find_if(std::begin(allColorSets), std::end(allColorSets), [&colorSet](const auto &assignedPal) {
       // Find which of the allColorSets palettes this tile belongs to
-      return (colorSet & ~assignedPal).none();
+      return colorSet.isSubsetOf(assignedPal);
     });
     if (it == std::end(allColorSets)) {
       internalerror("compiler::assignTilesSecondary it == std::end(allColorSets)");
@@ -622,7 +904,7 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
       // Tile was in the primary set
       compiled.metatileEntries.at(index.tileIndex) = {ctx.compilerContext.pairedPrimaryTileset->tileIndexes.at(gbaTile),
                                                       paletteIndex, normTile.hFlip, normTile.vFlip,
-                                                      normTile.attributes};
+                                                      sourceTile.attributes};
     }
     else {
       // Tile was in the secondary set
@@ -634,7 +916,7 @@ static void assignTilesSecondary(PorytilesContext &ctx, CompiledTileset &compile
       std::size_t tileIndex = inserted.first->second;
       // Offset the tile index by the secondary tileset VRAM location, which is just the size of the primary tiles
       compiled.metatileEntries.at(index.tileIndex) = {tileIndex + ctx.fieldmapConfig.numTilesInPrimary, paletteIndex,
-                                                      normTile.hFlip, normTile.vFlip, normTile.attributes};
+                                                      normTile.hFlip, normTile.vFlip, sourceTile.attributes};
     }
   }
   compiled.tileIndexes = tileIndexes;
@@ -727,7 +1009,7 @@ std::unique_ptr<CompiledTileset> compile(PorytilesContext &ctx, CompilerMode com
 
   /*
    * colorSets is a vector: this enforces a well-defined ordering so tileset compilation results are identical across
-   * all compilers and platforms. A ColorSet is just a bitset<240> that marks which colors are present (indexes are
+   * all compilers and platforms. A ColorSet is just a 240 bit set that marks which colors are present (indexes are
    * based on the colorIndexMaps from above)
    */
   auto [indexedNormTilesWithColorSets, colorSets, primerColorSets] =
@@ -798,10 +1080,12 @@ std::unique_ptr<CompiledTileset> compile(PorytilesContext &ctx, CompilerMode com
    * Build the metatile entries.
    */
   if (compilerMode == CompilerMode::PRIMARY) {
-    assignTilesPrimary(ctx, *compiled, indexedNormTilesWithColorSets, assignedPalsSolution);
+    assignTilesPrimary(ctx, *compiled, decompiledTileset, indexedNormTiles, indexedNormTilesWithColorSets,
+                       assignedPalsSolution);
   }
   else if (compilerMode == CompilerMode::SECONDARY) {
-    assignTilesSecondary(ctx, *compiled, indexedNormTilesWithColorSets, primaryPaletteColorSets, assignedPalsSolution);
+    assignTilesSecondary(ctx, *compiled, decompiledTileset, indexedNormTiles, indexedNormTilesWithColorSets,
+                         primaryPaletteColorSets, assignedPalsSolution);
   }
   else {
     internalerror_unknownCompilerMode("compiler::compile");
@@ -823,6 +1107,126 @@ std::unique_ptr<CompiledTileset> compile(PorytilesContext &ctx, CompilerMode com
 // |    TEST CASES    |
 // --------------------
 
+/*
+ * Reference implementation of tile normalization, kept for the tests only. This is how normalize used to work: build a
+ * candidate tile for each flip, inserting its colors one pixel at a time, then keep the smallest candidate. It is slow
+ * but easy to check by eye, so the tests below compare the single pass kernel in normalizeTile against it.
+ */
+namespace porytiles {
+static std::size_t insertRGBA(PorytilesContext &ctx, CompilerMode compilerMode, const RGBATile &rgbaFrame,
+                              const RGBA32 &transparencyColor, NormalizedPalette &palette, const RGBA32 &rgba,
+                              std::size_t row, std::size_t col, bool errWarn)
+{
+  auto transparencyBgr = rgbaToBgr(transparencyColor);
+  if (rgba != transparencyColor && rgbaToBgr(rgba) == transparencyBgr && errWarn) {
+    /*
+     * If we hit this case, it's almost certainly a user mistake so let's push an error. We would prefer to err on the
+     * side of forcing the user to be explicit, especially when it comes to transparency handling.
+     */
+    warn_nonTransparentRgbaCollapsedToTransparentBgr(ctx.err, compilerMode, rgbaFrame, row, col, rgba,
+                                                     transparencyColor);
+  }
+  /*
+   * Insert an rgba32 color into a normalized palette. The color will be converted to bgr15 format in the process,
+   * and possibly deduped (depending on user settings). Transparent alpha pixels will be treated as transparent, as
+   * will pixels that are of transparent color (again, set by the user but default to magenta). Fails if a tile
+   * contains too many unique colors or if an invalid alpha value is detected.
+   */
+  if (rgba.alpha == ALPHA_TRANSPARENT || rgba == transparencyColor) {
+    return 0;
+  }
+  else if (rgba.alpha == ALPHA_OPAQUE) {
+    auto bgr = rgbaToBgr(rgba);
+
+    auto previous = ctx.compilerContext.bgrToRgba.find(bgr);
+    if (previous != ctx.compilerContext.bgrToRgba.end() && previous->second.rgba != rgba && errWarn) {
+      /*
+       * We lost color precision here, so let's warn the user that two distinct RGBA colors they used
+       * in the master sheet are going to collapse to one BGR color on the GBA.
+       */
+      warn_colorPrecisionLoss(ctx.err, compilerMode, rgbaFrame, row, col, bgr, rgba,
+                              ctx.compilerContext.colorUse(previous->second));
+    }
+    ctx.compilerContext.recordColor(bgr, rgba, rgbaFrame, row, col);
+
+    auto itrAtBgr = std::find(std::begin(palette.colors) + 1, std::begin(palette.colors) + palette.size, bgr);
+    auto bgrPosInPalette = itrAtBgr - std::begin(palette.colors);
+    if (bgrPosInPalette == palette.size) {
+      // palette size will grow as we add to it
+      if (palette.size == PAL_SIZE) {
+        if (errWarn) {
+          error_tooManyUniqueColorsInTile(ctx.err, rgbaFrame, row, col);
+        }
+        return INVALID_INDEX_PIXEL_VALUE;
+      }
+      palette.colors.at(palette.size++) = bgr;
+    }
+    return bgrPosInPalette;
+  }
+  else {
+    if (errWarn) {
+      error_invalidAlphaValue(ctx.err, rgbaFrame, rgba.alpha, row, col);
+    }
+    return INVALID_INDEX_PIXEL_VALUE;
+  }
+}
+
+static NormalizedTile candidate(PorytilesContext &ctx, CompilerMode compilerMode, const RGBA32 &transparencyColor,
+                                const std::vector<RGBATile> &rgbaFrames, bool hFlip, bool vFlip, bool errWarn)
+{
+  /*
+   * NOTE: This only produces a _candidate_ normalized tile (a different choice of hFlip/vFlip might be the normal
+   * form). We'll use this to generate candidates to find the true normal form.
+   */
+  NormalizedTile candidateTile{transparencyColor};
+  candidateTile.hFlip = hFlip;
+  candidateTile.vFlip = vFlip;
+  candidateTile.frames.resize(rgbaFrames.size());
+
+  std::size_t frame = 0;
+  for (const auto &rgba : rgbaFrames) {
+    for (std::size_t row = 0; row < TILE_SIDE_LENGTH_PIX; row++) {
+      for (std::size_t col = 0; col < TILE_SIDE_LENGTH_PIX; col++) {
+        std::size_t rowWithFlip = vFlip ? TILE_SIDE_LENGTH_PIX - 1 - row : row;
+        std::size_t colWithFlip = hFlip ? TILE_SIDE_LENGTH_PIX - 1 - col : col;
+        std::size_t pixelValue = insertRGBA(ctx, compilerMode, rgba, transparencyColor, candidateTile.palette,
+                                            rgba.getPixel(rowWithFlip, colWithFlip), row, col, errWarn);
+        candidateTile.setPixel(frame, row, col, pixelValue);
+      }
+    }
+    frame++;
+  }
+
+  return candidateTile;
+}
+
+} // namespace porytiles
+
+/*
+ * Build the tile through all four flips and take the smallest. normalize must give the same result and leave the same
+ * color provenance behind.
+ */
+static porytiles::NormalizedTile normalizeFromCandidates(porytiles::PorytilesContext &ctx,
+                                                         const std::vector<porytiles::RGBATile> &rgbaFrames)
+{
+  const porytiles::RGBA32 &transparencyColor = ctx.compilerConfig.transparencyColor;
+  auto noFlipsTile =
+      porytiles::candidate(ctx, porytiles::CompilerMode::PRIMARY, transparencyColor, rgbaFrames, false, false, true);
+  if (noFlipsTile.transparent()) {
+    return noFlipsTile;
+  }
+  auto hFlipTile =
+      porytiles::candidate(ctx, porytiles::CompilerMode::PRIMARY, transparencyColor, rgbaFrames, true, false, false);
+  auto vFlipTile =
+      porytiles::candidate(ctx, porytiles::CompilerMode::PRIMARY, transparencyColor, rgbaFrames, false, true, false);
+  auto bothFlipsTile =
+      porytiles::candidate(ctx, porytiles::CompilerMode::PRIMARY, transparencyColor, rgbaFrames, true, true, false);
+  std::array<const porytiles::NormalizedTile *, 4> candidates = {&noFlipsTile, &hFlipTile, &vFlipTile, &bothFlipsTile};
+  return **std::min_element(std::begin(candidates), std::end(candidates),
+                            [](auto tile1, auto tile2) { return tile1->keyFrame() < tile2->keyFrame(); });
+}
+
+
 TEST_CASE("insertRGBA should add new colors in order and return the correct index for a given color")
 {
   porytiles::PorytilesContext ctx{};
@@ -1056,6 +1460,171 @@ TEST_CASE("normalize should return the normal form of the given tile")
   CHECK(normalizedTile.keyFrame().colorIndexes[63] == 5);
 }
 
+static porytiles::DecompiledTileset importFixtureTiles(porytiles::PorytilesContext &ctx, const std::string &fixture)
+{
+  std::filesystem::path fixturePath{fixture};
+  REQUIRE(std::filesystem::exists(fixturePath / "bottom.png"));
+  png::image<png::rgba_pixel> bottom{fixturePath / "bottom.png"};
+  png::image<png::rgba_pixel> middle{fixturePath / "middle.png"};
+  png::image<png::rgba_pixel> top{fixturePath / "top.png"};
+  return porytiles::importLayeredTilesFromPngs(ctx, porytiles::CompilerMode::PRIMARY,
+                                               std::unordered_map<std::size_t, porytiles::Attributes>{}, bottom,
+                                               middle, top);
+}
+
+/*
+ * Run the given primary tiles through the compiler up to the ColorSets that palette assignment works on, along with the
+ * color index map they were built with.
+ */
+static std::pair<std::unordered_map<porytiles::BGR15, std::size_t>, std::vector<ColorSet>>
+fixtureColorSets(porytiles::PorytilesContext &ctx, const porytiles::DecompiledTileset &tiles)
+{
+  auto [indexedNormTiles, _1] = porytiles::normalizeDecompTiles(ctx, porytiles::CompilerMode::PRIMARY, tiles, {});
+  auto [colorToIndex, indexToColor] =
+      porytiles::buildColorIndexMaps(ctx, porytiles::CompilerMode::PRIMARY, indexedNormTiles, {}, {});
+  auto [indexedNormTilesWithColorSets, colorSets, _2] =
+      porytiles::matchNormalizedWithColorSets(colorToIndex, indexedNormTiles, {});
+  return std::pair{colorToIndex, colorSets};
+}
+
+// RGBA_RED and this collapse to the same BGR color, so tiles that use both record a color precision loss
+static const porytiles::RGBA32 RGBA_OTHER_RED{250, 2, 3, porytiles::ALPHA_OPAQUE};
+
+/*
+ * Build a tile of two colors on a transparent background. Layered tiles are keyed by their metatile index and every
+ * other type by its tile index, so `index' goes to whichever one `type' uses.
+ */
+static porytiles::RGBATile twoColorTile(porytiles::TileType type, std::size_t index, const porytiles::RGBA32 &first,
+                                        const porytiles::RGBA32 &second)
+{
+  porytiles::RGBATile tile{};
+  tile.type = type;
+  if (type == porytiles::TileType::LAYERED) {
+    tile.metatileIndex = index;
+  }
+  else {
+    tile.tileIndex = index;
+  }
+  for (std::size_t i = 0; i < porytiles::TILE_NUM_PIX; i++) {
+    tile.pixels.at(i) = i % 3 == 0 ? first : (i % 7 == 0 ? second : porytiles::RGBA_MAGENTA);
+  }
+  return tile;
+}
+
+TEST_CASE("normalize should match the smallest of the four flip candidates")
+{
+  for (const std::string fixture :
+       {"Resources/Tests/primary_general_emerald_nocache", "Resources/Tests/primary_general_firered_nocache",
+        "Resources/Tests/anim_metatiles_2/primary"}) {
+    porytiles::PorytilesContext ctx{};
+    ctx.err.printErrors = false;
+    ctx.err.colorPrecisionLoss = porytiles::WarningMode::WARN;
+    ctx.err.transparencyCollapse = porytiles::WarningMode::WARN;
+    porytiles::PorytilesContext referenceCtx{};
+    referenceCtx.err.printErrors = false;
+    referenceCtx.err.colorPrecisionLoss = porytiles::WarningMode::WARN;
+    referenceCtx.err.transparencyCollapse = porytiles::WarningMode::WARN;
+    porytiles::DecompiledTileset tiles = importFixtureTiles(ctx, fixture);
+
+    for (const auto &tile : tiles.tiles) {
+      std::vector<porytiles::RGBATile> singleFrameTile = {tile};
+      porytiles::NormalizedTile normalized = porytiles::normalize(ctx, porytiles::CompilerMode::PRIMARY, singleFrameTile);
+      porytiles::NormalizedTile reference = normalizeFromCandidates(referenceCtx, singleFrameTile);
+      CHECK(normalized.frames == reference.frames);
+      CHECK(normalized.palette.size == reference.palette.size);
+      CHECK(normalized.palette.colors == reference.palette.colors);
+      CHECK(normalized.hFlip == reference.hFlip);
+      CHECK(normalized.vFlip == reference.vFlip);
+    }
+    CHECK(ctx.err.warnCount == referenceCtx.err.warnCount);
+    CHECK(ctx.err.errCount == referenceCtx.err.errCount);
+
+    REQUIRE(ctx.compilerContext.bgrToRgba.size() == referenceCtx.compilerContext.bgrToRgba.size());
+    for (const auto &[bgr, referenceProvenance] : referenceCtx.compilerContext.bgrToRgba) {
+      CHECK(ctx.compilerContext.bgrToRgba.at(bgr) == referenceProvenance);
+    }
+  }
+}
+
+TEST_CASE("benchmark normalize against the four flip candidates on the primary_general fixtures" * doctest::skip())
+{
+  constexpr double BENCHMARK_MIN_SECONDS = 1.0;
+  for (const std::string fixture :
+       {"Resources/Tests/primary_general_emerald_nocache", "Resources/Tests/primary_general_firered_nocache",
+        "Resources/Tests/primary_general_sinnoh_nocache"}) {
+    porytiles::PorytilesContext ctx{};
+    ctx.err.printErrors = false;
+    porytiles::DecompiledTileset tiles = importFixtureTiles(ctx, fixture);
+    std::vector<std::vector<porytiles::RGBATile>> singleFrameTiles{};
+    for (const auto &tile : tiles.tiles) {
+      singleFrameTiles.push_back({tile});
+    }
+
+    auto run = [&](auto &&normalizeTile) {
+      std::size_t normalizedTiles = 0;
+      std::size_t checksum = 0;
+      auto start = std::chrono::steady_clock::now();
+      std::chrono::duration<double> elapsed{0};
+      while (elapsed.count() < BENCHMARK_MIN_SECONDS) {
+        for (const auto &singleFrameTile : singleFrameTiles) {
+          checksum += normalizeTile(singleFrameTile).keyFrame().colorIndexes[0];
+        }
+        normalizedTiles += singleFrameTiles.size();
+        elapsed = std::chrono::steady_clock::now() - start;
+      }
+      return std::tuple{normalizedTiles, checksum, elapsed.count()};
+    };
+    auto [candidateTiles, candidateChecksum, candidateSeconds] =
+        run([&](const auto &singleFrameTile) { return normalizeFromCandidates(ctx, singleFrameTile); });
+    auto [kernelTiles, kernelChecksum, kernelSeconds] = run([&](const auto &singleFrameTile) {
+      return porytiles::normalize(ctx, porytiles::CompilerMode::PRIMARY, singleFrameTile);
+    });
+    CHECK(candidateChecksum / candidateTiles == kernelChecksum / kernelTiles);
+
+    std::string name = std::filesystem::path{fixture}.filename().string();
+    MESSAGE(fmt::format("{} four candidates: {} tiles in {:.3f}s, {:.0f} ns/tile", name, candidateTiles,
+                        candidateSeconds, candidateSeconds * 1e9 / candidateTiles));
+    MESSAGE(fmt::format("{} normalize: {} tiles in {:.3f}s, {:.0f} ns/tile", name, kernelTiles, kernelSeconds,
+                        kernelSeconds * 1e9 / kernelTiles));
+  }
+}
+
+TEST_CASE("normalizeCached should give repeated tiles the same result and warnings as normalize")
+{
+  // The last tile repeats the first, after the middle one has recorded the other red for the same BGR color
+  std::vector<porytiles::RGBATile> tiles{
+      twoColorTile(porytiles::TileType::LAYERED, 0, porytiles::RGBA_RED, porytiles::RGBA_BLUE),
+      twoColorTile(porytiles::TileType::LAYERED, 1, RGBA_OTHER_RED, porytiles::RGBA_BLUE),
+      twoColorTile(porytiles::TileType::LAYERED, 2, porytiles::RGBA_RED, porytiles::RGBA_BLUE)};
+
+  porytiles::PorytilesContext uncachedCtx{};
+  uncachedCtx.err.printErrors = false;
+  uncachedCtx.err.colorPrecisionLoss = porytiles::WarningMode::WARN;
+  porytiles::PorytilesContext cachedCtx{};
+  cachedCtx.err.printErrors = false;
+  cachedCtx.err.colorPrecisionLoss = porytiles::WarningMode::WARN;
+  porytiles::NormalizeCache cache{};
+  for (const auto &tile : tiles) {
+    porytiles::NormalizedTile uncached =
+        porytiles::normalize(uncachedCtx, porytiles::CompilerMode::PRIMARY, std::vector<porytiles::RGBATile>{tile});
+    porytiles::NormalizedTile cached =
+        porytiles::normalizeCached(cachedCtx, porytiles::CompilerMode::PRIMARY, cache, tile);
+    CHECK(cached.frames == uncached.frames);
+    CHECK(cached.palette.size == uncached.palette.size);
+    CHECK(cached.palette.colors == uncached.palette.colors);
+    CHECK(cached.hFlip == uncached.hFlip);
+    CHECK(cached.vFlip == uncached.vFlip);
+    CHECK(cachedCtx.err.warnCount == uncachedCtx.err.warnCount);
+  }
+  CHECK(cache.size() == 2);
+  CHECK(uncachedCtx.err.warnCount == 2);
+
+  REQUIRE(cachedCtx.compilerContext.bgrToRgba.size() == uncachedCtx.compilerContext.bgrToRgba.size());
+  for (const auto &[bgr, uncachedProvenance] : uncachedCtx.compilerContext.bgrToRgba) {
+    CHECK(cachedCtx.compilerContext.bgrToRgba.at(bgr) == uncachedProvenance);
+  }
+}
+
 TEST_CASE("normalizeDecompTiles should correctly normalize all tiles in the decomp tileset")
 {
   porytiles::PorytilesContext ctx{};
@@ -1240,6 +1809,95 @@ TEST_CASE("normalizeDecompTiles should correctly normalize multi-frame animated
   CHECK(indexedNormTiles.at(12).first.tileIndex == 3);
 }
 
+TEST_CASE("normalizeDecompTiles should give the same tiles and warnings regardless of job count")
+{
+  // Both reds share a BGR color, so which tile records them last decides the warnings
+  auto makeTile = [](std::size_t tileIndex, const porytiles::RGBA32 &first, const porytiles::RGBA32 &second) {
+    return twoColorTile(porytiles::TileType::FREESTANDING, tileIndex, first, second);
+  };
+
+  auto normalizeWithJobs = [&](std::size_t jobs) {
+    auto ctx = std::make_unique<porytiles::PorytilesContext>();
+    ctx->err.printErrors = false;
+    ctx->err.colorPrecisionLoss = porytiles::WarningMode::WARN;
+    ctx->compilerConfig.jobs = jobs;
+    porytiles::DecompiledTileset tiles = importFixtureTiles(*ctx, "Resources/Tests/primary_general_emerald_nocache");
+    for (std::size_t i = 0; i < 64; i++) {
+      tiles.tiles.insert(std::begin(tiles.tiles) + static_cast<std::ptrdiff_t>(i * 37),
+                         makeTile(i, i % 2 == 0 ? porytiles::RGBA_RED : RGBA_OTHER_RED, porytiles::RGBA_BLUE));
+    }
+    porytiles::DecompiledAnimation anim{"anim"};
+    anim.frames.emplace_back("00.png");
+    anim.frames.emplace_back("01.png");
+    anim.frames.at(0).tiles = {makeTile(0, porytiles::RGBA_RED, porytiles::RGBA_BLUE),
+                               makeTile(1, porytiles::RGBA_BLUE, porytiles::RGBA_RED)};
+    anim.frames.at(1).tiles = {makeTile(0, RGBA_OTHER_RED, porytiles::RGBA_BLUE),
+                               makeTile(1, porytiles::RGBA_BLUE, RGBA_OTHER_RED)};
+    tiles.anims.push_back(anim);
+    auto [indexedNormTiles, _] = porytiles::normalizeDecompTiles(*ctx, porytiles::CompilerMode::PRIMARY, tiles, {});
+    return std::pair{std::move(ctx), indexedNormTiles};
+  };
+
+  auto [serialCtx, serialTiles] = normalizeWithJobs(1);
+  CHECK(serialCtx->err.warnCount > 0);
+  for (std::size_t jobs : {2, 4, 16}) {
+    auto [parallelCtx, parallelTiles] = normalizeWithJobs(jobs);
+    REQUIRE(parallelTiles.size() == serialTiles.size());
+    for (std::size_t i = 0; i < serialTiles.size(); i++) {
+      CHECK(parallelTiles.at(i).first.animated == serialTiles.at(i).first.animated);
+      CHECK(parallelTiles.at(i).first.tileIndex == serialTiles.at(i).first.tileIndex);
+      CHECK(parallelTiles.at(i).second.frames == serialTiles.at(i).second.frames);
+      CHECK(parallelTiles.at(i).second.palette.colors == serialTiles.at(i).second.palette.colors);
+      CHECK(parallelTiles.at(i).second.hFlip == serialTiles.at(i).second.hFlip);
+      CHECK(parallelTiles.at(i).second.vFlip == serialTiles.at(i).second.vFlip);
+    }
+    CHECK(parallelCtx->err.warnCount == serialCtx->err.warnCount);
+
+    REQUIRE(parallelCtx->compilerContext.bgrToRgba.size() == serialCtx->compilerContext.bgrToRgba.size());
+    for (const auto &[bgr, serialProvenance] : serialCtx->compilerContext.bgrToRgba) {
+      CHECK(parallelCtx->compilerContext.bgrToRgba.at(bgr) == serialProvenance);
+    }
+  }
+}
+
+TEST_CASE("decompiledTile should find the source tile of each normalized tile")
+{
+  porytiles::PorytilesContext ctx{};
+  ctx.err.printErrors = false;
+  porytiles::DecompiledTileset tiles = importFixtureTiles(ctx, "Resources/Tests/primary_general_emerald_nocache");
+  porytiles::DecompiledAnimation anim{"anim"};
+  anim.frames.emplace_back("00.png");
+  anim.frames.emplace_back("01.png");
+  for (auto &frame : anim.frames) {
+    for (std::size_t tileIndex = 0; tileIndex < 2; tileIndex++) {
+      porytiles::RGBATile tile = porytiles::RGBA_TILE_RED;
+      tile.type = porytiles::TileType::ANIM;
+      tile.tileIndex = tileIndex;
+      tile.anim = anim.animName;
+      tile.frame = frame.frameName;
+      frame.tiles.push_back(tile);
+    }
+  }
+  tiles.anims.push_back(anim);
+
+  auto [indexedNormTiles, _] = porytiles::normalizeDecompTiles(ctx, porytiles::CompilerMode::PRIMARY, tiles, {});
+  REQUIRE(indexedNormTiles.size() == tiles.tiles.size() + 2);
+  for (const auto &[index, normalizedTile] : indexedNormTiles) {
+    const porytiles::RGBATile &sourceTile = porytiles::decompiledTile(tiles, index);
+    if (index.animated) {
+      // Anim tiles point at their key frame
+      CHECK(sourceTile.type == porytiles::TileType::ANIM);
+      CHECK(sourceTile.frame == "00.png");
+      CHECK(sourceTile.tileIndex == index.tileIndex);
+    }
+    else {
+      CHECK(&sourceTile == &tiles.tiles.at(index.tileIndex));
+      CHECK(sourceTile.type == porytiles::TileType::LAYERED);
+      CHECK(sourceTile.metatileIndex == index.tileIndex / ctx.fieldmapConfig.numTilesPerMetatile);
+    }
+  }
+}
+
 TEST_CASE("buildColorIndexMaps should build a map of all unique colors in the decomp tileset")
 {
   porytiles::PorytilesContext ctx{};
@@ -1317,22 +1975,25 @@ TEST_CASE("matchNormalizedWithColorSets should return the expected data structur
       porytiles::matchNormalizedWithColorSets(colorToIndex, indexedNormTiles, {});
 
   CHECK(indexedNormTilesWithColorSets.size() == 4);
+  auto normTileAt = [&](std::size_t i) -> const porytiles::NormalizedTile & {
+    CHECK(std::get<1>(indexedNormTilesWithColorSets.at(i)) == i);
+    return indexedNormTiles.at(std::get<1>(indexedNormTilesWithColorSets.at(i))).second;
+  };
   // colorSets size is 3 because first and fourth tiles have the same palette
   CHECK(colorSets.size() == 3);
 
   // First tile has 1 non-transparent color, color should be BLUE
   CHECK(std::get<0>(indexedNormTilesWithColorSets[0]).tileIndex == 0);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[0]).keyFrame().colorIndexes[0] == 0);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[0]).keyFrame().colorIndexes[7] == 1);
+  CHECK(normTileAt(0).keyFrame().colorIndexes[0] == 0);
+  CHECK(normTileAt(0).keyFrame().colorIndexes[7] == 1);
   for (int i = 56; i <= 63; i++) {
-    CHECK(std::get<1>(indexedNormTilesWithColorSets[0]).keyFrame().colorIndexes[i] == 1);
-  }
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[0]).palette.size == 2);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[0]).palette.colors[0] ==
-        porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[0]).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
-  CHECK_FALSE(std::get<1>(indexedNormTilesWithColorSets[0]).hFlip);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[0]).vFlip);
+    CHECK(normTileAt(0).keyFrame().colorIndexes[i] == 1);
+  }
+  CHECK(normTileAt(0).palette.size == 2);
+  CHECK(normTileAt(0).palette.colors[0] == porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
+  CHECK(normTileAt(0).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
+  CHECK_FALSE(normTileAt(0).hFlip);
+  CHECK(normTileAt(0).vFlip);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[0]).count() == 1);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[0]).test(0));
   CHECK(std::find(colorSets.begin(), colorSets.end(), std::get<2>(indexedNormTilesWithColorSets[0])) !=
@@ -1340,18 +2001,17 @@ TEST_CASE("matchNormalizedWithColorSets should return the expected data structur
 
   // Second tile has two non-transparent colors, RED and GREEN
   CHECK(std::get<0>(indexedNormTilesWithColorSets[1]).tileIndex == 1);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).keyFrame().colorIndexes[0] == 0);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).keyFrame().colorIndexes[54] == 1);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).keyFrame().colorIndexes[55] == 1);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).keyFrame().colorIndexes[62] == 1);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).keyFrame().colorIndexes[63] == 2);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).palette.size == 3);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).palette.colors[0] ==
-        porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[1]).palette.colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_RED));
-  CHECK_FALSE(std::get<1>(indexedNormTilesWithColorSets[1]).hFlip);
-  CHECK_FALSE(std::get<1>(indexedNormTilesWithColorSets[1]).vFlip);
+  CHECK(normTileAt(1).keyFrame().colorIndexes[0] == 0);
+  CHECK(normTileAt(1).keyFrame().colorIndexes[54] == 1);
+  CHECK(normTileAt(1).keyFrame().colorIndexes[55] == 1);
+  CHECK(normTileAt(1).keyFrame().colorIndexes[62] == 1);
+  CHECK(normTileAt(1).keyFrame().colorIndexes[63] == 2);
+  CHECK(normTileAt(1).palette.size == 3);
+  CHECK(normTileAt(1).palette.colors[0] == porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
+  CHECK(normTileAt(1).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
+  CHECK(normTileAt(1).palette.colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_RED));
+  CHECK_FALSE(normTileAt(1).hFlip);
+  CHECK_FALSE(normTileAt(1).vFlip);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[1]).count() == 2);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[1]).test(1));
   CHECK(std::get<2>(indexedNormTilesWithColorSets[1]).test(2));
@@ -1360,17 +2020,16 @@ TEST_CASE("matchNormalizedWithColorSets should return the expected data structur
 
   // Third tile has two non-transparent colors, CYAN and GREEN
   CHECK(std::get<0>(indexedNormTilesWithColorSets[2]).tileIndex == 2);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).keyFrame().colorIndexes[0] == 0);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).keyFrame().colorIndexes[7] == 1);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).keyFrame().colorIndexes[56] == 1);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).keyFrame().colorIndexes[63] == 2);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).palette.size == 3);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).palette.colors[0] ==
-        porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_CYAN));
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).palette.colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
-  CHECK_FALSE(std::get<1>(indexedNormTilesWithColorSets[2]).vFlip);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[2]).hFlip);
+  CHECK(normTileAt(2).keyFrame().colorIndexes[0] == 0);
+  CHECK(normTileAt(2).keyFrame().colorIndexes[7] == 1);
+  CHECK(normTileAt(2).keyFrame().colorIndexes[56] == 1);
+  CHECK(normTileAt(2).keyFrame().colorIndexes[63] == 2);
+  CHECK(normTileAt(2).palette.size == 3);
+  CHECK(normTileAt(2).palette.colors[0] == porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
+  CHECK(normTileAt(2).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_CYAN));
+  CHECK(normTileAt(2).palette.colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
+  CHECK_FALSE(normTileAt(2).vFlip);
+  CHECK(normTileAt(2).hFlip);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[2]).count() == 2);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[2]).test(1));
   CHECK(std::get<2>(indexedNormTilesWithColorSets[2]).test(3));
@@ -1379,17 +2038,16 @@ TEST_CASE("matchNormalizedWithColorSets should return the expected data structur
 
   // Fourth tile has 1 non-transparent color, color should be BLUE
   CHECK(std::get<0>(indexedNormTilesWithColorSets[3]).tileIndex == 3);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).keyFrame().colorIndexes[0] == 0);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).keyFrame().colorIndexes[7] == 1);
+  CHECK(normTileAt(3).keyFrame().colorIndexes[0] == 0);
+  CHECK(normTileAt(3).keyFrame().colorIndexes[7] == 1);
   for (int i = 56; i <= 63; i++) {
-    CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).keyFrame().colorIndexes[i] == 1);
-  }
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).palette.size == 2);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).palette.colors[0] ==
-        porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).hFlip);
-  CHECK(std::get<1>(indexedNormTilesWithColorSets[3]).vFlip);
+    CHECK(normTileAt(3).keyFrame().colorIndexes[i] == 1);
+  }
+  CHECK(normTileAt(3).palette.size == 2);
+  CHECK(normTileAt(3).palette.colors[0] == porytiles::rgbaToBgr(porytiles::RGBA_MAGENTA));
+  CHECK(normTileAt(3).palette.colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
+  CHECK(normTileAt(3).hFlip);
+  CHECK(normTileAt(3).vFlip);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[3]).count() == 1);
   CHECK(std::get<2>(indexedNormTilesWithColorSets[3]).test(0));
   CHECK(std::find(colorSets.begin(), colorSets.end(), std::get<2>(indexedNormTilesWithColorSets[3])) !=
@@ -1474,6 +2132,188 @@ TEST_CASE("assign should correctly assign all normalized palettes or fail if imp
   }
 }
 
+TEST_CASE("assignDepthFirstParallel should find the same solution as the serial depth first search")
+{
+  constexpr int SOLUTION_SIZE = 5;
+  porytiles::PorytilesContext ctx{};
+  ctx.fieldmapConfig.numPalettesInPrimary = SOLUTION_SIZE;
+
+  REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/compile_raw_set_1/set.png"}));
+  png::image<png::rgba_pixel> png1{"Resources/Tests/compile_raw_set_1/set.png"};
+  porytiles::DecompiledTileset tiles = porytiles::importTilesFromPng(ctx, porytiles::CompilerMode::PRIMARY, png1);
+  auto [colorToIndex, colorSets] = fixtureColorSets(ctx, tiles);
+
+  std::vector<ColorSet> unassigned;
+  std::copy(std::begin(colorSets), std::end(colorSets), std::back_inserter(unassigned));
+  std::stable_sort(std::begin(unassigned), std::end(unassigned),
+                   [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
+  porytiles::AssignParams params{porytiles::AssignAlgorithm::DFS, 1'000'000, SIZE_MAX, false};
+
+  std::vector<ColorSet> serialSolution;
+  porytiles::AssignSearch serialSearch{params};
+  porytiles::AssignState serialState = {std::vector<ColorSet>(SOLUTION_SIZE), unassigned.size(), 0};
+  REQUIRE(porytiles::assignDepthFirst(ctx, serialSearch, serialState, serialSolution, {}, unassigned, {}) ==
+          porytiles::AssignResult::SUCCESS);
+
+  for (std::size_t jobs : {1, 2, 4, 8}) {
+    std::vector<ColorSet> parallelSolution;
+    porytiles::AssignSearch parallelSearch{params};
+    porytiles::AssignState parallelState = {std::vector<ColorSet>(SOLUTION_SIZE), unassigned.size(), 0};
+    CHECK(porytiles::assignDepthFirstParallel(ctx, parallelSearch, jobs, parallelState, parallelSolution, {},
+                                              unassigned, {}) == porytiles::AssignResult::SUCCESS);
+    CHECK(parallelSolution == serialSolution);
+  }
+
+  SUBCASE("It should enforce the node budget across all jobs")
+  {
+    porytiles::AssignParams tinyBudget{porytiles::AssignAlgorithm::DFS, 10, SIZE_MAX, false};
+    std::vector<ColorSet> solution;
+    porytiles::AssignSearch search{tinyBudget};
+    porytiles::AssignState state = {std::vector<ColorSet>(SOLUTION_SIZE), unassigned.size(), 0};
+    CHECK(porytiles::assignDepthFirstParallel(ctx, search, 4, state, solution, {}, unassigned, {}) ==
+          porytiles::AssignResult::EXPLORE_CUTOFF_REACHED);
+    CHECK(solution.empty());
+    // The split alone spends this budget, so its nodes have to count
+    CHECK(search.exploredNodeCounter == 11);
+  }
+
+  SUBCASE("It should handle more jobs than the tree splits into")
+  {
+    // Two ColorSets cannot split into more than a few tasks
+    std::vector<ColorSet> fewUnassigned{std::end(unassigned) - 2, std::end(unassigned)};
+    std::vector<ColorSet> fewSerialSolution;
+    porytiles::AssignSearch fewSerialSearch{params};
+    porytiles::AssignState fewSerialState = {std::vector<ColorSet>(SOLUTION_SIZE), fewUnassigned.size(), 0};
+    REQUIRE(porytiles::assignDepthFirst(ctx, fewSerialSearch, fewSerialState, fewSerialSolution, {}, fewUnassigned,
+                                        {}) == porytiles::AssignResult::SUCCESS);
+    std::vector<ColorSet> solution;
+    porytiles::AssignSearch search{params};
+    porytiles::AssignState state = {std::vector<ColorSet>(SOLUTION_SIZE), fewUnassigned.size(), 0};
+    CHECK(porytiles::assignDepthFirstParallel(ctx, search, 64, state, solution, {}, fewUnassigned, {}) ==
+          porytiles::AssignResult::SUCCESS);
+    CHECK(solution == fewSerialSolution);
+  }
+
+  SUBCASE("It should time out while splitting the tree")
+  {
+    porytiles::AssignCancelToken expired{};
+    expired.deadline = porytiles::AssignCancelToken::Clock::now() - std::chrono::seconds{1};
+    std::vector<ColorSet> solution;
+    porytiles::AssignSearch search{params};
+    search.cancelToken = &expired;
+    porytiles::AssignState state = {std::vector<ColorSet>(SOLUTION_SIZE), unassigned.size(), 0};
+    CHECK(porytiles::assignDepthFirstParallel(ctx, search, 4, state, solution, {}, unassigned, {}) ==
+          porytiles::AssignResult::CANCELLED);
+    CHECK(search.timedOut);
+    CHECK(search.exploredNodeCounter == 1);
+    CHECK(solution.empty());
+  }
+}
+
+TEST_CASE("benchmark assignment search nodes per second on the primary_general fixtures" * doctest::skip())
+{
+  const std::vector<std::pair<std::string, porytiles::FieldmapConfig>> fixtures{
+      {"Resources/Tests/primary_general_emerald_nocache", porytiles::FieldmapConfig::pokeemeraldDefaults()},
+      {"Resources/Tests/primary_general_firered_nocache", porytiles::FieldmapConfig::pokefireredDefaults()},
+      {"Resources/Tests/primary_general_sinnoh_nocache", porytiles::FieldmapConfig::pokeemeraldDefaults()}};
+  constexpr std::size_t BENCHMARK_NODE_CUTOFF = 250'000;
+  constexpr double BENCHMARK_MIN_SECONDS = 1.0;
+
+  for (const auto &[fixture, fieldmapConfig] : fixtures) {
+    porytiles::PorytilesContext ctx{};
+    ctx.err.printErrors = false;
+    ctx.fieldmapConfig = fieldmapConfig;
+    auto [colorToIndex, colorSets] = fixtureColorSets(ctx, importFixtureTiles(ctx, fixture));
+    std::vector<ColorSet> unassigned{colorSets};
+    std::stable_sort(std::begin(unassigned), std::end(unassigned),
+                     [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
+
+    for (auto algorithm : {porytiles::AssignAlgorithm::DFS, porytiles::AssignAlgorithm::BFS}) {
+      std::size_t totalNodes = 0;
+      std::chrono::duration<double> elapsed{0};
+      while (elapsed.count() < BENCHMARK_MIN_SECONDS) {
+        porytiles::AssignSearch search{porytiles::AssignParams{algorithm, BENCHMARK_NODE_CUTOFF, SIZE_MAX, false}};
+        porytiles::AssignState state = {std::vector<ColorSet>(fieldmapConfig.numPalettesInPrimary), unassigned.size(),
+                                        0};
+        std::vector<ColorSet> solution{};
+        auto start = std::chrono::steady_clock::now();
+        if (algorithm == porytiles::AssignAlgorithm::DFS) {
+          porytiles::assignDepthFirst(ctx, search, state, solution, {}, unassigned, {});
+        }
+        else {
+          porytiles::assignBreadthFirst(ctx, search, state, solution, {}, unassigned, {});
+        }
+        elapsed += std::chrono::steady_clock::now() - start;
+        totalNodes += search.exploredNodeCounter;
+      }
+      MESSAGE(fmt::format("{} {}: {} nodes in {:.3f}s, {:.0f} nodes/sec",
+                          std::filesystem::path{fixture}.filename().string(),
+                          porytiles::assignAlgorithmString(algorithm), totalNodes, elapsed.count(),
+                          totalNodes / elapsed.count()));
+    }
+  }
+}
+
+TEST_CASE("runPaletteAssignmentMatrix should choose the same matrix entry regardless of job count")
+{
+  auto runMatrix = [](std::size_t jobs) {
+    porytiles::PorytilesContext ctx{};
+    ctx.err.printErrors = false;
+    ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+    ctx.fieldmapConfig.numPalettesInPrimary = 5;
+    ctx.compilerConfig.jobs = jobs;
+    ctx.compilerConfig.greedyAssign = false;
+
+    REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/compile_raw_set_1/set.png"}));
+    png::image<png::rgba_pixel> png1{"Resources/Tests/compile_raw_set_1/set.png"};
+    porytiles::DecompiledTileset tiles = porytiles::importTilesFromPng(ctx, porytiles::CompilerMode::PRIMARY, png1);
+    auto [colorToIndex, colorSets] = fixtureColorSets(ctx, tiles);
+
+    auto [solution, primaryPaletteColorSets] =
+        porytiles::runPaletteAssignmentMatrix(ctx, porytiles::CompilerMode::PRIMARY, colorSets, {}, colorToIndex);
+    CHECK(primaryPaletteColorSets.empty());
+    return std::make_pair(solution, porytiles::assignParamsFromConfig(ctx.compilerConfig,
+                                                                      porytiles::CompilerMode::PRIMARY));
+  };
+
+  auto [serialSolution, serialParams] = runMatrix(1);
+  REQUIRE(serialSolution.size() == 5);
+  for (std::size_t jobs : {2, 4, 16}) {
+    auto [parallelSolution, parallelParams] = runMatrix(jobs);
+    CHECK(parallelSolution == serialSolution);
+    CHECK(parallelParams.assignAlgorithm == serialParams.assignAlgorithm);
+    CHECK(parallelParams.exploredNodeCutoff == serialParams.exploredNodeCutoff);
+    CHECK(parallelParams.bestBranches == serialParams.bestBranches);
+    CHECK(parallelParams.smartPrune == serialParams.smartPrune);
+  }
+}
+
+TEST_CASE("runPaletteAssignmentMatrix should start the assign timeout once per compile")
+{
+  porytiles::PorytilesContext ctx{};
+  ctx.err.printErrors = false;
+  ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+  ctx.fieldmapConfig.numPalettesInPrimary = 5;
+  ctx.compilerConfig.assignTimeout = 600;
+
+  REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/compile_raw_set_1/set.png"}));
+  png::image<png::rgba_pixel> png1{"Resources/Tests/compile_raw_set_1/set.png"};
+  porytiles::DecompiledTileset tiles = porytiles::importTilesFromPng(ctx, porytiles::CompilerMode::PRIMARY, png1);
+  auto [colorToIndex, colorSets] = fixtureColorSets(ctx, tiles);
+
+  using Clock = porytiles::AssignCancelToken::Clock;
+  REQUIRE(ctx.compilerContext.assignDeadline == Clock::time_point::max());
+  Clock::time_point before = Clock::now();
+  porytiles::runPaletteAssignmentMatrix(ctx, porytiles::CompilerMode::PRIMARY, colorSets, {}, colorToIndex);
+  Clock::time_point deadline = ctx.compilerContext.assignDeadline;
+  CHECK(deadline >= before + std::chrono::seconds{600});
+  CHECK(deadline <= Clock::now() + std::chrono::seconds{600});
+
+  // A second assignment in the same compile, like compile-secondary's secondary, keeps the clock already running
+  porytiles::runPaletteAssignmentMatrix(ctx, porytiles::CompilerMode::PRIMARY, colorSets, {}, colorToIndex);
+  CHECK(ctx.compilerContext.assignDeadline == deadline);
+}
+
 TEST_CASE("makeTile should create the expected GBATile from the given NormalizedTile and GBAPalette")
 {
   porytiles::PorytilesContext ctx{};
@@ -1482,6 +2322,7 @@ TEST_CASE("makeTile should create the expected GBATile from the given Normalized
   ctx.fieldmapConfig.numTilesInPrimary = 4;
   ctx.compilerConfig.primaryExploredNodeCutoff = 5;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/2x2_pattern_2.png"}));
   png::image<png::rgba_pixel> png1{"Resources/Tests/2x2_pattern_2.png"};
@@ -1537,6 +2378,7 @@ TEST_CASE("compile simple example should perform as expected")
   ctx.fieldmapConfig.numTilesInPrimary = 4;
   ctx.compilerConfig.primaryExploredNodeCutoff = 5;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/2x2_pattern_2.png"}));
   png::image<png::rgba_pixel> png1{"Resources/Tests/2x2_pattern_2.png"};
@@ -1611,6 +2453,7 @@ TEST_CASE("compile function should fill out primary CompiledTileset struct with
   ctx.fieldmapConfig.numPalettesInPrimary = 3;
   ctx.fieldmapConfig.numPalettesTotal = 6;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_3/primary/bottom.png"}));
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_3/primary/middle.png"}));
@@ -1642,17 +2485,17 @@ TEST_CASE("compile function should fill out primary CompiledTileset struct with
   CHECK(compiledPrimary->paletteIndexesOfTile.size() == 16);
   CHECK(compiledPrimary->paletteIndexesOfTile[0] == 0);
   CHECK(compiledPrimary->paletteIndexesOfTile[1] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[2] == 1);
-  CHECK(compiledPrimary->paletteIndexesOfTile[3] == 1);
-  CHECK(compiledPrimary->paletteIndexesOfTile[4] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[2] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[3] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[4] == 1);
 
   // Check that compiled palettes are as expected
   CHECK(compiledPrimary->palettes.size() == ctx.fieldmapConfig.numPalettesInPrimary);
   CHECK(compiledPrimary->palettes.at(0).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
-  CHECK(compiledPrimary->palettes.at(0).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_WHITE));
+  CHECK(compiledPrimary->palettes.at(0).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
+  CHECK(compiledPrimary->palettes.at(0).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
   CHECK(compiledPrimary->palettes.at(1).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
-  CHECK(compiledPrimary->palettes.at(1).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
-  CHECK(compiledPrimary->palettes.at(1).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
+  CHECK(compiledPrimary->palettes.at(1).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_WHITE));
   CHECK(compiledPrimary->palettes.at(2).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
   CHECK(compiledPrimary->palettes.at(2).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_RED));
   CHECK(compiledPrimary->palettes.at(2).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_YELLOW));
@@ -1679,7 +2522,7 @@ TEST_CASE("compile function should fill out primary CompiledTileset struct with
   CHECK_FALSE(compiledPrimary->metatileEntries[3].hFlip);
   CHECK(compiledPrimary->metatileEntries[3].vFlip);
   CHECK(compiledPrimary->metatileEntries[3].tileIndex == 2);
-  CHECK(compiledPrimary->metatileEntries[3].paletteIndex == 1);
+  CHECK(compiledPrimary->metatileEntries[3].paletteIndex == 0);
 
   CHECK_FALSE(compiledPrimary->metatileEntries[4].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[4].vFlip);
@@ -1694,7 +2537,7 @@ TEST_CASE("compile function should fill out primary CompiledTileset struct with
   CHECK_FALSE(compiledPrimary->metatileEntries[6].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[6].vFlip);
   CHECK(compiledPrimary->metatileEntries[6].tileIndex == 3);
-  CHECK(compiledPrimary->metatileEntries[6].paletteIndex == 1);
+  CHECK(compiledPrimary->metatileEntries[6].paletteIndex == 0);
 
   CHECK_FALSE(compiledPrimary->metatileEntries[7].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[7].vFlip);
@@ -1709,7 +2552,7 @@ TEST_CASE("compile function should fill out primary CompiledTileset struct with
   CHECK_FALSE(compiledPrimary->metatileEntries[9].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[9].vFlip);
   CHECK(compiledPrimary->metatileEntries[9].tileIndex == 4);
-  CHECK(compiledPrimary->metatileEntries[9].paletteIndex == 0);
+  CHECK(compiledPrimary->metatileEntries[9].paletteIndex == 1);
 
   CHECK_FALSE(compiledPrimary->metatileEntries[10].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[10].vFlip);
@@ -1751,6 +2594,7 @@ TEST_CASE("compile function should fill out secondary CompiledTileset struct wit
   ctx.fieldmapConfig.numPalettesInPrimary = 3;
   ctx.fieldmapConfig.numPalettesTotal = 6;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_3/primary/bottom.png"}));
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_3/primary/middle.png"}));
@@ -1791,29 +2635,29 @@ TEST_CASE("compile function should fill out secondary CompiledTileset struct wit
 
   // Check that paletteIndexesOfTile are correct
   CHECK(compiledSecondary->paletteIndexesOfTile[0] == 2);
-  CHECK(compiledSecondary->paletteIndexesOfTile[1] == 3);
-  CHECK(compiledSecondary->paletteIndexesOfTile[2] == 3);
-  CHECK(compiledSecondary->paletteIndexesOfTile[3] == 3);
-  CHECK(compiledSecondary->paletteIndexesOfTile[4] == 3);
-  CHECK(compiledSecondary->paletteIndexesOfTile[5] == 5);
+  CHECK(compiledSecondary->paletteIndexesOfTile[1] == 5);
+  CHECK(compiledSecondary->paletteIndexesOfTile[2] == 5);
+  CHECK(compiledSecondary->paletteIndexesOfTile[3] == 5);
+  CHECK(compiledSecondary->paletteIndexesOfTile[4] == 5);
+  CHECK(compiledSecondary->paletteIndexesOfTile[5] == 3);
 
   // Check that compiled palettes are as expected
   CHECK(compiledSecondary->palettes.at(0).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
-  CHECK(compiledSecondary->palettes.at(0).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_WHITE));
+  CHECK(compiledSecondary->palettes.at(0).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
+  CHECK(compiledSecondary->palettes.at(0).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
   CHECK(compiledSecondary->palettes.at(1).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
-  CHECK(compiledSecondary->palettes.at(1).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREEN));
-  CHECK(compiledSecondary->palettes.at(1).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
+  CHECK(compiledSecondary->palettes.at(1).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_WHITE));
   CHECK(compiledSecondary->palettes.at(2).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
   CHECK(compiledSecondary->palettes.at(2).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_RED));
   CHECK(compiledSecondary->palettes.at(2).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_YELLOW));
   CHECK(compiledSecondary->palettes.at(3).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
-  CHECK(compiledSecondary->palettes.at(3).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
-  CHECK(compiledSecondary->palettes.at(3).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_CYAN));
-  CHECK(compiledSecondary->palettes.at(3).colors[3] == porytiles::rgbaToBgr(porytiles::RGBA_PURPLE));
-  CHECK(compiledSecondary->palettes.at(3).colors[4] == porytiles::rgbaToBgr(porytiles::RGBA_LIME));
+  CHECK(compiledSecondary->palettes.at(3).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREY));
   CHECK(compiledSecondary->palettes.at(4).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
   CHECK(compiledSecondary->palettes.at(5).colors[0] == porytiles::rgbaToBgr(ctx.compilerConfig.transparencyColor));
-  CHECK(compiledSecondary->palettes.at(5).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_GREY));
+  CHECK(compiledSecondary->palettes.at(5).colors[1] == porytiles::rgbaToBgr(porytiles::RGBA_BLUE));
+  CHECK(compiledSecondary->palettes.at(5).colors[2] == porytiles::rgbaToBgr(porytiles::RGBA_CYAN));
+  CHECK(compiledSecondary->palettes.at(5).colors[3] == porytiles::rgbaToBgr(porytiles::RGBA_PURPLE));
+  CHECK(compiledSecondary->palettes.at(5).colors[4] == porytiles::rgbaToBgr(porytiles::RGBA_LIME));
 
   // Check that all metatile entries are correct
   CHECK(compiledSecondary->metatileEntries.size() ==
@@ -1832,7 +2676,7 @@ TEST_CASE("compile function should fill out secondary CompiledTileset struct wit
   CHECK_FALSE(compiledSecondary->metatileEntries[2].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[2].vFlip);
   CHECK(compiledSecondary->metatileEntries[2].tileIndex == 1 + ctx.fieldmapConfig.numTilesInPrimary);
-  CHECK(compiledSecondary->metatileEntries[2].paletteIndex == 3);
+  CHECK(compiledSecondary->metatileEntries[2].paletteIndex == 5);
 
   CHECK_FALSE(compiledSecondary->metatileEntries[3].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[3].vFlip);
@@ -1847,12 +2691,12 @@ TEST_CASE("compile function should fill out secondary CompiledTileset struct wit
   CHECK_FALSE(compiledSecondary->metatileEntries[5].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[5].vFlip);
   CHECK(compiledSecondary->metatileEntries[5].tileIndex == 2 + ctx.fieldmapConfig.numTilesInPrimary);
-  CHECK(compiledSecondary->metatileEntries[5].paletteIndex == 3);
+  CHECK(compiledSecondary->metatileEntries[5].paletteIndex == 5);
 
   CHECK_FALSE(compiledSecondary->metatileEntries[6].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[6].vFlip);
   CHECK(compiledSecondary->metatileEntries[6].tileIndex == 3 + ctx.fieldmapConfig.numTilesInPrimary);
-  CHECK(compiledSecondary->metatileEntries[6].paletteIndex == 3);
+  CHECK(compiledSecondary->metatileEntries[6].paletteIndex == 5);
 
   CHECK_FALSE(compiledSecondary->metatileEntries[7].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[7].vFlip);
@@ -1862,7 +2706,7 @@ TEST_CASE("compile function should fill out secondary CompiledTileset struct wit
   CHECK_FALSE(compiledSecondary->metatileEntries[8].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[8].vFlip);
   CHECK(compiledSecondary->metatileEntries[8].tileIndex == 4 + ctx.fieldmapConfig.numTilesInPrimary);
-  CHECK(compiledSecondary->metatileEntries[8].paletteIndex == 3);
+  CHECK(compiledSecondary->metatileEntries[8].paletteIndex == 5);
 
   CHECK_FALSE(compiledSecondary->metatileEntries[9].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[9].vFlip);
@@ -1877,7 +2721,7 @@ TEST_CASE("compile function should fill out secondary CompiledTileset struct wit
   CHECK(compiledSecondary->metatileEntries[11].hFlip);
   CHECK(compiledSecondary->metatileEntries[11].vFlip);
   CHECK(compiledSecondary->metatileEntries[11].tileIndex == 5 + ctx.fieldmapConfig.numTilesInPrimary);
-  CHECK(compiledSecondary->metatileEntries[11].paletteIndex == 5);
+  CHECK(compiledSecondary->metatileEntries[11].paletteIndex == 3);
 
   for (std::size_t index = ctx.fieldmapConfig.numTilesPerMetatile;
        index < porytiles::METATILES_IN_ROW * ctx.fieldmapConfig.numTilesPerMetatile; index++) {
@@ -1914,6 +2758,7 @@ TEST_CASE("compile function should correctly compile primary set with animated t
   ctx.fieldmapConfig.numPalettesInPrimary = 3;
   ctx.fieldmapConfig.numPalettesTotal = 6;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_1/primary/bottom.png"}));
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_1/primary/middle.png"}));
@@ -1984,15 +2829,15 @@ TEST_CASE("compile function should correctly compile primary set with animated t
   // Check that paletteIndexesOfTile is correct
   CHECK(compiledPrimary->paletteIndexesOfTile.size() == 16);
   CHECK(compiledPrimary->paletteIndexesOfTile[0] == 0);
-  CHECK(compiledPrimary->paletteIndexesOfTile[1] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[2] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[3] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[4] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[5] == 1);
-  CHECK(compiledPrimary->paletteIndexesOfTile[6] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[7] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[8] == 2);
-  CHECK(compiledPrimary->paletteIndexesOfTile[9] == 2);
+  CHECK(compiledPrimary->paletteIndexesOfTile[1] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[2] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[3] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[4] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[5] == 2);
+  CHECK(compiledPrimary->paletteIndexesOfTile[6] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[7] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[8] == 0);
+  CHECK(compiledPrimary->paletteIndexesOfTile[9] == 0);
 
   // Check that all metatile entries are correct
   CHECK(compiledPrimary->metatileEntries.size() ==
@@ -2019,19 +2864,19 @@ TEST_CASE("compile function should correctly compile primary set with animated t
   CHECK(compiledPrimary->metatileEntries[4].hFlip);
   CHECK(compiledPrimary->metatileEntries[4].vFlip);
   CHECK(compiledPrimary->metatileEntries[4].tileIndex == 6);
-  CHECK(compiledPrimary->metatileEntries[4].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[4].paletteIndex == 0);
   CHECK(compiledPrimary->metatileEntries[5].hFlip);
   CHECK(compiledPrimary->metatileEntries[5].vFlip);
   CHECK(compiledPrimary->metatileEntries[5].tileIndex == 7);
-  CHECK(compiledPrimary->metatileEntries[5].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[5].paletteIndex == 0);
   CHECK_FALSE(compiledPrimary->metatileEntries[6].hFlip);
   CHECK(compiledPrimary->metatileEntries[6].vFlip);
   CHECK(compiledPrimary->metatileEntries[6].tileIndex == 8);
-  CHECK(compiledPrimary->metatileEntries[6].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[6].paletteIndex == 0);
   CHECK(compiledPrimary->metatileEntries[7].hFlip);
   CHECK(compiledPrimary->metatileEntries[7].vFlip);
   CHECK(compiledPrimary->metatileEntries[7].tileIndex == 9);
-  CHECK(compiledPrimary->metatileEntries[7].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[7].paletteIndex == 0);
   // Metatile 0 top
   CHECK_FALSE(compiledPrimary->metatileEntries[8].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[8].vFlip);
@@ -2054,36 +2899,36 @@ TEST_CASE("compile function should correctly compile primary set with animated t
   CHECK(compiledPrimary->metatileEntries[12].hFlip);
   CHECK(compiledPrimary->metatileEntries[12].vFlip);
   CHECK(compiledPrimary->metatileEntries[12].tileIndex == 6);
-  CHECK(compiledPrimary->metatileEntries[12].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[12].paletteIndex == 0);
   CHECK(compiledPrimary->metatileEntries[13].hFlip);
   CHECK(compiledPrimary->metatileEntries[13].vFlip);
   CHECK(compiledPrimary->metatileEntries[13].tileIndex == 7);
-  CHECK(compiledPrimary->metatileEntries[13].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[13].paletteIndex == 0);
   CHECK_FALSE(compiledPrimary->metatileEntries[14].hFlip);
   CHECK(compiledPrimary->metatileEntries[14].vFlip);
   CHECK(compiledPrimary->metatileEntries[14].tileIndex == 8);
-  CHECK(compiledPrimary->metatileEntries[14].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[14].paletteIndex == 0);
   CHECK(compiledPrimary->metatileEntries[15].hFlip);
   CHECK(compiledPrimary->metatileEntries[15].vFlip);
   CHECK(compiledPrimary->metatileEntries[15].tileIndex == 9);
-  CHECK(compiledPrimary->metatileEntries[15].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[15].paletteIndex == 0);
   // Metatile 1 middle
   CHECK_FALSE(compiledPrimary->metatileEntries[16].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[16].vFlip);
   CHECK(compiledPrimary->metatileEntries[16].tileIndex == 1);
-  CHECK(compiledPrimary->metatileEntries[16].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[16].paletteIndex == 0);
   CHECK_FALSE(compiledPrimary->metatileEntries[17].hFlip);
   CHECK_FALSE(compiledPrimary->metatileEntries[17].vFlip);
   CHECK(compiledPrimary->metatileEntries[17].tileIndex == 2);
-  CHECK(compiledPrimary->metatileEntries[17].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[17].paletteIndex == 0);
   CHECK_FALSE(compiledPrimary->metatileEntries[18].hFlip);
   CHECK(compiledPrimary->metatileEntries[18].vFlip);
   CHECK(compiledPrimary->metatileEntries[18].tileIndex == 3);
-  CHECK(compiledPrimary->metatileEntries[18].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[18].paletteIndex == 0);
   CHECK(compiledPrimary->metatileEntries[19].hFlip);
   CHECK(compiledPrimary->metatileEntries[19].vFlip);
   CHECK(compiledPrimary->metatileEntries[19].tileIndex == 4);
-  CHECK(compiledPrimary->metatileEntries[19].paletteIndex == 2);
+  CHECK(compiledPrimary->metatileEntries[19].paletteIndex == 0);
   // Metatile 1 top is blank, don't bother testing
 
   // Metatile 2 bottom is blank, don't bother testing
@@ -2091,19 +2936,19 @@ TEST_CASE("compile function should correctly compile primary set with animated t
   CHECK_FALSE(compiledPrimary->metatileEntries[28].hFlip);
   CHECK(compiledPrimary->metatileEntries[28].vFlip);
   CHECK(compiledPrimary->metatileEntries[28].tileIndex == 5);
-  CHECK(compiledPrimary->metatileEntries[28].paletteIndex == 1);
+  CHECK(compiledPrimary->metatileEntries[28].paletteIndex == 2);
   CHECK_FALSE(compiledPrimary->metatileEntries[29].hFlip);
   CHECK(compiledPrimary->metatileEntries[29].vFlip);
   CHECK(compiledPrimary->metatileEntries[29].tileIndex == 5);
-  CHECK(compiledPrimary->metatileEntries[29].paletteIndex == 1);
+  CHECK(compiledPrimary->metatileEntries[29].paletteIndex == 2);
   CHECK_FALSE(compiledPrimary->metatileEntries[30].hFlip);
   CHECK(compiledPrimary->metatileEntries[30].vFlip);
   CHECK(compiledPrimary->metatileEntries[30].tileIndex == 5);
-  CHECK(compiledPrimary->metatileEntries[30].paletteIndex == 1);
+  CHECK(compiledPrimary->metatileEntries[30].paletteIndex == 2);
   CHECK_FALSE(compiledPrimary->metatileEntries[31].hFlip);
   CHECK(compiledPrimary->metatileEntries[31].vFlip);
   CHECK(compiledPrimary->metatileEntries[31].tileIndex == 5);
-  CHECK(compiledPrimary->metatileEntries[31].paletteIndex == 1);
+  CHECK(compiledPrimary->metatileEntries[31].paletteIndex == 2);
   // Metatile 2 top is blank, don't bother testing
 
   // Verify integrity of anims structure
@@ -2128,6 +2973,7 @@ TEST_CASE("compile function should correctly compile secondary set with animated
   ctx.fieldmapConfig.numPalettesTotal = 6;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
   ctx.compilerConfig.secondaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_1/primary/bottom.png"}));
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_1/primary/middle.png"}));
@@ -2271,19 +3117,19 @@ TEST_CASE("compile function should correctly compile secondary set with animated
   CHECK_FALSE(compiledSecondary->metatileEntries[4].hFlip);
   CHECK(compiledSecondary->metatileEntries[4].vFlip);
   CHECK(compiledSecondary->metatileEntries[4].tileIndex == 5);
-  CHECK(compiledSecondary->metatileEntries[4].paletteIndex == 1);
+  CHECK(compiledSecondary->metatileEntries[4].paletteIndex == 2);
   CHECK_FALSE(compiledSecondary->metatileEntries[5].hFlip);
   CHECK(compiledSecondary->metatileEntries[5].vFlip);
   CHECK(compiledSecondary->metatileEntries[5].tileIndex == 5);
-  CHECK(compiledSecondary->metatileEntries[5].paletteIndex == 1);
+  CHECK(compiledSecondary->metatileEntries[5].paletteIndex == 2);
   CHECK_FALSE(compiledSecondary->metatileEntries[6].hFlip);
   CHECK(compiledSecondary->metatileEntries[6].vFlip);
   CHECK(compiledSecondary->metatileEntries[6].tileIndex == 5);
-  CHECK(compiledSecondary->metatileEntries[6].paletteIndex == 1);
+  CHECK(compiledSecondary->metatileEntries[6].paletteIndex == 2);
   CHECK_FALSE(compiledSecondary->metatileEntries[7].hFlip);
   CHECK(compiledSecondary->metatileEntries[7].vFlip);
   CHECK(compiledSecondary->metatileEntries[7].tileIndex == 5);
-  CHECK(compiledSecondary->metatileEntries[7].paletteIndex == 1);
+  CHECK(compiledSecondary->metatileEntries[7].paletteIndex == 2);
   // Metatile 0 top
   CHECK_FALSE(compiledSecondary->metatileEntries[8].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[8].vFlip);
@@ -2306,19 +3152,19 @@ TEST_CASE("compile function should correctly compile secondary set with animated
   CHECK(compiledSecondary->metatileEntries[12].hFlip);
   CHECK(compiledSecondary->metatileEntries[12].vFlip);
   CHECK(compiledSecondary->metatileEntries[12].tileIndex == 6);
-  CHECK(compiledSecondary->metatileEntries[12].paletteIndex == 2);
+  CHECK(compiledSecondary->metatileEntries[12].paletteIndex == 0);
   CHECK(compiledSecondary->metatileEntries[13].hFlip);
   CHECK(compiledSecondary->metatileEntries[13].vFlip);
   CHECK(compiledSecondary->metatileEntries[13].tileIndex == 7);
-  CHECK(compiledSecondary->metatileEntries[13].paletteIndex == 2);
+  CHECK(compiledSecondary->metatileEntries[13].paletteIndex == 0);
   CHECK_FALSE(compiledSecondary->metatileEntries[14].hFlip);
   CHECK(compiledSecondary->metatileEntries[14].vFlip);
   CHECK(compiledSecondary->metatileEntries[14].tileIndex == 8);
-  CHECK(compiledSecondary->metatileEntries[14].paletteIndex == 2);
+  CHECK(compiledSecondary->metatileEntries[14].paletteIndex == 0);
   CHECK(compiledSecondary->metatileEntries[15].hFlip);
   CHECK(compiledSecondary->metatileEntries[15].vFlip);
   CHECK(compiledSecondary->metatileEntries[15].tileIndex == 9);
-  CHECK(compiledSecondary->metatileEntries[15].paletteIndex == 2);
+  CHECK(compiledSecondary->metatileEntries[15].paletteIndex == 0);
   // Metatile 1 middle
   CHECK_FALSE(compiledSecondary->metatileEntries[16].hFlip);
   CHECK_FALSE(compiledSecondary->metatileEntries[16].vFlip);
@@ -2374,6 +3220,7 @@ TEST_CASE("primer tiles should change output of primary compile function")
   ctx.fieldmapConfig.numPalettesInPrimary = 4;
   ctx.fieldmapConfig.numPalettesTotal = 6;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
   ctx.compilerConfig.primarySmartPrune = true;
   ctx.compilerConfig.cacheAssign = false;
 
@@ -2423,26 +3270,26 @@ TEST_CASE("primer tiles should change output of primary compile function")
   auto compiledPrimer = porytiles::compile(ctx, porytiles::CompilerMode::PRIMARY, decompiled, palettePrimers);
 
   // Confirm compiled with primer is as expected
-  for (std::size_t i = 0; i < 3; i++) {
+  CHECK(compiledPrimer->palettes.at(0).colors.at(0) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 0, 255}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(1) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 255, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(2) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(3) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 255, 255}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(4) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 255, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(5) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(6) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 255}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(7) == porytiles::rgbaToBgr(porytiles::RGBA32{128, 128, 128}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(8) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 255, 255}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(9) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(10) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(11) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(12) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(13) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(14) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  CHECK(compiledPrimer->palettes.at(0).colors.at(15) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
+  for (std::size_t i = 1; i < 4; i++) {
     CHECK(compiledPrimer->palettes.at(i).colors.at(0) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 0, 255}));
     for (std::size_t j = 1; j < porytiles::PAL_SIZE; j++) {
       CHECK(compiledPrimer->palettes.at(i).colors.at(j) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
     }
   }
-  CHECK(compiledPrimer->palettes.at(3).colors.at(0) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 0, 255}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(1) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 255, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(2) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(3) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 255, 255}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(4) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 255, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(5) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(6) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 255}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(7) == porytiles::rgbaToBgr(porytiles::RGBA32{128, 128, 128}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(8) == porytiles::rgbaToBgr(porytiles::RGBA32{255, 255, 255}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(9) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(10) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(11) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(12) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(13) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(14) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
-  CHECK(compiledPrimer->palettes.at(3).colors.at(15) == porytiles::rgbaToBgr(porytiles::RGBA32{0, 0, 0}));
 }
@@ -540,6 +540,20 @@ static void driveEmitAssignCache(PorytilesContext &ctx, CompilerMode compilerMod
   outAssignCache.close();
 }
 
+static void driveEmitAssignStats(PorytilesContext &ctx, CompilerMode compilerMode)
+{
+  std::ofstream outAssignStats{ctx.compilerConfig.assignStatsPath};
+  if (outAssignStats.good()) {
+    emitAssignStats(ctx, outAssignStats);
+  }
+  else {
+    fatalerror(ctx.err, ctx.compilerSrcPaths, compilerMode,
+               fmt::format("{}: stats write failed, please make sure the file is writable",
+                           ctx.compilerConfig.assignStatsPath));
+  }
+  outAssignStats.close();
+}
+
 static void driveEmitCompiledTileset(PorytilesContext &ctx, CompilerMode compilerMode, const CompiledTileset &tileset,
                                      const std::unordered_map<size_t, Attributes> &attributesMap,
                                      const std::unordered_map<std::uint8_t, std::string> &behaviorReverseMap)
@@ -700,6 +714,10 @@ driveCompileTileset(PorytilesContext &ctx, CompilerMode compilerMode, CompilerMo
   if (ctx.compilerConfig.cacheAssign) {
     driveEmitAssignCache(ctx, compilerMode, ctx.compilerSrcPaths.modeBasedAssignCachePath(compilerMode));
   }
+  // Rewritten after each tileset, so the paired primary's stats survive even if the secondary then fails to compile
+  if (!ctx.compilerConfig.assignStatsPath.empty()) {
+    driveEmitAssignStats(ctx, compilerMode);
+  }
 
   return std::pair{std::move(compiledTileset), attributesMap};
 }
@@ -991,6 +1009,7 @@ TEST_CASE("drive should emit all expected files for anim_metatiles_2 primary set
   ctx.err.printErrors = false;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
   ctx.compilerConfig.secondaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
   ctx.compilerConfig.cacheAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_2/primary"}));
@@ -1147,6 +1166,108 @@ TEST_CASE("drive should emit all expected files for anim_metatiles_2 primary set
   std::filesystem::remove_all(parentDir);
 }
 
+TEST_CASE("drive should emit all expected files for anim_metatiles_2 primary set with the greedy pre-pass")
+{
+  porytiles::PorytilesContext ctx{};
+  std::filesystem::path parentDir = porytiles::createTmpdir();
+  ctx.output.path = parentDir / std::filesystem::path{"output"};
+  ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+  ctx.err.printErrors = false;
+  ctx.compilerConfig.cacheAssign = false;
+
+  /*
+   * The fixture's assign.cache holds params that already assign its palettes, so they would win before the greedy
+   * pre-pass ever ran. Compile a copy without it, like a project compiled for the first time would be.
+   */
+  REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_2/primary"}));
+  std::filesystem::path sourcePath = parentDir / std::filesystem::path{"primary"};
+  std::filesystem::copy("Resources/Tests/anim_metatiles_2/primary", sourcePath,
+                        std::filesystem::copy_options::recursive);
+  std::filesystem::remove(sourcePath / std::filesystem::path{"assign.cache"});
+  ctx.compilerSrcPaths.primarySourcePath = sourcePath;
+  REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/metatile_behaviors.h"}));
+  ctx.compilerSrcPaths.metatileBehaviors = "Resources/Tests/metatile_behaviors.h";
+
+  porytiles::drive(ctx);
+
+  /*
+   * Greedy packs the palettes differently from the DFS params in the cache, so tiles.png and metatiles.bin get their
+   * own expected files. Attributes and anim frames come out the same as the DFS compile.
+   */
+  auto checkPngIndexes = [](const std::filesystem::path &expectedPath, const std::filesystem::path &actualPath) {
+    REQUIRE(std::filesystem::exists(expectedPath));
+    REQUIRE(std::filesystem::exists(actualPath));
+    png::image<png::index_pixel> expectedPng{expectedPath};
+    png::image<png::index_pixel> actualPng{actualPath};
+    REQUIRE(expectedPng.get_width() == actualPng.get_width());
+    REQUIRE(expectedPng.get_height() == actualPng.get_height());
+    for (std::size_t pixelRow = 0; pixelRow < actualPng.get_height(); pixelRow++) {
+      for (std::size_t pixelCol = 0; pixelCol < actualPng.get_width(); pixelCol++) {
+        CHECK(expectedPng[pixelRow][pixelCol] == actualPng[pixelRow][pixelCol]);
+      }
+    }
+  };
+
+  checkPngIndexes("Resources/Tests/anim_metatiles_2/primary/expected_greedy_tiles.png",
+                  ctx.output.path / std::filesystem::path{"tiles.png"});
+  porytiles::doctestAssertFileBytesIdentical(
+      std::filesystem::path{"Resources/Tests/anim_metatiles_2/primary/expected_greedy_metatiles.bin"},
+      ctx.output.path / std::filesystem::path{"metatiles.bin"});
+  porytiles::doctestAssertFileBytesIdentical(
+      std::filesystem::path{"Resources/Tests/anim_metatiles_2/primary/expected_metatile_attributes.bin"},
+      ctx.output.path / std::filesystem::path{"metatile_attributes.bin"});
+  for (const auto *frame : {"flower_white/00.png", "flower_white/01.png", "flower_white/02.png", "water/00.png",
+                            "water/01.png"}) {
+    checkPngIndexes(std::filesystem::path{"Resources/Tests/anim_metatiles_2/primary/expected_anim"} / frame,
+                    ctx.output.path / std::filesystem::path{"anim"} / frame);
+  }
+
+  std::filesystem::remove_all(parentDir);
+}
+
+TEST_CASE("drive should read back the assign.cache a greedy compile of anim_metatiles_2 primary writes")
+{
+  std::filesystem::path parentDir = porytiles::createTmpdir();
+
+  // Start from a copy without assign.cache, so the first compile is greedy's and writes a fresh cache
+  REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_2/primary"}));
+  std::filesystem::path sourcePath = parentDir / std::filesystem::path{"primary"};
+  std::filesystem::copy("Resources/Tests/anim_metatiles_2/primary", sourcePath,
+                        std::filesystem::copy_options::recursive);
+  std::filesystem::remove(sourcePath / std::filesystem::path{"assign.cache"});
+  REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/metatile_behaviors.h"}));
+
+  auto compile = [&](const std::string &outputName) {
+    porytiles::PorytilesContext ctx{};
+    ctx.output.path = parentDir / std::filesystem::path{outputName};
+    ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+    ctx.err.printErrors = false;
+    ctx.err.invalidAssignCache = porytiles::WarningMode::WARN;
+    ctx.compilerSrcPaths.primarySourcePath = sourcePath;
+    ctx.compilerSrcPaths.metatileBehaviors = "Resources/Tests/metatile_behaviors.h";
+    porytiles::drive(ctx);
+    return ctx.err.warnCount;
+  };
+
+  compile("output1");
+  std::filesystem::path cachePath = sourcePath / std::filesystem::path{"assign.cache"};
+  REQUIRE(std::filesystem::exists(cachePath));
+  std::ifstream cacheFile{cachePath};
+  std::string firstLine;
+  std::getline(cacheFile, firstLine);
+  cacheFile.close();
+  CHECK(firstLine == "assign-algorithm=greedy");
+
+  // The second compile reads the cache back and reuses its palettes, so it emits the same files
+  CHECK(compile("output2") == 0);
+  for (const auto *file : {"tiles.png", "metatiles.bin", "metatile_attributes.bin"}) {
+    porytiles::doctestAssertFileBytesIdentical(parentDir / std::filesystem::path{"output1"} / file,
+                                               parentDir / std::filesystem::path{"output2"} / file);
+  }
+
+  std::filesystem::remove_all(parentDir);
+}
+
 TEST_CASE("drive should emit all expected files for anim_metatiles_2 secondary set")
 {
   porytiles::PorytilesContext ctx{};
@@ -1156,6 +1277,7 @@ TEST_CASE("drive should emit all expected files for anim_metatiles_2 secondary s
   ctx.err.printErrors = false;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
   ctx.compilerConfig.secondaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
   ctx.compilerConfig.cacheAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/anim_metatiles_2/primary"}));
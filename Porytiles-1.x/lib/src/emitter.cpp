@@ -356,28 +356,131 @@ void emitDecompiled(PorytilesContext &ctx, DecompilerMode mode, png::image<png::
   }
 }
 
+static void emitCachedSolution(const std::vector<std::vector<BGR15>> &solution, std::ostream &out)
+{
+  if (solution.empty()) {
+    return;
+  }
+  for (const auto &palette : solution) {
+    out << SOLUTION_PALETTE << "=";
+    for (std::size_t i = 0; i < palette.size(); i++) {
+      out << (i == 0 ? "" : ",") << fmt::format("{:04x}", palette.at(i).bgr);
+    }
+    out << std::endl;
+  }
+}
+
 void emitAssignCache(PorytilesContext &ctx, const CompilerMode &mode, std::ostream &out)
 {
   if (mode == CompilerMode::PRIMARY) {
     out << ASSIGN_ALGO << "=" << assignAlgorithmString(ctx.compilerConfig.primaryAssignAlgorithm) << std::endl;
-    out << EXPLORE_CUTOFF << "=" << ctx.compilerConfig.primaryExploredNodeCutoff << std::endl;
-    if (ctx.compilerConfig.primarySmartPrune) {
-      out << BEST_BRANCHES << "=smart" << std::endl;
+    // The greedy pre-pass does not search and the component split uses fixed params, so neither has any to save
+    if (ctx.compilerConfig.primaryAssignAlgorithm != AssignAlgorithm::GREEDY &&
+        ctx.compilerConfig.primaryAssignAlgorithm != AssignAlgorithm::COMPONENTS) {
+      out << EXPLORE_CUTOFF << "=" << ctx.compilerConfig.primaryExploredNodeCutoff << std::endl;
+      if (ctx.compilerConfig.primarySmartPrune) {
+        out << BEST_BRANCHES << "=smart" << std::endl;
+      }
+      else {
+        out << BEST_BRANCHES << "=" << ctx.compilerConfig.primaryBestBranches << std::endl;
+      }
     }
-    else {
-      out << BEST_BRANCHES << "=" << ctx.compilerConfig.primaryBestBranches << std::endl;
+    // Only beam search reads the beam width, so leave it out otherwise to keep the cache unchanged for other algorithms
+    if (ctx.compilerConfig.primaryAssignAlgorithm == AssignAlgorithm::BEAM) {
+      out << BEAM_WIDTH << "=" << ctx.compilerConfig.primaryBeamWidth << std::endl;
+    }
+    if (ctx.compilerConfig.primaryAssignSeed != 0) {
+      out << ASSIGN_SEED << "=" << ctx.compilerConfig.primaryAssignSeed << std::endl;
     }
+    emitCachedSolution(ctx.compilerConfig.primaryCachedSolution, out);
   }
   else if (mode == CompilerMode::SECONDARY) {
     out << ASSIGN_ALGO << "=" << assignAlgorithmString(ctx.compilerConfig.secondaryAssignAlgorithm) << std::endl;
-    out << EXPLORE_CUTOFF << "=" << ctx.compilerConfig.secondaryExploredNodeCutoff << std::endl;
-    if (ctx.compilerConfig.secondarySmartPrune) {
-      out << BEST_BRANCHES << "=smart" << std::endl;
+    if (ctx.compilerConfig.secondaryAssignAlgorithm != AssignAlgorithm::GREEDY &&
+        ctx.compilerConfig.secondaryAssignAlgorithm != AssignAlgorithm::COMPONENTS) {
+      out << EXPLORE_CUTOFF << "=" << ctx.compilerConfig.secondaryExploredNodeCutoff << std::endl;
+      if (ctx.compilerConfig.secondarySmartPrune) {
+        out << BEST_BRANCHES << "=smart" << std::endl;
+      }
+      else {
+        out << BEST_BRANCHES << "=" << ctx.compilerConfig.secondaryBestBranches << std::endl;
+      }
+    }
+    if (ctx.compilerConfig.secondaryAssignAlgorithm == AssignAlgorithm::BEAM) {
+      out << BEAM_WIDTH << "=" << ctx.compilerConfig.secondaryBeamWidth << std::endl;
+    }
+    if (ctx.compilerConfig.secondaryAssignSeed != 0) {
+      out << ASSIGN_SEED << "=" << ctx.compilerConfig.secondaryAssignSeed << std::endl;
+    }
+    emitCachedSolution(ctx.compilerConfig.secondaryCachedSolution, out);
+  }
+}
+
+static std::string jsonCountArray(const std::vector<std::size_t> &counts)
+{
+  std::string array = "[";
+  for (std::size_t i = 0; i < counts.size(); i++) {
+    array += fmt::format("{}{}", i == 0 ? "" : ", ", counts.at(i));
+  }
+  return array + "]";
+}
+
+void emitAssignStats(PorytilesContext &ctx, std::ostream &out)
+{
+  out << "{" << std::endl;
+  out << "  \"attempts\": [";
+  const auto &reports = ctx.compilerContext.assignReports;
+  for (std::size_t i = 0; i < reports.size(); i++) {
+    const AssignAttemptReport &report = reports.at(i);
+    const AssignStats &stats = report.stats;
+    double nodesPerSecond = stats.seconds > 0 ? static_cast<double>(stats.exploredNodes) / stats.seconds : 0;
+    out << (i == 0 ? "" : ",") << std::endl;
+    out << "    {" << std::endl;
+    out << "      \"mode\": \"" << compilerModeString(report.mode) << "\"," << std::endl;
+    out << "      \"source\": \"" << report.source << "\"," << std::endl;
+    if (report.source == "matrix") {
+      out << "      \"matrixEntry\": " << report.matrixEntry << "," << std::endl;
+    }
+    out << "      \"" << ASSIGN_ALGO << "\": \"" << assignAlgorithmString(report.assignAlgorithm) << "\"," << std::endl;
+    out << "      \"" << EXPLORE_CUTOFF << "\": " << report.exploredNodeCutoff << "," << std::endl;
+    if (report.smartPrune) {
+      out << "      \"" << BEST_BRANCHES << "\": \"smart\"," << std::endl;
     }
     else {
-      out << BEST_BRANCHES << "=" << ctx.compilerConfig.secondaryBestBranches << std::endl;
+      out << "      \"" << BEST_BRANCHES << "\": " << report.bestBranches << "," << std::endl;
+    }
+    if (report.assignAlgorithm == AssignAlgorithm::BEAM) {
+      out << "      \"" << BEAM_WIDTH << "\": " << report.beamWidth << "," << std::endl;
+    }
+    out << "      \"" << ASSIGN_SEED << "\": " << report.seed << "," << std::endl;
+    out << "      \"restarts\": " << (report.restarts ? "true" : "false") << "," << std::endl;
+    out << "      \"result\": \"" << report.result << "\"," << std::endl;
+    out << "      \"won\": " << (report.won ? "true" : "false") << "," << std::endl;
+    out << "      \"exploredNodes\": " << stats.exploredNodes << "," << std::endl;
+    out << "      \"seconds\": " << fmt::format("{:.6f}", stats.seconds) << "," << std::endl;
+    out << "      \"nodesPerSecond\": " << fmt::format("{:.0f}", nodesPerSecond) << "," << std::endl;
+    out << "      \"maxDepth\": " << stats.maxDepth << "," << std::endl;
+    out << "      \"backtracksPerDepth\": " << jsonCountArray(stats.backtracksPerDepth) << "," << std::endl;
+    out << "      \"branchFactorHistogram\": " << jsonCountArray(stats.branchFactorHistogram) << "," << std::endl;
+    out << "      \"queueHighWater\": " << stats.queueHighWater << "," << std::endl;
+    out << "      \"lowPriorityQueueHighWater\": " << stats.lowPriorityQueueHighWater << "," << std::endl;
+    out << "      \"visitedStates\": " << stats.visitedStates << "," << std::endl;
+    out << "      \"visitedLoadFactor\": " << fmt::format("{:.3f}", stats.visitedLoadFactor) << std::endl;
+    out << "    }";
+  }
+  out << std::endl << "  ]," << std::endl;
+
+  // Only the param search matrix has entries, so modes that never got that far are left out
+  out << "  \"winningMatrixEntry\": {";
+  bool first = true;
+  for (const auto &report : reports) {
+    if (report.source == "matrix" && report.won) {
+      out << (first ? "" : ", ") << "\"" << compilerModeString(report.mode) << "\": " << report.matrixEntry;
+      first = false;
     }
   }
+  out << "}" << std::endl;
+  out << "}" << std::endl;
 }
 
 } // namespace porytiles
@@ -452,6 +555,107 @@ TEST_CASE("emitZeroedPalette should write the expected JASC pal to the output st
   CHECK(outputStream.str() == expectedOutput);
 }
 
+TEST_CASE("emitAssignCache should write the cached solution after the search params")
+{
+  porytiles::PorytilesContext ctx{};
+  ctx.compilerConfig.primaryCachedSolution = {{porytiles::BGR15{0x001f}, porytiles::BGR15{0x7c00}}, {}};
+
+  std::string expectedOutput = "assign-algorithm=dfs\n"
+                               "explore-cutoff=2000000\n"
+                               "best-branches=18446744073709551615\n"
+                               "solution-palette=001f,7c00\n"
+                               "solution-palette=\n";
+
+  std::stringstream outputStream;
+  porytiles::emitAssignCache(ctx, porytiles::CompilerMode::PRIMARY, outputStream);
+
+  CHECK(outputStream.str() == expectedOutput);
+}
+
+TEST_CASE("emitAssignStats should write one JSON object per assignment attempt")
+{
+  porytiles::PorytilesContext ctx{};
+  porytiles::AssignAttemptReport cached{};
+  cached.mode = porytiles::CompilerMode::PRIMARY;
+  cached.source = "cache";
+  cached.assignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  cached.exploredNodeCutoff = 2'000'000;
+  cached.smartPrune = true;
+  cached.result = "cutoff-reached";
+  cached.stats.exploredNodes = 2'000'000;
+  cached.stats.seconds = 0.5;
+  cached.stats.maxDepth = 3;
+  cached.stats.backtracksPerDepth = {0, 4, 7};
+  cached.stats.branchFactorHistogram = {7, 2, 1};
+  porytiles::AssignAttemptReport matrix{};
+  matrix.mode = porytiles::CompilerMode::PRIMARY;
+  matrix.source = "matrix";
+  matrix.matrixEntry = 6;
+  matrix.assignAlgorithm = porytiles::AssignAlgorithm::BFS;
+  matrix.exploredNodeCutoff = 1'000'000;
+  matrix.bestBranches = 2;
+  matrix.result = "success";
+  matrix.won = true;
+  matrix.stats.queueHighWater = 10;
+  matrix.stats.visitedStates = 12;
+  matrix.stats.visitedLoadFactor = 0.75;
+  ctx.compilerContext.assignReports = {cached, matrix};
+
+  std::string expectedOutput = "{\n"
+                               "  \"attempts\": [\n"
+                               "    {\n"
+                               "      \"mode\": \"primary\",\n"
+                               "      \"source\": \"cache\",\n"
+                               "      \"assign-algorithm\": \"dfs\",\n"
+                               "      \"explore-cutoff\": 2000000,\n"
+                               "      \"best-branches\": \"smart\",\n"
+                               "      \"assign-seed\": 0,\n"
+                               "      \"restarts\": false,\n"
+                               "      \"result\": \"cutoff-reached\",\n"
+                               "      \"won\": false,\n"
+                               "      \"exploredNodes\": 2000000,\n"
+                               "      \"seconds\": 0.500000,\n"
+                               "      \"nodesPerSecond\": 4000000,\n"
+                               "      \"maxDepth\": 3,\n"
+                               "      \"backtracksPerDepth\": [0, 4, 7],\n"
+                               "      \"branchFactorHistogram\": [7, 2, 1],\n"
+                               "      \"queueHighWater\": 0,\n"
+                               "      \"lowPriorityQueueHighWater\": 0,\n"
+                               "      \"visitedStates\": 0,\n"
+                               "      \"visitedLoadFactor\": 0.000\n"
+                               "    },\n"
+                               "    {\n"
+                               "      \"mode\": \"primary\",\n"
+                               "      \"source\": \"matrix\",\n"
+                               "      \"matrixEntry\": 6,\n"
+                               "      \"assign-algorithm\": \"bfs\",\n"
+                               "      \"explore-cutoff\": 1000000,\n"
+                               "      \"best-branches\": 2,\n"
+                               "      \"assign-seed\": 0,\n"
+                               "      \"restarts\": false,\n"
+                               "      \"result\": \"success\",\n"
+                               "      \"won\": true,\n"
+                               "      \"exploredNodes\": 0,\n"
+                               "      \"seconds\": 0.000000,\n"
+                               "      \"nodesPerSecond\": 0,\n"
+                               "      \"maxDepth\": 0,\n"
+                               "      \"backtracksPerDepth\": [],\n"
+                               "      \"branchFactorHistogram\": [],\n"
+                               "      \"queueHighWater\": 10,\n"
+                               "      \"lowPriorityQueueHighWater\": 0,\n"
+                               "      \"visitedStates\": 12,\n"
+                               "      \"visitedLoadFactor\": 0.750\n"
+                               "    }\n"
+                               "  ],\n"
+                               "  \"winningMatrixEntry\": {\"primary\": 6}\n"
+                               "}\n";
+
+  std::stringstream outputStream;
+  porytiles::emitAssignStats(ctx, outputStream);
+
+  CHECK(outputStream.str() == expectedOutput);
+}
+
 TEST_CASE("emitTilesPng should emit the expected tiles.png file")
 {
   porytiles::PorytilesContext ctx{};
@@ -459,6 +663,7 @@ TEST_CASE("emitTilesPng should emit the expected tiles.png file")
   ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
   ctx.compilerConfig.secondaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_2/primary/bottom.png"}));
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_2/primary/middle.png"}));
@@ -505,6 +710,7 @@ TEST_CASE("emitMetatilesBin should emit metatiles.bin as expected based on setti
   ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
   ctx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
   ctx.compilerConfig.secondaryAssignAlgorithm = porytiles::AssignAlgorithm::DFS;
+  ctx.compilerConfig.greedyAssign = false;
 
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_1/bottom.png"}));
   REQUIRE(std::filesystem::exists(std::filesystem::path{"Resources/Tests/simple_metatiles_1/middle.png"}));
@@ -531,7 +737,7 @@ TEST_CASE("emitMetatilesBin should emit metatiles.bin as expected based on setti
 
   // Check metatiles.bin bytes are as expected
   CHECK(bytes[0] == 1);
-  CHECK(bytes[1] == 32);
+  CHECK(bytes[1] == 0);
   CHECK(bytes[2] == 0);
   CHECK(bytes[3] == 0);
   CHECK(bytes[4] == 0);
@@ -338,6 +338,27 @@ void fatalerror_assignExploreCutoffReached(const ErrorsAndWarnings &err, const C
   die_compilationTerminatedFailHard(err, srcs.modeBasedSrcPath(mode), "too many assignment recurses");
 }
 
+void fatalerror_assignTimeoutReached(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs, CompilerMode mode,
+                                     std::size_t timeoutSeconds, std::size_t timedOutAttempts,
+                                     std::size_t skippedAttempts, std::size_t totalAttempts, std::size_t required,
+                                     std::size_t available)
+{
+  if (err.printErrors) {
+    pt_fatal_err("palette assignment did not finish within the `{}' second timeout",
+                 fmt::styled(timeoutSeconds, fmt::emphasis::bold));
+    pt_note("{} of {} assignment attempt(s) ran out of time before they could finish", timedOutAttempts,
+            totalAttempts);
+    if (skippedAttempts > 0) {
+      pt_note("{} more never started because the time was already up", skippedAttempts);
+    }
+    pt_note("the tiles need at least `{}' of the `{}' available palettes", fmt::styled(required, fmt::emphasis::bold),
+            fmt::styled(available, fmt::emphasis::bold));
+    pt_note("raise `-assign-timeout', or run once without it so `assign.cache' can speed up later compiles");
+    pt_println(stderr, "");
+  }
+  die_compilationTerminatedFailHard(err, srcs.modeBasedSrcPath(mode), "palette assignment timed out");
+}
+
 void fatalerror_noPossiblePaletteAssignment(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs,
                                             CompilerMode mode)
 {
@@ -348,6 +369,19 @@ void fatalerror_noPossiblePaletteAssignment(const ErrorsAndWarnings &err, const
   die_compilationTerminatedFailHard(err, srcs.modeBasedSrcPath(mode), "no possible palette assignment");
 }
 
+void fatalerror_paletteAssignmentNeedsMorePalettes(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs,
+                                                   CompilerMode mode, std::size_t required, std::size_t available)
+{
+  if (err.printErrors) {
+    pt_fatal_err("{} tileset needs at least `{}' palettes, but only `{}' are available", compilerModeString(mode),
+                 fmt::styled(required, fmt::emphasis::bold), fmt::styled(available, fmt::emphasis::bold));
+    pt_note("found {} tiles whose colors are so different that no two of them can share a palette",
+            fmt::styled(required, fmt::emphasis::bold));
+    pt_println(stderr, "");
+  }
+  die_compilationTerminated(err, srcs.modeBasedSrcPath(mode), "not enough palettes");
+}
+
 void fatalerror_tooManyMetatiles(const ErrorsAndWarnings &err, const CompilerSourcePaths &srcs, CompilerMode mode,
                                  std::size_t numMetatiles, std::size_t metatileLimit)
 {
@@ -697,6 +731,12 @@ void warn_assignCacheOverride(ErrorsAndWarnings &err, CompilerMode mode, const C
           pt_note("best-branches={}", config.primaryBestBranches);
         }
       }
+      if (config.primaryAssignAlgorithm == AssignAlgorithm::BEAM) {
+        pt_note("beam-width={}", config.primaryBeamWidth);
+      }
+      if (config.primaryAssignSeed != 0) {
+        pt_note("assign-seed={}", config.primaryAssignSeed);
+      }
     }
     else if (mode == CompilerMode::SECONDARY) {
       pt_note("assign-algorithm={}", assignAlgorithmString(config.secondaryAssignAlgorithm));
@@ -712,6 +752,12 @@ void warn_assignCacheOverride(ErrorsAndWarnings &err, CompilerMode mode, const C
           pt_note("best-branches={}", config.secondarySmartPrune);
         }
       }
+      if (config.secondaryAssignAlgorithm == AssignAlgorithm::BEAM) {
+        pt_note("beam-width={}", config.secondaryBeamWidth);
+      }
+      if (config.secondaryAssignSeed != 0) {
+        pt_note("assign-seed={}", config.secondaryAssignSeed);
+      }
     }
     pt_println(stderr, "");
   }
@@ -715,6 +715,54 @@ static void runAssignmentConfigImport(PorytilesContext &ctx, CompilerMode compil
                                     static_cast<int>(compilerMode)));
         }
       }
+      else if (value == assignAlgorithmString(AssignAlgorithm::BEAM)) {
+        if (compilerMode == CompilerMode::PRIMARY) {
+          ctx.compilerConfig.primaryAssignAlgorithm = AssignAlgorithm::BEAM;
+        }
+        else if (compilerMode == CompilerMode::SECONDARY) {
+          ctx.compilerConfig.secondaryAssignAlgorithm = AssignAlgorithm::BEAM;
+        }
+        else {
+          internalerror(fmt::format("importer::runAssignmentConfigImport unknown CompilerMode: {}",
+                                    static_cast<int>(compilerMode)));
+        }
+      }
+      else if (value == assignAlgorithmString(AssignAlgorithm::LOCAL)) {
+        if (compilerMode == CompilerMode::PRIMARY) {
+          ctx.compilerConfig.primaryAssignAlgorithm = AssignAlgorithm::LOCAL;
+        }
+        else if (compilerMode == CompilerMode::SECONDARY) {
+          ctx.compilerConfig.secondaryAssignAlgorithm = AssignAlgorithm::LOCAL;
+        }
+        else {
+          internalerror(fmt::format("importer::runAssignmentConfigImport unknown CompilerMode: {}",
+                                    static_cast<int>(compilerMode)));
+        }
+      }
+      else if (value == assignAlgorithmString(AssignAlgorithm::GREEDY)) {
+        if (compilerMode == CompilerMode::PRIMARY) {
+          ctx.compilerConfig.primaryAssignAlgorithm = AssignAlgorithm::GREEDY;
+        }
+        else if (compilerMode == CompilerMode::SECONDARY) {
+          ctx.compilerConfig.secondaryAssignAlgorithm = AssignAlgorithm::GREEDY;
+        }
+        else {
+          internalerror(fmt::format("importer::runAssignmentConfigImport unknown CompilerMode: {}",
+                                    static_cast<int>(compilerMode)));
+        }
+      }
+      else if (value == assignAlgorithmString(AssignAlgorithm::COMPONENTS)) {
+        if (compilerMode == CompilerMode::PRIMARY) {
+          ctx.compilerConfig.primaryAssignAlgorithm = AssignAlgorithm::COMPONENTS;
+        }
+        else if (compilerMode == CompilerMode::SECONDARY) {
+          ctx.compilerConfig.secondaryAssignAlgorithm = AssignAlgorithm::COMPONENTS;
+        }
+        else {
+          internalerror(fmt::format("importer::runAssignmentConfigImport unknown CompilerMode: {}",
+                                    static_cast<int>(compilerMode)));
+        }
+      }
       else {
         fatalerror_assignCacheInvalidValue(ctx.err, ctx.compilerSrcPaths, compilerMode, key, value, processedUpToLine,
                                            assignCachePath);
@@ -778,6 +826,80 @@ static void runAssignmentConfigImport(PorytilesContext &ctx, CompilerMode compil
         }
       }
     }
+    else if (key == BEAM_WIDTH) {
+      std::size_t beamWidthValue;
+      try {
+        beamWidthValue = parseInteger<std::size_t>(value.c_str());
+      }
+      catch (const std::exception &e) {
+        beamWidthValue = 0;
+      }
+      if (beamWidthValue == 0) {
+        fatalerror_assignCacheInvalidValue(ctx.err, ctx.compilerSrcPaths, compilerMode, key, value, processedUpToLine,
+                                           assignCachePath);
+      }
+      if (compilerMode == CompilerMode::PRIMARY) {
+        ctx.compilerConfig.primaryBeamWidth = beamWidthValue;
+      }
+      else if (compilerMode == CompilerMode::SECONDARY) {
+        ctx.compilerConfig.secondaryBeamWidth = beamWidthValue;
+      }
+      else {
+        internalerror(fmt::format("importer::runAssignmentConfigImport unknown CompilerMode: {}",
+                                  static_cast<int>(compilerMode)));
+      }
+    }
+    else if (key == ASSIGN_SEED) {
+      std::uint64_t seedValue;
+      try {
+        seedValue = parseInteger<std::uint64_t>(value.c_str());
+      }
+      catch (const std::exception &e) {
+        seedValue = 0;
+        fatalerror_assignCacheInvalidValue(ctx.err, ctx.compilerSrcPaths, compilerMode, key, value, processedUpToLine,
+                                           assignCachePath);
+      }
+      if (compilerMode == CompilerMode::PRIMARY) {
+        ctx.compilerConfig.primaryAssignSeed = seedValue;
+      }
+      else if (compilerMode == CompilerMode::SECONDARY) {
+        ctx.compilerConfig.secondaryAssignSeed = seedValue;
+      }
+      else {
+        internalerror(fmt::format("importer::runAssignmentConfigImport unknown CompilerMode: {}",
+                                  static_cast<int>(compilerMode)));
+      }
+    }
+    else if (key == SOLUTION_PALETTE) {
+      // One line per hardware palette, in order, each a comma separated list of BGR15 colors in hex
+      std::vector<BGR15> palette{};
+      if (!value.empty()) {
+        for (const auto &colorString : split(value, ",")) {
+          try {
+            std::size_t pos;
+            unsigned long color = std::stoul(colorString, &pos, 16);
+            if (pos != colorString.size() || color > 0x7fff) {
+              throw std::runtime_error{"invalid BGR15 color: " + colorString};
+            }
+            palette.push_back(BGR15{static_cast<std::uint16_t>(color)});
+          }
+          catch (const std::exception &e) {
+            fatalerror_assignCacheInvalidValue(ctx.err, ctx.compilerSrcPaths, compilerMode, key, value,
+                                               processedUpToLine, assignCachePath);
+          }
+        }
+      }
+      if (compilerMode == CompilerMode::PRIMARY) {
+        ctx.compilerConfig.primaryCachedSolution.push_back(palette);
+      }
+      else if (compilerMode == CompilerMode::SECONDARY) {
+        ctx.compilerConfig.secondaryCachedSolution.push_back(palette);
+      }
+      else {
+        internalerror(fmt::format("importer::runAssignmentConfigImport unknown CompilerMode: {}",
+                                  static_cast<int>(compilerMode)));
+      }
+    }
     else {
       fatalerror_assignCacheInvalidKey(ctx.err, ctx.compilerSrcPaths, compilerMode, key, processedUpToLine,
                                        assignCachePath);
@@ -1792,3 +1914,149 @@ TEST_CASE("importCompiledTileset should import a dual-layer pokefirered tileset
 {
   // TODO tests : (importCompiledTileset should import a dual-layer pokefirered tileset correctly)
 }
+
+TEST_CASE("importAssignmentCache should read back the cache emitAssignCache writes")
+{
+  std::filesystem::path parentDir = porytiles::createTmpdir();
+  std::filesystem::path cachePath = porytiles::getTmpfilePath(parentDir, "assign.cache");
+
+  SUBCASE("it should read the beam search params and the cached solution")
+  {
+    porytiles::PorytilesContext emitCtx{};
+    emitCtx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::BEAM;
+    emitCtx.compilerConfig.primaryExploredNodeCutoff = 500'000;
+    emitCtx.compilerConfig.primaryBestBranches = 4;
+    emitCtx.compilerConfig.primaryBeamWidth = 32;
+    // Seeds use the full 64 bits, well past what an int holds
+    emitCtx.compilerConfig.primaryAssignSeed = 0xfedcba9876543210;
+    emitCtx.compilerConfig.primaryCachedSolution = {
+        {porytiles::BGR15{0x001f}, porytiles::BGR15{0x7c00}}, {}, {porytiles::BGR15{0x03e0}}};
+    std::ofstream outFile{cachePath};
+    porytiles::emitAssignCache(emitCtx, porytiles::CompilerMode::PRIMARY, outFile);
+    outFile.close();
+
+    porytiles::PorytilesContext ctx{};
+    std::ifstream inFile{cachePath};
+    porytiles::importAssignmentCache(ctx, porytiles::CompilerMode::PRIMARY, porytiles::CompilerMode::PRIMARY, inFile);
+    inFile.close();
+
+    CHECK(ctx.compilerConfig.readPrimaryAssignCache);
+    CHECK(ctx.compilerConfig.primaryAssignAlgorithm == porytiles::AssignAlgorithm::BEAM);
+    CHECK(ctx.compilerConfig.primaryExploredNodeCutoff == 500'000);
+    CHECK(ctx.compilerConfig.primaryBestBranches == 4);
+    CHECK_FALSE(ctx.compilerConfig.primarySmartPrune);
+    CHECK(ctx.compilerConfig.primaryBeamWidth == 32);
+    CHECK(ctx.compilerConfig.primaryAssignSeed == 0xfedcba9876543210);
+    CHECK(ctx.compilerConfig.primaryCachedSolution == emitCtx.compilerConfig.primaryCachedSolution);
+  }
+
+  SUBCASE("it should read the local search params and the cached solution")
+  {
+    porytiles::PorytilesContext emitCtx{};
+    emitCtx.compilerConfig.secondaryAssignAlgorithm = porytiles::AssignAlgorithm::LOCAL;
+    emitCtx.compilerConfig.secondaryExploredNodeCutoff = 1'000'000;
+    emitCtx.compilerConfig.secondarySmartPrune = true;
+    emitCtx.compilerConfig.secondaryAssignSeed = 7;
+    emitCtx.compilerConfig.secondaryCachedSolution = {{porytiles::BGR15{0x7fff}}, {porytiles::BGR15{0x0000}}};
+    std::ofstream outFile{cachePath};
+    porytiles::emitAssignCache(emitCtx, porytiles::CompilerMode::SECONDARY, outFile);
+    outFile.close();
+
+    porytiles::PorytilesContext ctx{};
+    std::ifstream inFile{cachePath};
+    porytiles::importAssignmentCache(ctx, porytiles::CompilerMode::SECONDARY, porytiles::CompilerMode::SECONDARY,
+                                     inFile);
+    inFile.close();
+
+    CHECK(ctx.compilerConfig.readSecondaryAssignCache);
+    CHECK(ctx.compilerConfig.secondaryAssignAlgorithm == porytiles::AssignAlgorithm::LOCAL);
+    CHECK(ctx.compilerConfig.secondaryExploredNodeCutoff == 1'000'000);
+    CHECK(ctx.compilerConfig.secondarySmartPrune);
+    CHECK(ctx.compilerConfig.secondaryBestBranches == SIZE_MAX);
+    CHECK(ctx.compilerConfig.secondaryAssignSeed == 7);
+    CHECK(ctx.compilerConfig.secondaryCachedSolution == emitCtx.compilerConfig.secondaryCachedSolution);
+  }
+
+  SUBCASE("it should read the greedy marker")
+  {
+    porytiles::PorytilesContext emitCtx{};
+    emitCtx.compilerConfig.primaryAssignAlgorithm = porytiles::AssignAlgorithm::GREEDY;
+    std::ofstream outFile{cachePath};
+    porytiles::emitAssignCache(emitCtx, porytiles::CompilerMode::PRIMARY, outFile);
+    outFile.close();
+
+    porytiles::PorytilesContext ctx{};
+    std::ifstream inFile{cachePath};
+    porytiles::importAssignmentCache(ctx, porytiles::CompilerMode::PRIMARY, porytiles::CompilerMode::PRIMARY, inFile);
+    inFile.close();
+
+    CHECK(ctx.compilerConfig.readPrimaryAssignCache);
+    CHECK(ctx.compilerConfig.primaryAssignAlgorithm == porytiles::AssignAlgorithm::GREEDY);
+  }
+
+  SUBCASE("it should read back the default best branches of SIZE_MAX")
+  {
+    porytiles::PorytilesContext emitCtx{};
+    std::ofstream outFile{cachePath};
+    porytiles::emitAssignCache(emitCtx, porytiles::CompilerMode::PRIMARY, outFile);
+    outFile.close();
+
+    porytiles::PorytilesContext ctx{};
+    ctx.compilerConfig.primaryBestBranches = 4;
+    std::ifstream inFile{cachePath};
+    porytiles::importAssignmentCache(ctx, porytiles::CompilerMode::PRIMARY, porytiles::CompilerMode::PRIMARY, inFile);
+    inFile.close();
+
+    CHECK(ctx.compilerConfig.primaryBestBranches == SIZE_MAX);
+  }
+
+  std::filesystem::remove_all(parentDir);
+}
+
+TEST_CASE("importAssignmentCache should reject a malformed solution palette")
+{
+  std::filesystem::path parentDir = porytiles::createTmpdir();
+  std::filesystem::path cachePath = porytiles::getTmpfilePath(parentDir, "assign.cache");
+
+  for (const std::string value : {"001f,zz", "001f,8000", "001f,,7c00"}) {
+    std::ofstream outFile{cachePath};
+    outFile << "assign-algorithm=dfs" << std::endl;
+    outFile << "solution-palette=" << value << std::endl;
+    outFile.close();
+
+    porytiles::PorytilesContext ctx{};
+    ctx.err.printErrors = false;
+    std::ifstream inFile{cachePath};
+    CHECK_THROWS_WITH_AS(porytiles::importAssignmentCache(ctx, porytiles::CompilerMode::PRIMARY,
+                                                          porytiles::CompilerMode::PRIMARY, inFile),
+                         fmt::format("invalid assign value {} for key solution-palette", value).c_str(),
+                         porytiles::PorytilesException);
+    inFile.close();
+  }
+
+  std::filesystem::remove_all(parentDir);
+}
+
+TEST_CASE("importAssignmentCache should reject negative search params instead of wrapping them")
+{
+  std::filesystem::path parentDir = porytiles::createTmpdir();
+  std::filesystem::path cachePath = porytiles::getTmpfilePath(parentDir, "assign.cache");
+
+  for (const std::string key : {"explore-cutoff", "best-branches", "beam-width", "assign-seed"}) {
+    std::ofstream outFile{cachePath};
+    outFile << "assign-algorithm=beam" << std::endl;
+    outFile << key << "=-1" << std::endl;
+    outFile.close();
+
+    porytiles::PorytilesContext ctx{};
+    ctx.err.printErrors = false;
+    std::ifstream inFile{cachePath};
+    CHECK_THROWS_WITH_AS(porytiles::importAssignmentCache(ctx, porytiles::CompilerMode::PRIMARY,
+                                                          porytiles::CompilerMode::PRIMARY, inFile),
+                         fmt::format("invalid assign value -1 for key {}", key).c_str(),
+                         porytiles::PorytilesException);
+    inFile.close();
+  }
+
+  std::filesystem::remove_all(parentDir);
+}
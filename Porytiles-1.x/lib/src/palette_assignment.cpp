@@ -1,34 +1,523 @@
 #include "palette_assignment.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <climits>
+#include <cstdint>
 #include <deque>
+#include <doctest.h>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <span>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "emitter.h"
+#include "importer.h"
 #include "logger.h"
 #include "porytiles_context.h"
 #include "types.h"
+#include "utilities.h"
 
 namespace porytiles {
-AssignResult assignDepthFirst(PorytilesContext &ctx, CompilerMode compilerMode, AssignState &state,
-                              std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
-                              const std::vector<ColorSet> &unassigneds, const std::vector<ColorSet> &unassignedPrimers)
+AssignParams assignParamsFromConfig(const CompilerConfig &config, CompilerMode compilerMode)
+{
+  if (compilerMode == CompilerMode::PRIMARY) {
+    return AssignParams{config.primaryAssignAlgorithm, config.primaryExploredNodeCutoff, config.primaryBestBranches,
+                        config.primarySmartPrune, config.primaryBeamWidth, config.primaryAssignSeed};
+  }
+  else if (compilerMode == CompilerMode::SECONDARY) {
+    return AssignParams{config.secondaryAssignAlgorithm, config.secondaryExploredNodeCutoff,
+                        config.secondaryBestBranches, config.secondarySmartPrune, config.secondaryBeamWidth,
+                        config.secondaryAssignSeed};
+  }
+  internalerror_unknownCompilerMode("palette_assignment::assignParamsFromConfig");
+  // unreachable, here for compiler
+  throw std::runtime_error("palette_assignment::assignParamsFromConfig reached unreachable code path");
+}
+
+static void writeAssignParamsToConfig(CompilerConfig &config, CompilerMode compilerMode, const AssignParams &params)
+{
+  if (compilerMode == CompilerMode::PRIMARY) {
+    config.primaryAssignAlgorithm = params.assignAlgorithm;
+    config.primaryExploredNodeCutoff = params.exploredNodeCutoff;
+    config.primaryBestBranches = params.bestBranches;
+    config.primarySmartPrune = params.smartPrune;
+    config.primaryBeamWidth = params.beamWidth;
+    config.primaryAssignSeed = params.seed;
+  }
+  else if (compilerMode == CompilerMode::SECONDARY) {
+    config.secondaryAssignAlgorithm = params.assignAlgorithm;
+    config.secondaryExploredNodeCutoff = params.exploredNodeCutoff;
+    config.secondaryBestBranches = params.bestBranches;
+    config.secondarySmartPrune = params.smartPrune;
+    config.secondaryBeamWidth = params.beamWidth;
+    config.secondaryAssignSeed = params.seed;
+  }
+  else {
+    internalerror_unknownCompilerMode("palette_assignment::writeAssignParamsToConfig");
+  }
+}
+
+// How many nodes a search explores locally before adding them to a shared node counter
+constexpr std::size_t SHARED_NODE_COUNTER_BATCH = 1024;
+
+static void flushExploredNodes(AssignSearch &search)
+{
+  if (search.sharedExploredNodeCounter == nullptr) {
+    return;
+  }
+  std::size_t pending = search.exploredNodeCounter - search.flushedExploredNodes;
+  search.sharedExploredNodeTotal = search.sharedExploredNodeCounter->fetch_add(pending) + pending;
+  search.flushedExploredNodes = search.exploredNodeCounter;
+}
+
+/*
+ * Count one explored node against the search budget. Returns false once the budget is spent.
+ */
+static bool exploreNode(AssignSearch &search)
+{
+  search.exploredNodeCounter++;
+  if (search.sharedExploredNodeCounter == nullptr) {
+    return search.exploredNodeCounter <= search.params.exploredNodeCutoff;
+  }
+  if (search.exploredNodeCounter - search.flushedExploredNodes >= SHARED_NODE_COUNTER_BATCH) {
+    flushExploredNodes(search);
+  }
+  // Other searches may overshoot by up to a batch each, but our own unflushed nodes always count
+  std::size_t pending = search.exploredNodeCounter - search.flushedExploredNodes;
+  return search.sharedExploredNodeTotal + pending <= search.params.exploredNodeCutoff;
+}
+
+/*
+ * `-assign-stats' bookkeeping, all of these do nothing unless the search has stats turned on. Depth is the number of
+ * ColorSets a state has assigned so far.
+ */
+template <typename ColorSetType>
+static std::size_t assignDepth(const BasicAssignState<ColorSetType> &state,
+                               const std::vector<ColorSetType> &unassigneds,
+                               const std::vector<ColorSetType> &unassignedPrimers)
+{
+  return unassigneds.size() + unassignedPrimers.size() - state.unassignedCount - state.unassignedPrimerCount;
+}
+
+static void bumpCount(std::vector<std::size_t> &counts, std::size_t index)
+{
+  if (counts.size() <= index) {
+    counts.resize(index + 1, 0);
+  }
+  counts.at(index)++;
+}
+
+static void recordDepth(AssignSearch &search, std::size_t depth)
+{
+  if (search.stats != nullptr) {
+    search.stats->maxDepth = std::max(search.stats->maxDepth, depth);
+  }
+}
+
+static void recordBranches(AssignSearch &search, std::size_t branches)
+{
+  if (search.stats != nullptr) {
+    bumpCount(search.stats->branchFactorHistogram, branches);
+  }
+}
+
+static void recordBacktrack(AssignSearch &search, std::size_t depth)
+{
+  if (search.stats != nullptr) {
+    bumpCount(search.stats->backtracksPerDepth, depth);
+  }
+}
+
+template <typename ColorSetType>
+static void recordVisitedStates(AssignSearch &search,
+                                const std::unordered_set<BasicAssignState<ColorSetType>> &visitedStates)
+{
+  if (search.stats != nullptr && visitedStates.size() >= search.stats->visitedStates) {
+    search.stats->visitedStates = visitedStates.size();
+    search.stats->visitedLoadFactor = visitedStates.load_factor();
+  }
+}
+
+static void mergeAssignStats(AssignStats &into, const AssignStats &from)
+{
+  into.maxDepth = std::max(into.maxDepth, from.maxDepth);
+  for (std::size_t depth = 0; depth < from.backtracksPerDepth.size(); depth++) {
+    if (into.backtracksPerDepth.size() <= depth) {
+      into.backtracksPerDepth.resize(depth + 1, 0);
+    }
+    into.backtracksPerDepth.at(depth) += from.backtracksPerDepth.at(depth);
+  }
+  for (std::size_t branches = 0; branches < from.branchFactorHistogram.size(); branches++) {
+    if (into.branchFactorHistogram.size() <= branches) {
+      into.branchFactorHistogram.resize(branches + 1, 0);
+    }
+    into.branchFactorHistogram.at(branches) += from.branchFactorHistogram.at(branches);
+  }
+  into.queueHighWater = std::max(into.queueHighWater, from.queueHighWater);
+  into.lowPriorityQueueHighWater = std::max(into.lowPriorityQueueHighWater, from.lowPriorityQueueHighWater);
+  if (from.visitedStates >= into.visitedStates) {
+    into.visitedStates = from.visitedStates;
+    into.visitedLoadFactor = from.visitedLoadFactor;
+  }
+}
+
+/*
+ * Strict total order on ColorSets, so palettes can be put in a canonical order. We compare a 64-bit word at a time
+ * starting from the most significant word.
+ */
+template <typename ColorSetType> static bool colorSetLess(const ColorSetType &cs1, const ColorSetType &cs2)
+{
+  for (std::size_t i = ColorSetType::WORD_COUNT; i-- > 0;) {
+    if (cs1.word(i) != cs2.word(i)) {
+      return cs1.word(i) < cs2.word(i);
+    }
+  }
+  return false;
+}
+
+template <typename ColorSetType>
+BasicAssignState<ColorSetType> canonicalAssignState(const BasicAssignState<ColorSetType> &state)
+{
+  // Insertion sort so each palette's hash moves along with it, there are at most MAX_BG_PALETTES of them anyway
+  BasicAssignState<ColorSetType> canonical = state;
+  BasicHardwarePalettes<ColorSetType> &palettes = canonical.hardwarePalettes;
+  for (std::size_t i = 1; i < palettes.size(); i++) {
+    for (std::size_t j = i; j > 0 && colorSetLess(palettes[j], palettes[j - 1]); j--) {
+      palettes.swap(j, j - 1);
+    }
+  }
+  return canonical;
+}
+
+/*
+ * For this next step, we want to sort the hw palettes before we try iterating. Sort them by the size of their
+ * intersection with the toAssign ColorSet. Effectively, this means that we will always first try branching into an
+ * assignment that re-uses hw palettes more effectively. We also have a tie-breaker heuristic for cases where two
+ * palettes have the same intersect size. Right now we just use palette size, but in the future we may want to look at
+ * color distances so we can pick a palette with more similar colors.
+ *
+ * FEATURE : Instead of just using palette count, maybe can we check for color distance here and try to choose the
+ * palette that has the "closest" colors to our toAssign palette? That might be a good heuristic for attempting to keep
+ * similar colors in the same palette. I.e. especially in cases where there are no palette intersections, it may be
+ * better to first try placing the new colors into a palette with similar colors rather than into the smallest palette.
+ * We can put this behind a flag like '-Ocolor-distance-heuristic
+ *
+ * This gives the same order as a std::stable_sort with that comparator. But stable_sort may allocate a scratch buffer on
+ * every call, while an insertion sort over at most MAX_BG_PALETTES elements never touches the heap.
+ *
+ * A nonzero `seed' breaks the remaining ties by a hash of each palette's contents mixed with the seed. Different seeds
+ * give different but reproducible branch orders, which is what lets depth first search restart into a different tree.
+ */
+template <typename ColorSetType>
+static void sortPalettesForAssignment(BasicHardwarePalettes<ColorSetType> &palettes, const ColorSetType &toAssign,
+                                      std::uint64_t seed = 0)
+{
+  std::array<std::size_t, MAX_BG_PALETTES> intersectSizes{};
+  std::array<std::size_t, MAX_BG_PALETTES> sizes{};
+  std::array<std::uint64_t, MAX_BG_PALETTES> tieBreaks{};
+  for (std::size_t i = 0; i < palettes.size(); i++) {
+    intersectSizes[i] = palettes[i].countAnd(toAssign);
+    sizes[i] = palettes[i].count();
+    if (seed != 0) {
+      tieBreaks[i] = mixHash64(palettes.paletteHashes[i] ^ seed);
+    }
+  }
+  for (std::size_t i = 1; i < palettes.size(); i++) {
+    for (std::size_t j = i; j > 0; j--) {
+      bool before = false;
+      if (intersectSizes[j] != intersectSizes[j - 1]) {
+        before = intersectSizes[j] > intersectSizes[j - 1];
+      }
+      else if (sizes[j] != sizes[j - 1]) {
+        before = sizes[j] < sizes[j - 1];
+      }
+      else {
+        before = tieBreaks[j] < tieBreaks[j - 1];
+      }
+      if (!before) {
+        break;
+      }
+      palettes.swap(j, j - 1);
+      std::swap(intersectSizes[j], intersectSizes[j - 1]);
+      std::swap(sizes[j], sizes[j - 1]);
+      std::swap(tieBreaks[j], tieBreaks[j - 1]);
+    }
+  }
+}
+
+/*
+ * Whether the search branches into every palette that toAssign fits in. Smart prune and a best branches limit below the
+ * palette count both skip palettes, and a state that fails through the palettes they try may still succeed through one
+ * they skip. So pruning that relies on every other branch being tried is only sound when this holds.
+ */
+static bool branchesExhaustively(const AssignSearch &search, std::size_t paletteCount)
+{
+  return search.params.bestBranches >= paletteCount && !search.params.smartPrune;
+}
+
+/*
+ * Once the palettes are sorted for `toAssign', check if the first one already holds all of its colors. Nothing can
+ * intersect toAssign more than a palette that covers it, so if any palette does, the first one does. Assigning there
+ * leaves the state unchanged, while any other branch only adds colors to some palette and so can never succeed where
+ * this one failed. That makes it the only branch worth taking. This is what keeps ColorSets that are subsets of others
+ * from multiplying the size of the search: by the time we reach one, its superset has usually been assigned already.
+ *
+ * "Can never succeed where this one failed" assumes the search below tries every palette. With restricted branching the
+ * bigger state sorts its palettes differently and may reach a palette the covering branch never tries, so there we
+ * keep the regular branches, so a replay of cached params with smart prune finds the palettes it always did. Fresh
+ * searches get most of the same cut another way: withoutSubsumedColorSets drops every ColorSet that is a subset of
+ * another one before they start, which leaves only ColorSets that a merged palette happens to cover.
+ */
+template <typename ColorSetType>
+static bool forceCoveringPalette(const AssignSearch &search, const BasicHardwarePalettes<ColorSetType> &sortedPalettes,
+                                 const ColorSetType &toAssign)
+{
+  return search.coveringMoves && branchesExhaustively(search, sortedPalettes.size()) && sortedPalettes.size() > 0 &&
+         toAssign.isSubsetOf(sortedPalettes[0]);
+}
+
+/*
+ * Two ColorSets whose union has more colors than fit in a palette can never share one. So a group of ColorSets that
+ * are all pairwise incompatible like that needs a palette per member. Finding the biggest such group is hard, but any
+ * group we find is a valid lower bound, and greedily taking ColorSets that clash with everything taken so far finds a
+ * decent one cheaply. Callers pass the candidates biggest first, since those are the likeliest to clash.
+ */
+template <typename ColorSetPtrs> static std::size_t incompatibleGroupSize(const ColorSetPtrs &candidates)
+{
+  std::array<typename ColorSetPtrs::value_type, MAX_BG_PALETTES + 1> group{};
+  std::size_t groupSize = 0;
+  for (const auto *candidate : candidates) {
+    bool clashesWithAll = std::all_of(std::begin(group), std::begin(group) + groupSize, [candidate](const auto *member) {
+      return candidate->countOr(*member) > PAL_SIZE - 1;
+    });
+    if (clashesWithAll) {
+      group.at(groupSize) = candidate;
+      groupSize++;
+      if (groupSize == group.size()) {
+        // Already more than any tileset can have, no point looking any further
+        break;
+      }
+    }
+  }
+  return groupSize;
+}
+
+template <typename ColorSetType>
+static bool coveredByPrimary(const std::vector<ColorSetType> &primaryPalettes, const ColorSetType &colorSet)
+{
+  return std::any_of(std::begin(primaryPalettes), std::end(primaryPalettes),
+                     [&colorSet](const auto &palette) { return colorSet.isSubsetOf(palette); });
+}
+
+/*
+ * Whether some primary palette covers each ColorSet, by the ColorSet's position in the unassigned vectors. That never
+ * changes while we search, so the searches work it out once up front instead of checking every primary palette at
+ * every node. Which palette covers it does not matter: any of them leaves the search state exactly as it was.
+ */
+struct PrimaryCoverage {
+  std::vector<bool> norms;
+  std::vector<bool> primers;
+};
+
+template <typename ColorSetType>
+static PrimaryCoverage primaryCoverage(const std::vector<ColorSetType> &primaryPalettes,
+                                       const std::vector<ColorSetType> &unassigneds,
+                                       const std::vector<ColorSetType> &unassignedPrimers)
+{
+  PrimaryCoverage coverage{};
+  coverage.norms.reserve(unassigneds.size());
+  for (const auto &colorSet : unassigneds) {
+    coverage.norms.push_back(coveredByPrimary(primaryPalettes, colorSet));
+  }
+  coverage.primers.reserve(unassignedPrimers.size());
+  for (const auto &colorSet : unassignedPrimers) {
+    coverage.primers.push_back(coveredByPrimary(primaryPalettes, colorSet));
+  }
+  return coverage;
+}
+
+// Whether a primary palette covers the ColorSet that `state' assigns next
+template <typename ColorSetType>
+static bool nextCoveredByPrimary(const PrimaryCoverage &coverage, const BasicAssignState<ColorSetType> &state)
+{
+  if (state.unassignedPrimerCount != 0) {
+    return coverage.primers.at(state.unassignedPrimerCount - 1);
+  }
+  return coverage.norms.at(state.unassignedCount - 1);
+}
+
+// How many of the next ColorSets in line we check at each node, this keeps the bound cheap
+constexpr std::size_t LOWER_BOUND_LOOKAHEAD = 8;
+
+/*
+ * Prune a node if the ColorSets that are up next provably cannot all fit. A ColorSet that no longer fits into any of
+ * the palettes we already started, and that no primary palette covers, can only go into an empty palette. Palettes
+ * only ever gain colors, so that stays true for the rest of the subtree. If a group of such ColorSets is pairwise
+ * incompatible and bigger than the number of empty palettes left, the subtree has no solution.
+ */
+template <typename ColorSetType>
+static bool remainingCannotFit(const BasicAssignState<ColorSetType> &state, const PrimaryCoverage &coverage,
+                               const std::vector<ColorSetType> &unassigneds,
+                               const std::vector<ColorSetType> &unassignedPrimers)
+{
+  std::size_t emptyPalettes = std::count_if(std::begin(state.hardwarePalettes), std::end(state.hardwarePalettes),
+                                            [](const auto &palette) { return palette.none(); });
+  if (emptyPalettes >= LOWER_BOUND_LOOKAHEAD) {
+    return false;
+  }
+
+  std::array<const ColorSetType *, LOWER_BOUND_LOOKAHEAD> homeless{};
+  std::size_t homelessCount = 0;
+  auto consider = [&](const ColorSetType &colorSet, bool covered) {
+    bool fitsStartedPalette =
+        std::any_of(std::begin(state.hardwarePalettes), std::end(state.hardwarePalettes), [&colorSet](const auto &pal) {
+          return pal.any() && pal.countOr(colorSet) <= PAL_SIZE - 1;
+        });
+    if (!fitsStartedPalette && !covered) {
+      homeless.at(homelessCount) = &colorSet;
+      homelessCount++;
+    }
+  };
+  // Same order the searches assign in: primers first, then the regular ColorSets, each from the back
+  std::size_t looked = 0;
+  for (std::size_t i = state.unassignedPrimerCount; i > 0 && looked < LOWER_BOUND_LOOKAHEAD; i--, looked++) {
+    consider(unassignedPrimers.at(i - 1), coverage.primers.at(i - 1));
+  }
+  for (std::size_t i = state.unassignedCount; i > 0 && looked < LOWER_BOUND_LOOKAHEAD; i--, looked++) {
+    consider(unassigneds.at(i - 1), coverage.norms.at(i - 1));
+  }
+  if (homelessCount <= emptyPalettes) {
+    return false;
+  }
+  return incompatibleGroupSize(std::span{homeless.data(), homelessCount}) > emptyPalettes;
+}
+
+/*
+ * Bounded memory of states the depth first search has already seen fail. Without it, reaching the same palettes at the
+ * same depth through a different path means searching the whole subtree again, only to fail the same way.
+ *
+ * We only store 64-bit state keys, not the states themselves, so a key collision could in theory prune a subtree that
+ * has a solution. The odds of that are negligible next to the memory saved. The table is set associative: a key can
+ * only live in one bucket of NOGOOD_TABLE_WAYS slots, and a full bucket evicts with the clock algorithm. Every hit sets
+ * a slot's referenced bit, and the hand clears bits as it sweeps, so it evicts the first slot that went unused since
+ * its last pass.
+ */
+constexpr std::size_t NOGOOD_TABLE_WAYS = 4;
+constexpr std::size_t NOGOOD_TABLE_BUCKETS = 1 << 16;
+
+struct NogoodTable {
+  struct Bucket {
+    std::array<std::uint64_t, NOGOOD_TABLE_WAYS> keys{};
+    std::array<bool, NOGOOD_TABLE_WAYS> referenced{};
+    std::size_t hand{0};
+  };
+  std::vector<Bucket> buckets;
+
+  explicit NogoodTable(std::size_t bucketCount) : buckets(bucketCount) {}
+
+  // Forget every key but keep the buckets, so a search can start over without allocating a new table
+  void clear() { std::fill(std::begin(buckets), std::end(buckets), Bucket{}); }
+
+  // Key 0 marks an empty slot
+  static std::uint64_t slotKey(std::uint64_t key) { return key == 0 ? 1 : key; }
+
+  Bucket &bucketFor(std::uint64_t key) { return buckets[key % buckets.size()]; }
+
+  bool contains(std::uint64_t key)
+  {
+    key = slotKey(key);
+    Bucket &bucket = bucketFor(key);
+    for (std::size_t way = 0; way < NOGOOD_TABLE_WAYS; way++) {
+      if (bucket.keys[way] == key) {
+        bucket.referenced[way] = true;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void insert(std::uint64_t key)
+  {
+    key = slotKey(key);
+    Bucket &bucket = bucketFor(key);
+    while (bucket.keys[bucket.hand] != 0 && bucket.referenced[bucket.hand]) {
+      bucket.referenced[bucket.hand] = false;
+      bucket.hand = (bucket.hand + 1) % NOGOOD_TABLE_WAYS;
+    }
+    bucket.keys[bucket.hand] = key;
+    bucket.referenced[bucket.hand] = false;
+    bucket.hand = (bucket.hand + 1) % NOGOOD_TABLE_WAYS;
+  }
+};
+
+/*
+ * Whether a subtree fails depends only on the state at its root. When the search may branch into every palette, the
+ * palette order does not matter either, so the order independent AssignState hash can fold permutations of a state
+ * together. With a constant best branches limit, or with smart prune, the order decides which palettes we try: smart
+ * prune only takes the first empty palette, and ties in the branch order fall back to the input order. So there we
+ * have to key on the exact order.
+ */
+template <typename ColorSetType>
+static std::uint64_t nogoodKey(const AssignSearch &search, const BasicAssignState<ColorSetType> &state)
+{
+  if (branchesExhaustively(search, state.hardwarePalettes.size())) {
+    return std::hash<BasicAssignState<ColorSetType>>{}(state);
+  }
+  std::uint64_t key = mixHash64((static_cast<std::uint64_t>(state.unassignedCount) << 32) ^
+                                state.unassignedPrimerCount);
+  for (std::size_t i = 0; i < state.hardwarePalettes.size(); i++) {
+    key = mixHash64(key ^ state.hardwarePalettes.paletteHashes[i]);
+  }
+  return key;
+}
+
+/*
+ * The depth first search proper. If `frontier' is non-null, we are splitting the tree for assignDepthFirstParallel:
+ * instead of searching below `splitDepth' levels, we record the states we reach there in the exact order the regular
+ * search would have visited them.
+ */
+template <typename ColorSetType>
+static AssignResult depthFirst(const PorytilesContext &ctx, AssignSearch &search, BasicAssignState<ColorSetType> &state,
+                               std::vector<ColorSetType> &solution, const PrimaryCoverage &coverage,
+                               const std::vector<ColorSetType> &unassigneds,
+                               const std::vector<ColorSetType> &unassignedPrimers,
+                               std::vector<BasicAssignState<ColorSetType>> *frontier, std::size_t splitDepth)
 {
-  std::size_t exploredNodeCutoff = compilerMode == CompilerMode::PRIMARY
-                                       ? ctx.compilerConfig.primaryExploredNodeCutoff
-                                       : ctx.compilerConfig.secondaryExploredNodeCutoff;
-  std::size_t bestBranches = compilerMode == CompilerMode::PRIMARY ? ctx.compilerConfig.primaryBestBranches
-                                                                   : ctx.compilerConfig.secondaryBestBranches;
-  bool smartPrune = compilerMode == CompilerMode::PRIMARY ? ctx.compilerConfig.primarySmartPrune
-                                                          : ctx.compilerConfig.secondarySmartPrune;
+  std::size_t bestBranches = search.params.bestBranches;
+  bool smartPrune = search.params.smartPrune;
 
-  ctx.compilerContext.exploredNodeCounter++;
-  if (ctx.compilerContext.exploredNodeCounter % EXPLORATION_CUTOFF_MULTIPLIER == 0) {
-    pt_logln(ctx, stderr, "exploredNodeCounter passed {} iterations", ctx.compilerContext.exploredNodeCounter);
+  if (frontier != nullptr &&
+      (splitDepth == 0 || (state.unassignedPrimerCount == 0 && state.unassignedCount == 0))) {
+    frontier->push_back(state);
+    return AssignResult::NO_SOLUTION_POSSIBLE;
   }
-  if (ctx.compilerContext.exploredNodeCounter > exploredNodeCutoff) {
+
+  if (!exploreNode(search)) {
     return AssignResult::EXPLORE_CUTOFF_REACHED;
   }
+  if (search.exploredNodeCounter % EXPLORATION_CUTOFF_MULTIPLIER == 0) {
+    pt_logln(ctx, stderr, "exploredNodeCounter passed {} iterations", search.exploredNodeCounter);
+  }
+  if (search.isCancelled()) {
+    return AssignResult::CANCELLED;
+  }
+  const std::size_t depth = assignDepth(state, unassigneds, unassignedPrimers);
+  recordDepth(search, depth);
 
   if (state.unassignedPrimerCount == 0 && state.unassignedCount == 0) {
     // No tiles left to assign, found a solution!
@@ -36,11 +525,33 @@ AssignResult assignDepthFirst(PorytilesContext &ctx, CompilerMode compilerMode,
     return AssignResult::SUCCESS;
   }
 
+  // The split pass never finishes a subtree, so it must not record or trust failures
+  NogoodTable *nogoods = frontier == nullptr ? search.nogoods : nullptr;
+  std::uint64_t stateKey = 0;
+  if (nogoods != nullptr) {
+    stateKey = nogoodKey(search, state);
+    if (nogoods->contains(stateKey)) {
+      recordBacktrack(search, depth);
+      return AssignResult::NO_SOLUTION_POSSIBLE;
+    }
+  }
+
+  if (remainingCannotFit(state, coverage, unassigneds, unassignedPrimers)) {
+    if (nogoods != nullptr) {
+      nogoods->insert(stateKey);
+    }
+    recordBacktrack(search, depth);
+    return AssignResult::NO_SOLUTION_POSSIBLE;
+  }
+
   /*
    * We will try to assign the last element to one of the 6 hw palettes, last because it is a vector so easier to
    * add/remove from the end. First we assign all the primer palettes, then we assign the regular palettes.
    */
-  ColorSet toAssign{};
+  const bool covered = nextCoveredByPrimary(coverage, state);
+  ColorSetType toAssign{};
+  const std::size_t unassignedPrimerCount = state.unassignedPrimerCount;
+  const std::size_t unassignedCount = state.unassignedCount;
   std::size_t newUnassignedPrimerCount = state.unassignedPrimerCount;
   std::size_t newUnassignedCount = state.unassignedCount;
   if (state.unassignedPrimerCount != 0) {
@@ -60,65 +571,37 @@ AssignResult assignDepthFirst(PorytilesContext &ctx, CompilerMode compilerMode,
    * constraints for this particular tile. That way we can just use the primary palette, since those are available for
    * secondary tiles to freely use.
    */
-  if (!primaryPalettes.empty()) {
-    for (std::size_t i = 0; i < primaryPalettes.size(); i++) {
-      const ColorSet &palette = primaryPalettes.at(i);
-      if ((palette | toAssign).count() == palette.count()) {
-        /*
-         * This case triggers if `toAssign' shares all its colors with one of the palettes from the primary
-         * tileset. In that case, we will just reuse that palette when we make the tile in a later step. So we
-         * can prep a recursive call to assign with an unchanged state (other than removing `toAssign')
-         */
-        std::vector<ColorSet> hardwarePalettesCopy;
-        std::copy(std::begin(state.hardwarePalettes), std::end(state.hardwarePalettes),
-                  std::back_inserter(hardwarePalettesCopy));
-        AssignState updatedState = {hardwarePalettesCopy, newUnassignedCount, newUnassignedPrimerCount};
-
-        AssignResult result = assignDepthFirst(ctx, compilerMode, updatedState, solution, primaryPalettes, unassigneds,
-                                               unassignedPrimers);
-        if (result == AssignResult::SUCCESS) {
-          return AssignResult::SUCCESS;
-        }
-        else if (result == AssignResult::EXPLORE_CUTOFF_REACHED) {
-          return AssignResult::EXPLORE_CUTOFF_REACHED;
-        }
-      }
+  if (covered) {
+    /*
+     * This case triggers if `toAssign' shares all its colors with one of the palettes from the primary tileset. In
+     * that case, we will just reuse that palette when we make the tile in a later step. So we can prep a recursive
+     * call to assign with an unchanged state (other than removing `toAssign'). Every covering palette leads to this
+     * same state, so one call covers them all.
+     */
+    state.unassignedCount = newUnassignedCount;
+    state.unassignedPrimerCount = newUnassignedPrimerCount;
+    AssignResult result =
+        depthFirst(ctx, search, state, solution, coverage, unassigneds, unassignedPrimers, frontier, splitDepth - 1);
+    if (result != AssignResult::NO_SOLUTION_POSSIBLE) {
+      return result;
     }
+    state.unassignedCount = unassignedCount;
+    state.unassignedPrimerCount = unassignedPrimerCount;
   }
 
   /*
-   * For this next step, we want to sort the hw palettes before we try iterating. Sort them by the size of their
-   * intersection with the toAssign ColorSet. Effectively, this means that we will always first try branching into an
-   * assignment that re-uses hw palettes more effectively. We also have a tie-breaker heuristic for cases where two
-   * palettes have the same intersect size. Right now we just use palette size, but in the future we may want to look
-   * at color distances so we can pick a palette with more similar colors.
+   * Sorting reorders the palettes in place, so remember the order we were handed and put it back before we backtrack.
+   * Our caller expects to find the state exactly as it left it.
    */
-  std::stable_sort(std::begin(state.hardwarePalettes), std::end(state.hardwarePalettes),
-                   [&toAssign](const auto &pal1, const auto &pal2) {
-                     std::size_t pal1IntersectSize = (pal1 & toAssign).count();
-                     std::size_t pal2IntersectSize = (pal2 & toAssign).count();
-
-                     /*
-                      * FEATURE : Instead of just using palette count, maybe can we check for color distance here and
-                      * try to choose the palette that has the "closest" colors to our toAssign palette? That might be a
-                      * good heuristic for attempting to keep similar colors in the same palette. I.e. especially in
-                      * cases where there are no palette intersections, it may be better to first try placing the new
-                      * colors into a palette with similar colors rather than into the smallest palette. We can put
-                      * this behind a flag like '-Ocolor-distance-heuristic
-                      */
-                     if (pal1IntersectSize == pal2IntersectSize) {
-                       return pal1.count() < pal2.count();
-                     }
-
-                     return pal1IntersectSize > pal2IntersectSize;
-                   });
+  BasicHardwarePalettes<ColorSetType> entryPalettes = state.hardwarePalettes;
+  sortPalettesForAssignment(state.hardwarePalettes, toAssign, search.params.seed);
 
   std::size_t stopLimit = std::min(state.hardwarePalettes.size(), bestBranches);
   if (smartPrune) {
     // Shrink stopLimit so it ends after the first empty hardware palette
     for (std::size_t i = 0; i < stopLimit; i++) {
       auto pal = state.hardwarePalettes.at(i);
-      std::size_t palIntersectSize = (pal & toAssign).count();
+      std::size_t palIntersectSize = pal.countAnd(toAssign);
       if (palIntersectSize == 0) {
         stopLimit = i + 1;
         break;
@@ -127,11 +610,19 @@ AssignResult assignDepthFirst(PorytilesContext &ctx, CompilerMode compilerMode,
   }
   // Ensure stopLimit does not exceed the palette list size
   stopLimit = std::min(state.hardwarePalettes.size(), stopLimit);
+  if (forceCoveringPalette(search, state.hardwarePalettes, toAssign)) {
+    stopLimit = std::min(stopLimit, std::size_t{1});
+  }
+  if (search.stats != nullptr) {
+    auto fits = [&toAssign](const ColorSetType &palette) { return palette.countOr(toAssign) <= PAL_SIZE - 1; };
+    recordBranches(search, (covered ? 1 : 0) + std::count_if(state.hardwarePalettes.begin(),
+                                                             state.hardwarePalettes.begin() + stopLimit, fits));
+  }
   for (std::size_t i = 0; i < stopLimit; i++) {
-    const ColorSet &palette = state.hardwarePalettes.at(i);
+    const ColorSetType &palette = state.hardwarePalettes.at(i);
 
     // > PAL_SIZE - 1 because we need to save a slot for transparency
-    if ((palette | toAssign).count() > PAL_SIZE - 1) {
+    if (palette.countOr(toAssign) > PAL_SIZE - 1) {
       /*
        *  Skip this palette, cannot assign because there is not enough room in the palette. If we end up skipping
        * all of them that means the palettes are all too full and we cannot assign this tile in the state we are
@@ -142,60 +633,292 @@ AssignResult assignDepthFirst(PorytilesContext &ctx, CompilerMode compilerMode,
 
     /*
      * Prep the recursive call to assign(). If we got here, we know it is possible to assign toAssign to the palette
-     * at hardwarePalettes[i]. So we make a copy of unassigned with toAssign removed and a copy of hardwarePalettes
-     * with toAssigned assigned to the palette at index i. Then we call assign again with this updated state, and
-     * return true if there is a valid solution somewhere down in this recursive branch.
+     * at hardwarePalettes[i]. So we assign toAssign to the palette at index i in place and remove it from the
+     * unassigned counts. Then we call assign again with this updated state, and return true if there is a valid
+     * solution somewhere down in this recursive branch. Otherwise we undo the assignment and try the next palette.
      */
-    std::vector<ColorSet> hardwarePalettesCopy;
-    std::copy(std::begin(state.hardwarePalettes), std::end(state.hardwarePalettes),
-              std::back_inserter(hardwarePalettesCopy));
-    hardwarePalettesCopy.at(i) |= toAssign;
-    AssignState updatedState = {hardwarePalettesCopy, newUnassignedCount, newUnassignedPrimerCount};
+    ColorSetType previousPalette = state.hardwarePalettes[i];
+    state.hardwarePalettes.merge(i, toAssign);
+    state.unassignedCount = newUnassignedCount;
+    state.unassignedPrimerCount = newUnassignedPrimerCount;
 
     AssignResult result =
-        assignDepthFirst(ctx, compilerMode, updatedState, solution, primaryPalettes, unassigneds, unassignedPrimers);
-    if (result == AssignResult::SUCCESS) {
-      return AssignResult::SUCCESS;
-    }
-    else if (result == AssignResult::EXPLORE_CUTOFF_REACHED) {
-      return AssignResult::EXPLORE_CUTOFF_REACHED;
+        depthFirst(ctx, search, state, solution, coverage, unassigneds, unassignedPrimers, frontier, splitDepth - 1);
+    if (result != AssignResult::NO_SOLUTION_POSSIBLE) {
+      return result;
     }
+
+    state.hardwarePalettes.set(i, previousPalette);
+    state.unassignedCount = unassignedCount;
+    state.unassignedPrimerCount = unassignedPrimerCount;
   }
 
   // No solution found
+  state.hardwarePalettes = entryPalettes;
+  if (nogoods != nullptr) {
+    nogoods->insert(stateKey);
+  }
+  recordBacktrack(search, depth);
   return AssignResult::NO_SOLUTION_POSSIBLE;
 }
 
-AssignResult assignBreadthFirst(PorytilesContext &ctx, CompilerMode compilerMode, AssignState &initialState,
-                                std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
-                                const std::vector<ColorSet> &unassigneds,
-                                const std::vector<ColorSet> &unassignedPrimers)
+template <typename ColorSetType>
+AssignResult assignDepthFirst(const PorytilesContext &ctx, AssignSearch &search, BasicAssignState<ColorSetType> &state,
+                              std::vector<ColorSetType> &solution, const std::vector<ColorSetType> &primaryPalettes,
+                              const std::vector<ColorSetType> &unassigneds,
+                              const std::vector<ColorSetType> &unassignedPrimers)
+{
+  const PrimaryCoverage coverage = primaryCoverage(primaryPalettes, unassigneds, unassignedPrimers);
+  return depthFirst<ColorSetType>(ctx, search, state, solution, coverage, unassigneds, unassignedPrimers, nullptr, 0);
+}
+
+// We try to split the top of the tree into at least this many tasks per job, so there is always something to steal
+constexpr std::size_t PARALLEL_DFS_TASKS_PER_JOB = 16;
+
+/*
+ * A job's queue of DFS subtree tasks. The owner pops from the front, so it works through its tasks in DFS order, while
+ * idle jobs steal from the back.
+ */
+struct DepthFirstTaskQueue {
+  std::mutex mutex;
+  std::deque<std::size_t> taskIndexes;
+};
+
+template <typename ColorSetType>
+AssignResult assignDepthFirstParallel(const PorytilesContext &ctx, AssignSearch &search, std::size_t jobs,
+                                      BasicAssignState<ColorSetType> &state, std::vector<ColorSetType> &solution,
+                                      const std::vector<ColorSetType> &primaryPalettes,
+                                      const std::vector<ColorSetType> &unassigneds,
+                                      const std::vector<ColorSetType> &unassignedPrimers)
+{
+  if (jobs <= 1) {
+    return assignDepthFirst(ctx, search, state, solution, primaryPalettes, unassigneds, unassignedPrimers);
+  }
+
+  /*
+   * Split the top levels of the tree into subtree tasks, going one level deeper each time until there are enough tasks
+   * to keep every job busy. Every level re-walks the ones above it, so the split counts against the node budget and
+   * watches the same cancel token and deadline as the real search.
+   */
+  const PrimaryCoverage coverage = primaryCoverage(primaryPalettes, unassigneds, unassignedPrimers);
+  std::vector<BasicAssignState<ColorSetType>> tasks{};
+  // Same params as the real search, so the split visits the tree in the same order
+  AssignSearch splitSearch{search.params};
+  splitSearch.cancelToken = search.cancelToken;
+  splitSearch.coveringMoves = search.coveringMoves;
+  std::size_t maxSplitDepth = state.unassignedCount + state.unassignedPrimerCount;
+  for (std::size_t splitDepth = 1; splitDepth <= maxSplitDepth; splitDepth++) {
+    BasicAssignState<ColorSetType> splitState = state;
+    std::vector<ColorSetType> unusedSolution{};
+    tasks.clear();
+    AssignResult splitResult = depthFirst(ctx, splitSearch, splitState, unusedSolution, coverage, unassigneds,
+                                          unassignedPrimers, &tasks, splitDepth);
+    if (splitResult == AssignResult::EXPLORE_CUTOFF_REACHED || splitResult == AssignResult::CANCELLED) {
+      search.exploredNodeCounter += splitSearch.exploredNodeCounter;
+      search.timedOut = splitSearch.timedOut;
+      return splitResult;
+    }
+    if (tasks.size() >= jobs * PARALLEL_DFS_TASKS_PER_JOB) {
+      break;
+    }
+  }
+  search.exploredNodeCounter += splitSearch.exploredNodeCounter;
+  if (tasks.empty()) {
+    // Every branch was pruned before we got anywhere
+    return AssignResult::NO_SOLUTION_POSSIBLE;
+  }
+  // A shallow tree may split into fewer tasks than jobs, any job past the task count would only sit idle
+  jobs = std::min(jobs, tasks.size());
+  pt_logln(ctx, stderr, "split depth first search into {} tasks across {} jobs", tasks.size(), jobs);
+
+  /*
+   * Tasks are indexed in DFS order. Like the param search matrix, the lowest-index task that finds a solution wins.
+   * When a task succeeds we cancel everything after it and leave the tasks before it running. A win only stands once
+   * every task before it has run to the end without a solution, that way we return exactly the solution the serial
+   * search would have found, or no solution at all if the budget or the deadline cut one of those tasks short.
+   */
+  std::vector<std::vector<ColorSetType>> taskSolutions(tasks.size());
+  std::vector<std::atomic_bool> taskFinished(tasks.size());
+  std::vector<std::unique_ptr<AssignCancelToken>> taskCancelTokens{};
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    taskCancelTokens.push_back(std::make_unique<AssignCancelToken>(search.cancelToken));
+  }
+  std::vector<DepthFirstTaskQueue> queues(jobs);
+  for (std::size_t i = 0; i < tasks.size(); i++) {
+    queues.at(i % jobs).taskIndexes.push_back(i);
+  }
+  // The split already spent part of the budget
+  std::atomic_size_t sharedExploredNodeCounter{splitSearch.exploredNodeCounter};
+  std::atomic_size_t winningIndex{tasks.size()};
+  std::atomic_bool budgetExhausted{false};
+  std::atomic_bool timedOut{false};
+  std::atomic_size_t totalExploredNodes{0};
+  std::mutex workerErrorMutex{};
+  std::exception_ptr workerError = nullptr;
+
+  auto nextTask = [&](std::size_t job) -> std::size_t {
+    {
+      DepthFirstTaskQueue &own = queues.at(job);
+      std::lock_guard<std::mutex> lock{own.mutex};
+      if (!own.taskIndexes.empty()) {
+        std::size_t taskIndex = own.taskIndexes.front();
+        own.taskIndexes.pop_front();
+        return taskIndex;
+      }
+    }
+    for (std::size_t offset = 1; offset < jobs; offset++) {
+      DepthFirstTaskQueue &victim = queues.at((job + offset) % jobs);
+      std::lock_guard<std::mutex> lock{victim.mutex};
+      if (!victim.taskIndexes.empty()) {
+        std::size_t taskIndex = victim.taskIndexes.back();
+        victim.taskIndexes.pop_back();
+        return taskIndex;
+      }
+    }
+    // Tasks are never added once we start, so if every queue is empty we are done
+    return tasks.size();
+  };
+
+  std::vector<AssignStats> workerStats(search.stats != nullptr ? jobs : 0);
+  auto worker = [&](std::size_t job) {
+    AssignSearch workerSearch{search.params};
+    workerSearch.coveringMoves = search.coveringMoves;
+    workerSearch.sharedExploredNodeCounter = &sharedExploredNodeCounter;
+    workerSearch.sharedExploredNodeTotal = splitSearch.exploredNodeCounter;
+    if (search.stats != nullptr) {
+      workerSearch.stats = &workerStats.at(job);
+    }
+    // Every task searches the same problem, so a job can keep its failures across tasks
+    std::unique_ptr<NogoodTable> workerNogoods{};
+    if (search.nogoods != nullptr) {
+      workerNogoods = std::make_unique<NogoodTable>(NOGOOD_TABLE_BUCKETS);
+      workerSearch.nogoods = workerNogoods.get();
+    }
+    try {
+      for (std::size_t taskIndex = nextTask(job); taskIndex < tasks.size(); taskIndex = nextTask(job)) {
+        if (taskIndex > winningIndex.load() || budgetExhausted.load()) {
+          continue;
+        }
+        workerSearch.cancelToken = taskCancelTokens.at(taskIndex).get();
+        BasicAssignState<ColorSetType> taskState = tasks.at(taskIndex);
+        AssignResult result = depthFirst<ColorSetType>(ctx, workerSearch, taskState, taskSolutions.at(taskIndex),
+                                                       coverage, unassigneds, unassignedPrimers, nullptr, 0);
+        if (result == AssignResult::SUCCESS || result == AssignResult::NO_SOLUTION_POSSIBLE) {
+          taskFinished.at(taskIndex).store(true);
+        }
+        if (result == AssignResult::SUCCESS) {
+          std::size_t currentWinner = winningIndex.load();
+          while (taskIndex < currentWinner && !winningIndex.compare_exchange_weak(currentWinner, taskIndex)) {
+          }
+          for (std::size_t i = taskIndex + 1; i < tasks.size(); i++) {
+            taskCancelTokens.at(i)->cancel();
+          }
+        }
+        else if (result == AssignResult::EXPLORE_CUTOFF_REACHED) {
+          budgetExhausted.store(true);
+          for (auto &token : taskCancelTokens) {
+            token->cancel();
+          }
+        }
+        else if (result == AssignResult::CANCELLED && workerSearch.timedOut) {
+          // The deadline is shared, so the other tasks would only notice it a little later
+          timedOut.store(true);
+          for (auto &token : taskCancelTokens) {
+            token->cancel();
+          }
+        }
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock{workerErrorMutex};
+      if (workerError == nullptr) {
+        workerError = std::current_exception();
+      }
+      for (auto &token : taskCancelTokens) {
+        token->cancel();
+      }
+    }
+    totalExploredNodes.fetch_add(workerSearch.exploredNodeCounter);
+  };
+
+  std::vector<std::thread> workers{};
+  for (std::size_t job = 1; job < jobs; job++) {
+    workers.emplace_back(worker, job);
+  }
+  worker(0);
+  for (auto &thread : workers) {
+    thread.join();
+  }
+  if (workerError != nullptr) {
+    std::rethrow_exception(workerError);
+  }
+  search.exploredNodeCounter += totalExploredNodes.load();
+  for (const auto &stats : workerStats) {
+    mergeAssignStats(*search.stats, stats);
+  }
+
+  std::size_t winner = winningIndex.load();
+  bool winnerSettled = winner < tasks.size() && std::all_of(std::begin(taskFinished), std::begin(taskFinished) + winner,
+                                                            [](const std::atomic_bool &done) { return done.load(); });
+  if (winnerSettled) {
+    const std::vector<ColorSetType> &winningSolution = taskSolutions.at(winner);
+    std::copy(std::begin(winningSolution), std::end(winningSolution), std::back_inserter(solution));
+    return AssignResult::SUCCESS;
+  }
+  if (timedOut.load()) {
+    search.timedOut = true;
+    return AssignResult::CANCELLED;
+  }
+  if (search.isCancelled()) {
+    return AssignResult::CANCELLED;
+  }
+  // Only a spent budget leaves a task before the winner unfinished once the timeout and cancellation are ruled out
+  if (budgetExhausted.load() || winner < tasks.size()) {
+    return AssignResult::EXPLORE_CUTOFF_REACHED;
+  }
+  return AssignResult::NO_SOLUTION_POSSIBLE;
+}
+
+template <typename ColorSetType>
+AssignResult assignBreadthFirst(const PorytilesContext &ctx, AssignSearch &search,
+                                BasicAssignState<ColorSetType> &initialState, std::vector<ColorSetType> &solution,
+                                const std::vector<ColorSetType> &primaryPalettes,
+                                const std::vector<ColorSetType> &unassigneds,
+                                const std::vector<ColorSetType> &unassignedPrimers)
 {
-  std::size_t exploredNodeCutoff = compilerMode == CompilerMode::PRIMARY
-                                       ? ctx.compilerConfig.primaryExploredNodeCutoff
-                                       : ctx.compilerConfig.secondaryExploredNodeCutoff;
-  std::size_t bestBranches = compilerMode == CompilerMode::PRIMARY ? ctx.compilerConfig.primaryBestBranches
-                                                                   : ctx.compilerConfig.secondaryBestBranches;
-  bool smartPrune = compilerMode == CompilerMode::PRIMARY ? ctx.compilerConfig.primarySmartPrune
-                                                          : ctx.compilerConfig.secondarySmartPrune;
-
-  std::unordered_set<AssignState> visitedStates{};
-  std::deque<AssignState> stateQueue{};
-  std::deque<AssignState> lowPriorityQueue{};
+  std::size_t bestBranches = search.params.bestBranches;
+  bool smartPrune = search.params.smartPrune;
+  const PrimaryCoverage coverage = primaryCoverage(primaryPalettes, unassigneds, unassignedPrimers);
+
+  /*
+   * The visited set holds canonical states, so it recognizes a state even when we reach it with the palettes in another
+   * order. The queues keep whichever ordering we saw first, that is what the palette sort heuristic works off of.
+   */
+  std::unordered_set<BasicAssignState<ColorSetType>> visitedStates{};
+  std::deque<BasicAssignState<ColorSetType>> stateQueue{};
+  std::deque<BasicAssignState<ColorSetType>> lowPriorityQueue{};
   stateQueue.push_back(initialState);
-  visitedStates.insert(initialState);
+  visitedStates.insert(canonicalAssignState(initialState));
 
   while (!stateQueue.empty() || !lowPriorityQueue.empty()) {
-    AssignState currentState;
-    ctx.compilerContext.exploredNodeCounter++;
-    if (ctx.compilerContext.exploredNodeCounter % EXPLORATION_CUTOFF_MULTIPLIER == 0) {
-      pt_logln(ctx, stderr, "exploredNodeCounter passed factor {}, stateQueue={}, lowPrioQueue={}",
-               ctx.compilerContext.exploredNodeCounter / EXPLORATION_CUTOFF_MULTIPLIER, stateQueue.size(),
-               lowPriorityQueue.size());
+    BasicAssignState<ColorSetType> currentState;
+    if (search.stats != nullptr) {
+      search.stats->queueHighWater = std::max(search.stats->queueHighWater, stateQueue.size());
+      search.stats->lowPriorityQueueHighWater =
+          std::max(search.stats->lowPriorityQueueHighWater, lowPriorityQueue.size());
     }
-    if (ctx.compilerContext.exploredNodeCounter > exploredNodeCutoff) {
+    if (!exploreNode(search)) {
+      recordVisitedStates(search, visitedStates);
       return AssignResult::EXPLORE_CUTOFF_REACHED;
     }
+    if (search.exploredNodeCounter % EXPLORATION_CUTOFF_MULTIPLIER == 0) {
+      pt_logln(ctx, stderr, "exploredNodeCounter passed factor {}, stateQueue={}, lowPrioQueue={}",
+               search.exploredNodeCounter / EXPLORATION_CUTOFF_MULTIPLIER, stateQueue.size(), lowPriorityQueue.size());
+    }
+    if (search.isCancelled()) {
+      recordVisitedStates(search, visitedStates);
+      return AssignResult::CANCELLED;
+    }
 
     if (!stateQueue.empty()) {
       currentState = stateQueue.front();
@@ -205,16 +928,25 @@ AssignResult assignBreadthFirst(PorytilesContext &ctx, CompilerMode compilerMode
       currentState = lowPriorityQueue.front();
       lowPriorityQueue.pop_front();
     }
+    const std::size_t depth = assignDepth(currentState, unassigneds, unassignedPrimers);
+    recordDepth(search, depth);
 
     if (currentState.unassignedPrimerCount == 0 && currentState.unassignedCount == 0) {
       // No tiles left to assign, found a solution!
       std::copy(std::begin(currentState.hardwarePalettes), std::end(currentState.hardwarePalettes),
                 std::back_inserter(solution));
+      recordVisitedStates(search, visitedStates);
       return AssignResult::SUCCESS;
     }
 
+    if (remainingCannotFit(currentState, coverage, unassigneds, unassignedPrimers)) {
+      recordBacktrack(search, depth);
+      continue;
+    }
+
+    const bool covered = nextCoveredByPrimary(coverage, currentState);
     // const ColorSet &toAssign = unassigneds.at(currentState.unassignedCount - 1);
-    ColorSet toAssign{};
+    ColorSetType toAssign{};
     std::size_t newUnassignedPrimerCount = currentState.unassignedPrimerCount;
     std::size_t newUnassignedCount = currentState.unassignedCount;
     if (currentState.unassignedPrimerCount != 0) {
@@ -229,47 +961,29 @@ AssignResult assignBreadthFirst(PorytilesContext &ctx, CompilerMode compilerMode
       internalerror("reached bad else clause in palette_assignment::assignDepthFirst");
     }
 
-    bool foundPrimaryMatch = false;
-    if (!primaryPalettes.empty()) {
-      for (std::size_t i = 0; i < primaryPalettes.size(); i++) {
-        const ColorSet &palette = primaryPalettes.at(i);
-        if ((palette | toAssign).count() == palette.count()) {
-          std::vector<ColorSet> hardwarePalettesCopy;
-          std::copy(std::begin(currentState.hardwarePalettes), std::end(currentState.hardwarePalettes),
-                    std::back_inserter(hardwarePalettesCopy));
-          AssignState updatedState = {hardwarePalettesCopy, newUnassignedCount, newUnassignedPrimerCount};
-          stateQueue.push_back(updatedState);
-          visitedStates.insert(updatedState);
-          foundPrimaryMatch = true;
-        }
-      }
-    }
-
     /*
-     * If we found a matching primary palette for the current assignment, go ahead and skip ahead to the next toAssign.
-     * No need to process anything further for this toAssign.
+     * If a primary palette covers the current assignment, go ahead and skip ahead to the next toAssign. No need to
+     * process anything further for this toAssign. Every covering palette leads to the same state, so we queue it once.
      */
-    if (foundPrimaryMatch) {
+    if (covered) {
+      BasicAssignState<ColorSetType> updatedState = {currentState.hardwarePalettes, newUnassignedCount,
+                                                     newUnassignedPrimerCount};
+      stateQueue.push_back(updatedState);
+      visitedStates.insert(canonicalAssignState(updatedState));
+      recordBranches(search, 1);
       continue;
     }
 
-    std::stable_sort(std::begin(currentState.hardwarePalettes), std::end(currentState.hardwarePalettes),
-                     [&toAssign](const auto &pal1, const auto &pal2) {
-                       std::size_t pal1IntersectSize = (pal1 & toAssign).count();
-                       std::size_t pal2IntersectSize = (pal2 & toAssign).count();
-                       if (pal1IntersectSize == pal2IntersectSize) {
-                         return pal1.count() < pal2.count();
-                       }
-                       return pal1IntersectSize > pal2IntersectSize;
-                     });
+    sortPalettesForAssignment(currentState.hardwarePalettes, toAssign);
 
     bool sawAssignmentWithIntersection = false;
+    std::size_t branches = 0;
     std::size_t stopLimit = std::min(currentState.hardwarePalettes.size(), bestBranches);
     if (smartPrune) {
       // Shrink stopLimit so it ends after the first empty hardware palette
       for (std::size_t i = 0; i < stopLimit; i++) {
         auto pal = currentState.hardwarePalettes.at(i);
-        std::size_t palIntersectSize = (pal & toAssign).count();
+        std::size_t palIntersectSize = pal.countAnd(toAssign);
         if (palIntersectSize == 0) {
           stopLimit = i + 1;
           break;
@@ -278,103 +992,1076 @@ AssignResult assignBreadthFirst(PorytilesContext &ctx, CompilerMode compilerMode
     }
     // Ensure stopLimit does not exceed the palette list size
     stopLimit = std::min(currentState.hardwarePalettes.size(), stopLimit);
+    if (forceCoveringPalette(search, currentState.hardwarePalettes, toAssign)) {
+      stopLimit = std::min(stopLimit, std::size_t{1});
+    }
     for (size_t i = 0; i < stopLimit; i++) {
-      const ColorSet &palette = currentState.hardwarePalettes.at(i);
+      const ColorSetType &palette = currentState.hardwarePalettes.at(i);
 
       // > PAL_SIZE - 1 because we need to save a slot for transparency
-      if ((palette | toAssign).count() > PAL_SIZE - 1) {
+      if (palette.countOr(toAssign) > PAL_SIZE - 1) {
         continue;
       }
 
-      if ((palette & toAssign).count() > 0) {
+      if (palette.intersects(toAssign)) {
         sawAssignmentWithIntersection = true;
       }
+      branches++;
 
-      std::vector<ColorSet> hardwarePalettesCopy;
-      std::copy(std::begin(currentState.hardwarePalettes), std::end(currentState.hardwarePalettes),
-                std::back_inserter(hardwarePalettesCopy));
-      hardwarePalettesCopy.at(i) |= toAssign;
-      AssignState updatedState = {hardwarePalettesCopy, newUnassignedCount, newUnassignedPrimerCount};
-      if (!visitedStates.contains(updatedState)) {
-        if (sawAssignmentWithIntersection && (palette & toAssign).count() == 0) {
+      BasicAssignState<ColorSetType> updatedState = {currentState.hardwarePalettes, newUnassignedCount,
+                                                     newUnassignedPrimerCount};
+      updatedState.hardwarePalettes.merge(i, toAssign);
+      BasicAssignState<ColorSetType> canonicalState = canonicalAssignState(updatedState);
+      if (!visitedStates.contains(canonicalState)) {
+        if (sawAssignmentWithIntersection && !palette.intersects(toAssign)) {
           /*
            * Heuristic: if we already saw at least one assignment that had some intersection, put the 0-intersection
            * branches in a lower-priority queue
            */
           lowPriorityQueue.push_back(updatedState);
-          visitedStates.insert(updatedState);
+          visitedStates.insert(canonicalState);
         }
         else {
           stateQueue.push_back(updatedState);
-          visitedStates.insert(updatedState);
+          visitedStates.insert(canonicalState);
         }
       }
     }
+    recordBranches(search, branches);
+    if (branches == 0) {
+      recordBacktrack(search, depth);
+    }
   }
 
+  recordVisitedStates(search, visitedStates);
   return AssignResult::NO_SOLUTION_POSSIBLE;
 }
 
-static auto tryAssignment(PorytilesContext &ctx, CompilerMode compilerMode, const std::vector<ColorSet> &colorSets,
-                          const std::vector<ColorSet> &primerColorSets,
-                          const std::unordered_map<BGR15, std::size_t> &colorToIndex, bool printErrors)
+/*
+ * Depth first search has a heavy tail: a bad choice near the root can trap it in a subtree with no solution for its
+ * whole budget. Restarting every so often with a different branch order gives it many short, independent shots
+ * instead. The burst budgets follow the Luby sequence (1, 1, 2, 1, 1, 2, 4, ...) times LUBY_RESTART_UNIT nodes,
+ * which is within a log factor of the best fixed restart budget without having to know what that budget is.
+ *
+ * The first burst keeps the plain branch order, the others each get a seed derived from RESTART_SEED_BASE, so a given
+ * input always runs the same bursts.
+ */
+constexpr std::size_t LUBY_RESTART_UNIT = 10'000;
+constexpr std::uint64_t RESTART_SEED_BASE = 0x1ab7e57a47ULL;
+
+// The i-th term of the Luby sequence, counting from 1
+static std::size_t lubyTerm(std::size_t i)
 {
-  std::vector<ColorSet> assignedPalsSolution{};
-  std::vector<ColorSet> tmpHardwarePalettes{};
-  if (compilerMode == CompilerMode::PRIMARY) {
-    assignedPalsSolution.reserve(ctx.fieldmapConfig.numPalettesInPrimary);
-    tmpHardwarePalettes.resize(ctx.fieldmapConfig.numPalettesInPrimary);
-  }
-  else if (compilerMode == CompilerMode::SECONDARY) {
-    assignedPalsSolution.reserve(ctx.fieldmapConfig.numPalettesInSecondary());
-    tmpHardwarePalettes.resize(ctx.fieldmapConfig.numPalettesInSecondary());
+  while (true) {
+    std::size_t k = 1;
+    while ((std::size_t{1} << k) - 1 < i) {
+      k++;
+    }
+    if (i == (std::size_t{1} << k) - 1) {
+      return std::size_t{1} << (k - 1);
+    }
+    i -= (std::size_t{1} << (k - 1)) - 1;
   }
-  else {
-    internalerror_unknownCompilerMode("compiler::compile");
+}
+
+static std::uint64_t restartSeed(std::size_t restart)
+{
+  if (restart == 0) {
+    return 0;
   }
+  // 0 is the plain order, so no seeded restart may use it
+  std::uint64_t seed = mixHash64(RESTART_SEED_BASE + restart);
+  return seed == 0 ? 1 : seed;
+}
+
+/*
+ * Bursts run serially. Each one is too short to win back the cost of splitting its tree across jobs, and a new seed
+ * reorders the branches, so no split could be reused from one burst to the next. The parameter search matrix already
+ * runs its entries across the jobs.
+ */
+template <typename ColorSetType>
+AssignResult assignDepthFirstRestarts(const PorytilesContext &ctx, AssignSearch &search,
+                                      BasicAssignState<ColorSetType> &state, std::vector<ColorSetType> &solution,
+                                      const std::vector<ColorSetType> &primaryPalettes,
+                                      const std::vector<ColorSetType> &unassigneds,
+                                      const std::vector<ColorSetType> &unassignedPrimers)
+{
+  NogoodTable nogoods{NOGOOD_TABLE_BUCKETS};
+  std::size_t remainingNodes = search.params.exploredNodeCutoff;
+  for (std::size_t restart = 0; remainingNodes > 0; restart++) {
+    AssignParams burstParams = search.params;
+    burstParams.restarts = false;
+    burstParams.seed = restartSeed(restart);
+    burstParams.exploredNodeCutoff = std::min(LUBY_RESTART_UNIT * lubyTerm(restart + 1), remainingNodes);
+    AssignSearch burst{burstParams};
+    burst.cancelToken = search.cancelToken;
+    burst.coveringMoves = search.coveringMoves;
+    burst.stats = search.stats;
+    // Which states fail depends on the branch order, so every burst starts with an empty table
+    nogoods.clear();
+    burst.nogoods = &nogoods;
+
+    BasicAssignState<ColorSetType> burstState = state;
+    AssignResult result =
+        assignDepthFirst(ctx, burst, burstState, solution, primaryPalettes, unassigneds, unassignedPrimers);
+    std::size_t burstNodes = std::min(burst.exploredNodeCounter, burstParams.exploredNodeCutoff);
+    search.exploredNodeCounter += burstNodes;
+    remainingNodes -= burstNodes;
+    if (result == AssignResult::SUCCESS) {
+      pt_logln(ctx, stderr, "depth first restart {} with seed {} found a solution", restart, burstParams.seed);
+      search.params.seed = burstParams.seed;
+      search.params.restarts = false;
+      return AssignResult::SUCCESS;
+    }
+    if (result == AssignResult::CANCELLED) {
+      search.timedOut = burst.timedOut;
+      return result;
+    }
+    /*
+     * A burst that got through its whole tree only proves there is no solution if every order leads to the same tree:
+     * that is the first burst, which a plain run replays, or a search that tries every palette at every node. With
+     * smart prune or fewer best branches than palettes, a seeded order tries other palettes, so the next burst may
+     * still find a solution.
+     */
+    if (result == AssignResult::NO_SOLUTION_POSSIBLE &&
+        (restart == 0 || branchesExhaustively(search, state.hardwarePalettes.size()))) {
+      return result;
+    }
+  }
+  return AssignResult::EXPLORE_CUTOFF_REACHED;
+}
+
+/*
+ * Beam search walks the tree one depth at a time like breadth first search, but once a depth is expanded it keeps only
+ * the beamWidth most promising states and drops the rest. So memory stays bounded by the beam width (times the palette
+ * count while a depth is being expanded), where the breadth first queues grow with the tree. The price is that a
+ * dropped state may have been the only way to a solution: if the beam ever had to drop states and then runs dry, we
+ * report the cutoff as reached rather than claim there is no solution.
+ *
+ * Every state at one depth has assigned the same ColorSets, so they only differ in how much their palettes share. The
+ * fewer colors a state holds in total the better, then the more palettes it leaves empty. Any remaining tie goes to the
+ * state generated first, which keeps the search deterministic.
+ */
+template <typename ColorSetType> struct BeamCandidate {
+  BasicAssignState<ColorSetType> state;
+  std::size_t usedColors;
+  std::size_t emptyPalettes;
+  std::size_t order;
+};
+
+template <typename ColorSetType>
+static bool beamCandidateBetter(const BeamCandidate<ColorSetType> &c1, const BeamCandidate<ColorSetType> &c2)
+{
+  if (c1.usedColors != c2.usedColors) {
+    return c1.usedColors < c2.usedColors;
+  }
+  if (c1.emptyPalettes != c2.emptyPalettes) {
+    return c1.emptyPalettes > c2.emptyPalettes;
+  }
+  return c1.order < c2.order;
+}
+
+template <typename ColorSetType>
+AssignResult assignBeamSearch(const PorytilesContext &ctx, AssignSearch &search,
+                              BasicAssignState<ColorSetType> &initialState, std::vector<ColorSetType> &solution,
+                              const std::vector<ColorSetType> &primaryPalettes,
+                              const std::vector<ColorSetType> &unassigneds,
+                              const std::vector<ColorSetType> &unassignedPrimers)
+{
+  std::size_t beamWidth = std::max(search.params.beamWidth, std::size_t{1});
+  std::size_t bestBranches = search.params.bestBranches;
+  bool smartPrune = search.params.smartPrune;
+  bool droppedStates = false;
+  const PrimaryCoverage coverage = primaryCoverage(primaryPalettes, unassigneds, unassignedPrimers);
+
+  std::vector<BasicAssignState<ColorSetType>> beam{initialState};
+  std::vector<BeamCandidate<ColorSetType>> candidates{};
+  // Canonical states already generated for the next depth, so permutations of one state only take up one beam slot
+  std::unordered_set<BasicAssignState<ColorSetType>> nextDepthStates{};
+  auto addCandidate = [&](const BasicAssignState<ColorSetType> &state) {
+    if (!nextDepthStates.insert(canonicalAssignState(state)).second) {
+      return;
+    }
+    std::size_t usedColors = 0;
+    std::size_t emptyPalettes = 0;
+    for (const auto &palette : state.hardwarePalettes) {
+      usedColors += palette.count();
+      if (palette.none()) {
+        emptyPalettes++;
+      }
+    }
+    candidates.push_back(BeamCandidate<ColorSetType>{state, usedColors, emptyPalettes, candidates.size()});
+  };
+
+  while (!beam.empty()) {
+    candidates.clear();
+    nextDepthStates.clear();
+    for (BasicAssignState<ColorSetType> &currentState : beam) {
+      if (!exploreNode(search)) {
+        return AssignResult::EXPLORE_CUTOFF_REACHED;
+      }
+      if (search.exploredNodeCounter % EXPLORATION_CUTOFF_MULTIPLIER == 0) {
+        pt_logln(ctx, stderr, "exploredNodeCounter passed factor {}, beam={}, candidates={}",
+                 search.exploredNodeCounter / EXPLORATION_CUTOFF_MULTIPLIER, beam.size(), candidates.size());
+      }
+      if (search.isCancelled()) {
+        return AssignResult::CANCELLED;
+      }
+      const std::size_t depth = assignDepth(currentState, unassigneds, unassignedPrimers);
+      recordDepth(search, depth);
+
+      if (currentState.unassignedPrimerCount == 0 && currentState.unassignedCount == 0) {
+        // No tiles left to assign, found a solution!
+        std::copy(std::begin(currentState.hardwarePalettes), std::end(currentState.hardwarePalettes),
+                  std::back_inserter(solution));
+        return AssignResult::SUCCESS;
+      }
+
+      if (remainingCannotFit(currentState, coverage, unassigneds, unassignedPrimers)) {
+        recordBacktrack(search, depth);
+        continue;
+      }
+
+      const bool covered = nextCoveredByPrimary(coverage, currentState);
+      ColorSetType toAssign{};
+      std::size_t newUnassignedPrimerCount = currentState.unassignedPrimerCount;
+      std::size_t newUnassignedCount = currentState.unassignedCount;
+      if (currentState.unassignedPrimerCount != 0) {
+        toAssign = unassignedPrimers.at(currentState.unassignedPrimerCount - 1);
+        newUnassignedPrimerCount = currentState.unassignedPrimerCount - 1;
+      }
+      else if (currentState.unassignedPrimerCount == 0 && currentState.unassignedCount != 0) {
+        toAssign = unassigneds.at(currentState.unassignedCount - 1);
+        newUnassignedCount = currentState.unassignedCount - 1;
+      }
+      else {
+        internalerror("reached bad else clause in palette_assignment::assignBeamSearch");
+      }
+
+      // A primary palette that covers toAssign leaves the state unchanged, so that is the only child worth keeping
+      if (covered) {
+        addCandidate(BasicAssignState<ColorSetType>{currentState.hardwarePalettes, newUnassignedCount,
+                                                    newUnassignedPrimerCount});
+        recordBranches(search, 1);
+        continue;
+      }
+
+      sortPalettesForAssignment(currentState.hardwarePalettes, toAssign);
+
+      std::size_t stopLimit = std::min(currentState.hardwarePalettes.size(), bestBranches);
+      if (smartPrune) {
+        // Shrink stopLimit so it ends after the first empty hardware palette
+        for (std::size_t i = 0; i < stopLimit; i++) {
+          if (!currentState.hardwarePalettes.at(i).intersects(toAssign)) {
+            stopLimit = i + 1;
+            break;
+          }
+        }
+      }
+      if (forceCoveringPalette(search, currentState.hardwarePalettes, toAssign)) {
+        stopLimit = std::min(stopLimit, std::size_t{1});
+      }
+      std::size_t branches = 0;
+      for (std::size_t i = 0; i < stopLimit; i++) {
+        // > PAL_SIZE - 1 because we need to save a slot for transparency
+        if (currentState.hardwarePalettes.at(i).countOr(toAssign) > PAL_SIZE - 1) {
+          continue;
+        }
+        BasicAssignState<ColorSetType> updatedState = {currentState.hardwarePalettes, newUnassignedCount,
+                                                       newUnassignedPrimerCount};
+        updatedState.hardwarePalettes.merge(i, toAssign);
+        addCandidate(updatedState);
+        branches++;
+      }
+      recordBranches(search, branches);
+      if (branches == 0) {
+        recordBacktrack(search, depth);
+      }
+    }
+
+    // The candidates for the next depth are the beam's equivalent of the breadth first queue
+    if (search.stats != nullptr) {
+      search.stats->queueHighWater = std::max(search.stats->queueHighWater, candidates.size());
+    }
+    recordVisitedStates(search, nextDepthStates);
+
+    if (candidates.size() > beamWidth) {
+      droppedStates = true;
+      std::partial_sort(std::begin(candidates), std::begin(candidates) + beamWidth, std::end(candidates),
+                        beamCandidateBetter<ColorSetType>);
+      candidates.erase(std::begin(candidates) + beamWidth, std::end(candidates));
+    }
+    beam.clear();
+    for (auto &candidate : candidates) {
+      beam.push_back(std::move(candidate.state));
+    }
+  }
+
+  return droppedStates ? AssignResult::EXPLORE_CUTOFF_REACHED : AssignResult::NO_SOLUTION_POSSIBLE;
+}
+
+/*
+ * Local search works on a complete assignment: every ColorSet always sits in some palette, palettes are allowed to
+ * overflow, and we move ColorSets around until no palette holds more than PAL_SIZE - 1 colors. Unlike the tree
+ * searches it never proves anything, but on dense tilesets it can find packings long after DFS and BFS have run out of
+ * budget, since it never has to backtrack out of a bad early choice.
+ *
+ * The search itself is a tabu search. Every iteration picks an overflowing palette and takes the best move out of it:
+ * either move one of its ColorSets to another palette, or swap one of them with a ColorSet from elsewhere. A ColorSet
+ * that just moved is tabu for a few iterations so we don't immediately undo the move, unless undoing it would beat the
+ * best overflow seen so far. Ties are broken with a fixed seed, so a given input always produces the same output.
+ */
+constexpr std::uint64_t LOCAL_SEARCH_SEED = 0x5eed0fc01075ULL;
+constexpr std::size_t LOCAL_SEARCH_MIN_TENURE = 7;
+
+template <typename ColorSetType> struct LocalSearch {
+  std::size_t paletteCount;
+  std::vector<ColorSetType> sets;
+  std::vector<std::vector<std::uint8_t>> setColors;
+  std::vector<std::size_t> assignment;
+  // How many of the ColorSets in each palette use each color, a base color from the starting state counts as one more
+  std::vector<std::uint16_t> colorRefs;
+  std::vector<std::size_t> paletteSizes;
+  std::size_t overflow;
+
+  explicit LocalSearch(const BasicHardwarePalettes<ColorSetType> &basePalettes)
+      : paletteCount{basePalettes.size()}, sets{}, setColors{}, assignment{},
+        colorRefs(basePalettes.size() * ColorSetType{}.size()), paletteSizes(basePalettes.size()), overflow{0}
+  {
+    for (std::size_t p = 0; p < paletteCount; p++) {
+      for (std::size_t color = 0; color < ColorSetType{}.size(); color++) {
+        if (basePalettes[p].test(color)) {
+          refs(p, color) = 1;
+          paletteSizes.at(p)++;
+        }
+      }
+      overflow += overflowOf(paletteSizes.at(p));
+    }
+  }
+
+  static std::size_t overflowOf(std::size_t size) { return size > PAL_SIZE - 1 ? size - (PAL_SIZE - 1) : 0; }
+
+  std::uint16_t &refs(std::size_t palette, std::size_t color)
+  {
+    return colorRefs[palette * ColorSetType{}.size() + color];
+  }
+
+  void addSet(const ColorSetType &colorSet)
+  {
+    sets.push_back(colorSet);
+    setColors.emplace_back();
+    for (std::size_t color = 0; color < colorSet.size(); color++) {
+      if (colorSet.test(color)) {
+        setColors.back().push_back(static_cast<std::uint8_t>(color));
+      }
+    }
+    assignment.push_back(paletteCount);
+  }
+
+  // How many colors putting set `s' into `palette' would add
+  std::size_t addedColors(std::size_t s, std::size_t palette)
+  {
+    return std::count_if(std::begin(setColors.at(s)), std::end(setColors.at(s)),
+                         [&](std::uint8_t color) { return refs(palette, color) == 0; });
+  }
+
+  // How many colors taking set `s' out of its palette would free up
+  std::size_t freedColors(std::size_t s)
+  {
+    return std::count_if(std::begin(setColors.at(s)), std::end(setColors.at(s)),
+                         [&](std::uint8_t color) { return refs(assignment.at(s), color) == 1; });
+  }
+
+  void place(std::size_t s, std::size_t palette)
+  {
+    overflow -= overflowOf(paletteSizes.at(palette));
+    for (std::uint8_t color : setColors.at(s)) {
+      if (refs(palette, color)++ == 0) {
+        paletteSizes.at(palette)++;
+      }
+    }
+    overflow += overflowOf(paletteSizes.at(palette));
+    assignment.at(s) = palette;
+  }
+
+  void unplace(std::size_t s)
+  {
+    std::size_t palette = assignment.at(s);
+    overflow -= overflowOf(paletteSizes.at(palette));
+    for (std::uint8_t color : setColors.at(s)) {
+      if (--refs(palette, color) == 0) {
+        paletteSizes.at(palette)--;
+      }
+    }
+    overflow += overflowOf(paletteSizes.at(palette));
+    assignment.at(s) = paletteCount;
+  }
+
+  // Change in total overflow if set `s' moved to palette `to'
+  long moveDelta(std::size_t s, std::size_t to)
+  {
+    std::size_t from = assignment.at(s);
+    std::size_t fromSize = paletteSizes.at(from);
+    std::size_t toSize = paletteSizes.at(to);
+    return static_cast<long>(overflowOf(fromSize - freedColors(s)) + overflowOf(toSize + addedColors(s, to))) -
+           static_cast<long>(overflowOf(fromSize) + overflowOf(toSize));
+  }
+
+  // Change in total overflow if sets `s' and `t' traded palettes
+  long swapDelta(std::size_t s, std::size_t t)
+  {
+    std::size_t before = overflow;
+    std::size_t sPalette = assignment.at(s);
+    std::size_t tPalette = assignment.at(t);
+    unplace(s);
+    place(s, tPalette);
+    long delta = static_cast<long>(overflow) - static_cast<long>(before) + moveDelta(t, sPalette);
+    unplace(s);
+    place(s, sPalette);
+    return delta;
+  }
+
+  /*
+   * Seed with the same greedy order the tree searches use: primers first, then regular ColorSets, biggest first. Each
+   * one goes into the palette it shares the most colors with, ties to the smaller palette, skipping palettes it would
+   * overflow. If it overflows every palette it goes wherever it overflows least.
+   */
+  void seedGreedy(const std::vector<std::size_t> &order)
+  {
+    for (std::size_t s : order) {
+      std::size_t best = paletteCount;
+      std::size_t bestShared = 0;
+      std::size_t fallback = 0;
+      std::size_t fallbackOverflow = SIZE_MAX;
+      for (std::size_t p = 0; p < paletteCount; p++) {
+        std::size_t added = addedColors(s, p);
+        std::size_t shared = setColors.at(s).size() - added;
+        std::size_t newSize = paletteSizes.at(p) + added;
+        if (newSize <= PAL_SIZE - 1) {
+          if (best == paletteCount || shared > bestShared ||
+              (shared == bestShared && paletteSizes.at(p) < paletteSizes.at(best))) {
+            best = p;
+            bestShared = shared;
+          }
+        }
+        else if (overflowOf(newSize) < fallbackOverflow) {
+          fallback = p;
+          fallbackOverflow = overflowOf(newSize);
+        }
+      }
+      place(s, best == paletteCount ? fallback : best);
+    }
+  }
+};
+
+template <typename ColorSetType>
+AssignResult assignLocalSearch(const PorytilesContext &ctx, AssignSearch &search,
+                               BasicAssignState<ColorSetType> &state, std::vector<ColorSetType> &solution,
+                               const std::vector<ColorSetType> &primaryPalettes,
+                               const std::vector<ColorSetType> &unassigneds,
+                               const std::vector<ColorSetType> &unassignedPrimers)
+{
+  LocalSearch<ColorSetType> local{state.hardwarePalettes};
+  std::vector<std::size_t> order{};
+  auto consider = [&](const ColorSetType &colorSet) {
+    // Like the tree searches, a ColorSet a primary palette covers needs no palette of its own
+    if (colorSet.any() && !coveredByPrimary(primaryPalettes, colorSet)) {
+      order.push_back(local.sets.size());
+      local.addSet(colorSet);
+    }
+  };
+  for (std::size_t i = state.unassignedPrimerCount; i > 0; i--) {
+    consider(unassignedPrimers.at(i - 1));
+  }
+  for (std::size_t i = state.unassignedCount; i > 0; i--) {
+    consider(unassigneds.at(i - 1));
+  }
+  if (local.paletteCount == 0) {
+    if (!local.sets.empty()) {
+      return AssignResult::NO_SOLUTION_POSSIBLE;
+    }
+    return AssignResult::SUCCESS;
+  }
+  local.seedGreedy(order);
+
+  std::mt19937_64 rng{LOCAL_SEARCH_SEED};
+  std::vector<std::size_t> tabuUntil(local.sets.size(), 0);
+  std::size_t bestOverflow = local.overflow;
+  std::vector<std::size_t> overflowing{};
+  std::vector<std::size_t> members{};
+  for (std::size_t iteration = 0; local.overflow > 0; iteration++) {
+    if (!exploreNode(search)) {
+      return AssignResult::EXPLORE_CUTOFF_REACHED;
+    }
+    if (search.exploredNodeCounter % EXPLORATION_CUTOFF_MULTIPLIER == 0) {
+      pt_logln(ctx, stderr, "exploredNodeCounter passed {} iterations, overflow={}, best={}",
+               search.exploredNodeCounter, local.overflow, bestOverflow);
+    }
+    if (search.isCancelled()) {
+      return AssignResult::CANCELLED;
+    }
+
+    overflowing.clear();
+    for (std::size_t p = 0; p < local.paletteCount; p++) {
+      if (LocalSearch<ColorSetType>::overflowOf(local.paletteSizes.at(p)) > 0) {
+        overflowing.push_back(p);
+      }
+    }
+    std::size_t palette = overflowing.at(rng() % overflowing.size());
+    members.clear();
+    for (std::size_t s = 0; s < local.sets.size(); s++) {
+      if (local.assignment.at(s) == palette) {
+        members.push_back(s);
+      }
+    }
+
+    // Best allowed move so far, `other' is a palette for a move and a ColorSet for a swap
+    long bestDelta = LONG_MAX;
+    std::size_t bestSet = 0;
+    std::size_t bestOther = 0;
+    bool bestIsSwap = false;
+    std::size_t ties = 0;
+    auto offer = [&](long delta, bool tabu, std::size_t s, std::size_t other, bool isSwap) {
+      bool aspires = static_cast<long>(local.overflow) + delta < static_cast<long>(bestOverflow);
+      if ((tabu && !aspires) || delta > bestDelta) {
+        return;
+      }
+      if (delta < bestDelta) {
+        ties = 0;
+      }
+      // Reservoir sample among equally good moves, so plateaus don't trap us in one corner
+      ties++;
+      if (delta < bestDelta || rng() % ties == 0) {
+        bestDelta = delta;
+        bestSet = s;
+        bestOther = other;
+        bestIsSwap = isSwap;
+      }
+    };
+    for (std::size_t s : members) {
+      for (std::size_t p = 0; p < local.paletteCount; p++) {
+        if (p != palette) {
+          offer(local.moveDelta(s, p), tabuUntil.at(s) > iteration, s, p, false);
+        }
+      }
+    }
+    std::size_t swapper = members.at(rng() % members.size());
+    for (std::size_t t = 0; t < local.sets.size(); t++) {
+      if (local.assignment.at(t) != palette) {
+        offer(local.swapDelta(swapper, t), tabuUntil.at(swapper) > iteration || tabuUntil.at(t) > iteration, swapper,
+              t, true);
+      }
+    }
+
+    if (bestDelta == LONG_MAX) {
+      if (local.paletteCount == 1) {
+        // Everything has to go into the one palette, and it overflows
+        return AssignResult::NO_SOLUTION_POSSIBLE;
+      }
+      // Everything is tabu, just kick a random ColorSet out so we keep moving
+      bestSet = members.at(rng() % members.size());
+      bestOther = (palette + 1 + rng() % (local.paletteCount - 1)) % local.paletteCount;
+      bestIsSwap = false;
+    }
+    std::size_t tenure = LOCAL_SEARCH_MIN_TENURE + rng() % (local.paletteCount + 1);
+    if (bestIsSwap) {
+      std::size_t otherPalette = local.assignment.at(bestOther);
+      local.unplace(bestSet);
+      local.unplace(bestOther);
+      local.place(bestSet, otherPalette);
+      local.place(bestOther, palette);
+      tabuUntil.at(bestOther) = iteration + tenure;
+    }
+    else {
+      local.unplace(bestSet);
+      local.place(bestSet, bestOther);
+    }
+    tabuUntil.at(bestSet) = iteration + tenure;
+    bestOverflow = std::min(bestOverflow, local.overflow);
+  }
+
+  for (std::size_t p = 0; p < local.paletteCount; p++) {
+    ColorSetType palette = state.hardwarePalettes[p];
+    for (std::size_t s = 0; s < local.sets.size(); s++) {
+      if (local.assignment.at(s) == p) {
+        palette |= local.sets.at(s);
+      }
+    }
+    solution.push_back(palette);
+  }
+  return AssignResult::SUCCESS;
+}
+
+// Only the full width searches are called from outside this file, runAssignment instantiates the narrower ones
+template AssignState canonicalAssignState(const AssignState &state);
+template AssignResult assignDepthFirst(const PorytilesContext &ctx, AssignSearch &search, AssignState &state,
+                                       std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
+                                       const std::vector<ColorSet> &unassigneds,
+                                       const std::vector<ColorSet> &unassignedPrimers);
+template AssignResult assignBreadthFirst(const PorytilesContext &ctx, AssignSearch &search, AssignState &initialState,
+                                         std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
+                                         const std::vector<ColorSet> &unassigneds,
+                                         const std::vector<ColorSet> &unassignedPrimers);
+template AssignResult assignBeamSearch(const PorytilesContext &ctx, AssignSearch &search, AssignState &initialState,
+                                       std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
+                                       const std::vector<ColorSet> &unassigneds,
+                                       const std::vector<ColorSet> &unassignedPrimers);
+template AssignResult assignLocalSearch(const PorytilesContext &ctx, AssignSearch &search, AssignState &state,
+                                        std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
+                                        const std::vector<ColorSet> &unassigneds,
+                                        const std::vector<ColorSet> &unassignedPrimers);
+template AssignResult assignDepthFirstParallel(const PorytilesContext &ctx, AssignSearch &search, std::size_t jobs,
+                                               AssignState &state, std::vector<ColorSet> &solution,
+                                               const std::vector<ColorSet> &primaryPalettes,
+                                               const std::vector<ColorSet> &unassigneds,
+                                               const std::vector<ColorSet> &unassignedPrimers);
+template AssignResult assignDepthFirstRestarts(const PorytilesContext &ctx, AssignSearch &search, AssignState &state,
+                                               std::vector<ColorSet> &solution,
+                                               const std::vector<ColorSet> &primaryPalettes,
+                                               const std::vector<ColorSet> &unassigneds,
+                                               const std::vector<ColorSet> &unassignedPrimers);
+
+AssignResult assignDepthFirst(PorytilesContext &ctx, CompilerMode compilerMode, AssignState &state,
+                              std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
+                              const std::vector<ColorSet> &unassigneds, const std::vector<ColorSet> &unassignedPrimers)
+{
+  AssignSearch search{assignParamsFromConfig(ctx.compilerConfig, compilerMode)};
+  AssignResult result = assignDepthFirst(ctx, search, state, solution, primaryPalettes, unassigneds, unassignedPrimers);
+  ctx.compilerContext.exploredNodeCounter = search.exploredNodeCounter;
+  return result;
+}
+
+AssignResult assignBreadthFirst(PorytilesContext &ctx, CompilerMode compilerMode, AssignState &initialState,
+                                std::vector<ColorSet> &solution, const std::vector<ColorSet> &primaryPalettes,
+                                const std::vector<ColorSet> &unassigneds,
+                                const std::vector<ColorSet> &unassignedPrimers)
+{
+  AssignSearch search{assignParamsFromConfig(ctx.compilerConfig, compilerMode)};
+  AssignResult result =
+      assignBreadthFirst(ctx, search, initialState, solution, primaryPalettes, unassigneds, unassignedPrimers);
+  ctx.compilerContext.exploredNodeCounter = search.exploredNodeCounter;
+  return result;
+}
+
+/*
+ * Everything the assignment algorithms need that does not depend on the search parameters. We build this once per
+ * runPaletteAssignmentMatrix call, then every attempt reads from it.
+ */
+struct AssignProblem {
+  std::size_t hardwarePaletteCount;
   std::vector<ColorSet> unassignedNormPalettes;
   std::vector<ColorSet> unassignedPrimerPalettes;
-  std::copy(std::begin(colorSets), std::end(colorSets), std::back_inserter(unassignedNormPalettes));
-  std::copy(std::begin(primerColorSets), std::end(primerColorSets), std::back_inserter(unassignedPrimerPalettes));
-  std::stable_sort(std::begin(unassignedNormPalettes), std::end(unassignedNormPalettes),
+  std::vector<ColorSet> primaryPaletteColorSets;
+
+  // If not empty, the search starts from these palettes instead of from empty ones
+  std::vector<ColorSet> startingPalettes;
+
+  // How many distinct colors the ColorSets index into, this decides the ColorSet width the searches run at
+  std::size_t colorCount = ColorSet{}.size();
+};
+
+static AssignProblem prepareAssignment(const PorytilesContext &ctx, CompilerMode compilerMode,
+                                       const std::vector<ColorSet> &colorSets,
+                                       const std::vector<ColorSet> &primerColorSets,
+                                       const std::unordered_map<BGR15, std::size_t> &colorToIndex)
+{
+  AssignProblem problem{};
+  problem.colorCount = colorToIndex.size();
+  if (compilerMode == CompilerMode::PRIMARY) {
+    problem.hardwarePaletteCount = ctx.fieldmapConfig.numPalettesInPrimary;
+  }
+  else if (compilerMode == CompilerMode::SECONDARY) {
+    problem.hardwarePaletteCount = ctx.fieldmapConfig.numPalettesInSecondary();
+  }
+  else {
+    internalerror_unknownCompilerMode("palette_assignment::prepareAssignment");
+  }
+  std::copy(std::begin(colorSets), std::end(colorSets), std::back_inserter(problem.unassignedNormPalettes));
+  std::copy(std::begin(primerColorSets), std::end(primerColorSets),
+            std::back_inserter(problem.unassignedPrimerPalettes));
+  std::stable_sort(std::begin(problem.unassignedNormPalettes), std::end(problem.unassignedNormPalettes),
                    [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
-  std::stable_sort(std::begin(unassignedPrimerPalettes), std::end(unassignedPrimerPalettes),
+  std::stable_sort(std::begin(problem.unassignedPrimerPalettes), std::end(problem.unassignedPrimerPalettes),
                    [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
-  std::vector<ColorSet> primaryPaletteColorSets{};
   if (compilerMode == CompilerMode::SECONDARY) {
     /*
      * Construct ColorSets for the primary palettes, assign can use these to decide if a tile is entirely covered by a
      * primary palette and hence does not need to extend the search by assigning its colors to one of the new secondary
      * palettes.
      */
-    primaryPaletteColorSets.reserve(ctx.compilerContext.pairedPrimaryTileset->palettes.size());
+    problem.primaryPaletteColorSets.reserve(ctx.compilerContext.pairedPrimaryTileset->palettes.size());
     for (std::size_t i = 0; i < ctx.compilerContext.pairedPrimaryTileset->palettes.size(); i++) {
       const auto &gbaPalette = ctx.compilerContext.pairedPrimaryTileset->palettes.at(i);
-      primaryPaletteColorSets.emplace_back();
+      problem.primaryPaletteColorSets.emplace_back();
       for (std::size_t j = 1; j < gbaPalette.size; j++) {
-        primaryPaletteColorSets.at(i).set(colorToIndex.at(gbaPalette.colors.at(j)));
+        problem.primaryPaletteColorSets.at(i).set(colorToIndex.at(gbaPalette.colors.at(j)));
+      }
+    }
+  }
+  return problem;
+}
+
+/*
+ * The same bound as remainingCannotFit, over the whole problem before we search at all. If it already needs more
+ * palettes than we have, no params in the matrix can help, so we can give up right away instead of after every entry
+ * has run out of budget.
+ */
+static std::size_t paletteLowerBound(const AssignProblem &problem)
+{
+  std::vector<const ColorSet *> candidates{};
+  for (const auto &colorSet : problem.unassignedPrimerPalettes) {
+    if (!coveredByPrimary(problem.primaryPaletteColorSets, colorSet)) {
+      candidates.push_back(&colorSet);
+    }
+  }
+  for (const auto &colorSet : problem.unassignedNormPalettes) {
+    if (!coveredByPrimary(problem.primaryPaletteColorSets, colorSet)) {
+      candidates.push_back(&colorSet);
+    }
+  }
+  std::stable_sort(std::begin(candidates), std::end(candidates),
+                   [](const auto *cs1, const auto *cs2) { return cs1->count() > cs2->count(); });
+  return incompatibleGroupSize(candidates);
+}
+
+/*
+ * What the greedy pre-pass came up with. The orders hold every ColorSet of the problem in the order the pass placed
+ * them, including the ones it found no palette for.
+ */
+struct GreedyAssignment {
+  std::vector<ColorSet> palettes;
+  std::vector<ColorSet> normOrder;
+  std::vector<ColorSet> primerOrder;
+  std::size_t unplacedCount;
+};
+
+/*
+ * A DSatur style constructive pass, cheap enough to run before any search. Think of the ColorSets as a graph with an
+ * edge between any two whose union does not fit in one palette. Each round we place the ColorSet the most palettes are
+ * already too full for, breaking ties by how many other ColorSets it clashes with and then by size. It goes into the
+ * palette the depth first search would try first: the one it shares the most colors with, then the smallest. When no
+ * palette has room, the ColorSet is set aside and the pass carries on, so the orders always cover the whole problem.
+ */
+static GreedyAssignment assignGreedy(const AssignProblem &problem)
+{
+  GreedyAssignment greedy{};
+  greedy.palettes.resize(problem.hardwarePaletteCount);
+  std::copy(std::begin(problem.startingPalettes), std::end(problem.startingPalettes), std::begin(greedy.palettes));
+  greedy.unplacedCount = 0;
+
+  auto placeAll = [&](const std::vector<ColorSet> &colorSets, std::vector<ColorSet> &order) {
+    std::vector<const ColorSet *> pending{};
+    for (const auto &colorSet : colorSets) {
+      // ColorSets a primary palette covers need no placing, list them first so the searches get them out of the way
+      if (coveredByPrimary(problem.primaryPaletteColorSets, colorSet)) {
+        order.push_back(colorSet);
+      }
+      else {
+        pending.push_back(&colorSet);
+      }
+    }
+
+    std::vector<std::size_t> clashes(pending.size());
+    for (std::size_t i = 0; i < pending.size(); i++) {
+      for (std::size_t j = i + 1; j < pending.size(); j++) {
+        if (pending[i]->countOr(*pending[j]) > PAL_SIZE - 1) {
+          clashes[i]++;
+          clashes[j]++;
+        }
+      }
+    }
+    // Bit i is set once palette i is too full for the ColorSet, palettes only grow so bits are never cleared
+    std::vector<std::uint32_t> fullPalettes(pending.size());
+    auto markFull = [&](std::size_t paletteIndex) {
+      for (std::size_t i = 0; i < pending.size(); i++) {
+        if (pending[i] != nullptr && greedy.palettes[paletteIndex].countOr(*pending[i]) > PAL_SIZE - 1) {
+          fullPalettes[i] |= std::uint32_t{1} << paletteIndex;
+        }
+      }
+    };
+    for (std::size_t i = 0; i < greedy.palettes.size(); i++) {
+      markFull(i);
+    }
+
+    for (std::size_t round = 0; round < pending.size(); round++) {
+      std::size_t next = SIZE_MAX;
+      for (std::size_t i = 0; i < pending.size(); i++) {
+        if (pending[i] == nullptr) {
+          continue;
+        }
+        if (next == SIZE_MAX) {
+          next = i;
+          continue;
+        }
+        auto key = [&](std::size_t j) {
+          return std::tuple{std::popcount(fullPalettes[j]), clashes[j], pending[j]->count()};
+        };
+        if (key(i) > key(next)) {
+          next = i;
+        }
+      }
+      const ColorSet &toPlace = *pending[next];
+      order.push_back(toPlace);
+      pending[next] = nullptr;
+
+      std::size_t best = SIZE_MAX;
+      for (std::size_t i = 0; i < greedy.palettes.size(); i++) {
+        if ((fullPalettes[next] >> i) & 1) {
+          continue;
+        }
+        if (best == SIZE_MAX) {
+          best = i;
+          continue;
+        }
+        std::size_t intersect = greedy.palettes[i].countAnd(toPlace);
+        std::size_t bestIntersect = greedy.palettes[best].countAnd(toPlace);
+        if (intersect > bestIntersect ||
+            (intersect == bestIntersect && greedy.palettes[i].count() < greedy.palettes[best].count())) {
+          best = i;
+        }
+      }
+      if (best == SIZE_MAX) {
+        greedy.unplacedCount++;
+        continue;
+      }
+      greedy.palettes[best] |= toPlace;
+      markFull(best);
+    }
+  };
+  placeAll(problem.unassignedPrimerPalettes, greedy.primerOrder);
+  placeAll(problem.unassignedNormPalettes, greedy.normOrder);
+  return greedy;
+}
+
+/*
+ * Seed the searches with the greedy order. They assign from the back of each vector, so the first ColorSet the greedy
+ * pass placed goes last. The depth first search sorts palettes by the same rule the greedy pass picks them with, so its
+ * first dive largely retraces the greedy packing and backtracking starts around where the greedy pass got stuck.
+ */
+static AssignProblem greedySeededProblem(const AssignProblem &problem, const GreedyAssignment &greedy)
+{
+  AssignProblem seeded = problem;
+  seeded.unassignedNormPalettes.assign(std::rbegin(greedy.normOrder), std::rend(greedy.normOrder));
+  seeded.unassignedPrimerPalettes.assign(std::rbegin(greedy.primerOrder), std::rend(greedy.primerOrder));
+  return seeded;
+}
+
+/*
+ * Leave out every ColorSet that is a subset of another one in the problem. Whichever palette ends up holding the bigger
+ * ColorSet holds the smaller one too, and assignTilesPrimary and assignTilesSecondary find a tile's palette with that
+ * same subset check, so the dropped ColorSets still get a palette without the search ever placing them. Of two equal
+ * ColorSets we keep the first, primers before the regular ColorSets since the searches assign primers first.
+ *
+ * Any solution to one problem solves the other, so this never turns a solvable problem unsolvable. Under smart prune or
+ * a best branches limit the search may land on a different solution, as it no longer branches at the dropped ColorSets.
+ * That is fine for a fresh search, but a replay of cached params has to search the problem it was cached for.
+ */
+static AssignProblem withoutSubsumedColorSets(const AssignProblem &problem)
+{
+  std::vector<const ColorSet *> colorSets{};
+  colorSets.reserve(problem.unassignedPrimerPalettes.size() + problem.unassignedNormPalettes.size());
+  for (const auto &colorSet : problem.unassignedPrimerPalettes) {
+    colorSets.push_back(&colorSet);
+  }
+  for (const auto &colorSet : problem.unassignedNormPalettes) {
+    colorSets.push_back(&colorSet);
+  }
+  auto subsumed = [&colorSets](std::size_t i) {
+    for (std::size_t j = 0; j < colorSets.size(); j++) {
+      if (j != i && colorSets[i]->isSubsetOf(*colorSets[j]) && (j < i || *colorSets[i] != *colorSets[j])) {
+        return true;
       }
     }
+    return false;
+  };
+
+  AssignProblem stripped = problem;
+  stripped.unassignedPrimerPalettes.clear();
+  stripped.unassignedNormPalettes.clear();
+  for (std::size_t i = 0; i < colorSets.size(); i++) {
+    if (subsumed(i)) {
+      continue;
+    }
+    if (i < problem.unassignedPrimerPalettes.size()) {
+      stripped.unassignedPrimerPalettes.push_back(*colorSets[i]);
+    }
+    else {
+      stripped.unassignedNormPalettes.push_back(*colorSets[i]);
+    }
+  }
+  return stripped;
+}
+
+/*
+ * Resize the ColorSets for the search, leaving out every ColorSet one of `primaryPalettes' already covers. Pass no
+ * palettes to keep them all.
+ */
+template <typename ColorSetType>
+static std::vector<ColorSetType> resizeUncoveredColorSets(const std::vector<ColorSet> &colorSets,
+                                                          const std::vector<ColorSet> &primaryPalettes)
+{
+  std::vector<ColorSetType> resized{};
+  resized.reserve(colorSets.size());
+  for (const auto &colorSet : colorSets) {
+    if (!coveredByPrimary(primaryPalettes, colorSet)) {
+      resized.emplace_back(colorSet);
+    }
+  }
+  return resized;
+}
+
+/*
+ * Run one attempt with the params in `search', with the searches working on ColorSetType sets. The problem and the
+ * solution stay in full width ColorSets, only the copy the search works on is resized.
+ */
+template <typename ColorSetType>
+static AssignResult runAssignmentWithWidth(const PorytilesContext &ctx, const AssignProblem &problem,
+                                           AssignSearch &search, std::vector<ColorSet> &solution, std::size_t jobs)
+{
+  auto startTime = std::chrono::steady_clock::now();
+  BasicHardwarePalettes<ColorSetType> tmpHardwarePalettes{problem.hardwarePaletteCount};
+  for (std::size_t i = 0; i < problem.startingPalettes.size(); i++) {
+    tmpHardwarePalettes.set(i, ColorSetType{problem.startingPalettes.at(i)});
   }
+  /*
+   * A ColorSet a primary palette covers can take that palette and leave the search state as it was. When the search
+   * tries every hardware palette, any branch that adds the same colors to a hardware palette instead can only succeed
+   * where that one did, so such ColorSets never need a secondary palette. We drop them up front, and the search has no
+   * primary palettes left to check at every node. With smart prune or a best branches limit below the palette count
+   * that no longer holds: the bigger state sorts its palettes differently and may reach one the covered branch never
+   * tries. So there the search keeps the primary palettes, and falls back to the hardware palettes when the primary one
+   * fails.
+   */
+  const std::vector<ColorSet> noPalettes{};
+  const bool dropCovered = branchesExhaustively(search, problem.hardwarePaletteCount);
+  const std::vector<ColorSet> &droppedBy = dropCovered ? problem.primaryPaletteColorSets : noPalettes;
+  const std::vector<ColorSetType> primaryPalettes =
+      resizeUncoveredColorSets<ColorSetType>(dropCovered ? noPalettes : problem.primaryPaletteColorSets, noPalettes);
+  const std::vector<ColorSetType> unassigneds =
+      resizeUncoveredColorSets<ColorSetType>(problem.unassignedNormPalettes, droppedBy);
+  const std::vector<ColorSetType> unassignedPrimers =
+      resizeUncoveredColorSets<ColorSetType>(problem.unassignedPrimerPalettes, droppedBy);
+  std::vector<ColorSetType> resizedSolution{};
+  resizedSolution.reserve(problem.hardwarePaletteCount);
 
-  AssignState initialState = {tmpHardwarePalettes, unassignedNormPalettes.size(), unassignedPrimerPalettes.size()};
-  ctx.compilerContext.exploredNodeCounter = 0;
+  BasicAssignState<ColorSetType> initialState = {tmpHardwarePalettes, unassigneds.size(), unassignedPrimers.size()};
   AssignResult assignResult = AssignResult::NO_SOLUTION_POSSIBLE;
-  AssignAlgorithm assignAlgorithm = compilerMode == CompilerMode::PRIMARY ? ctx.compilerConfig.primaryAssignAlgorithm
-                                                                          : ctx.compilerConfig.secondaryAssignAlgorithm;
-  std::size_t exploredNodeCutoff = compilerMode == CompilerMode::PRIMARY
-                                       ? ctx.compilerConfig.primaryExploredNodeCutoff
-                                       : ctx.compilerConfig.secondaryExploredNodeCutoff;
-  if (assignAlgorithm == AssignAlgorithm::DFS) {
-    assignResult = assignDepthFirst(ctx, compilerMode, initialState, assignedPalsSolution, primaryPaletteColorSets,
-                                    unassignedNormPalettes, unassignedPrimerPalettes);
-  }
-  else if (assignAlgorithm == AssignAlgorithm::BFS) {
-    assignResult = assignBreadthFirst(ctx, compilerMode, initialState, assignedPalsSolution, primaryPaletteColorSets,
-                                      unassignedNormPalettes, unassignedPrimerPalettes);
+  if (search.params.assignAlgorithm == AssignAlgorithm::DFS && search.params.restarts) {
+    assignResult = assignDepthFirstRestarts(ctx, search, initialState, resizedSolution, primaryPalettes, unassigneds,
+                                            unassignedPrimers);
+  }
+  else if (search.params.assignAlgorithm == AssignAlgorithm::DFS) {
+    NogoodTable nogoods{NOGOOD_TABLE_BUCKETS};
+    search.nogoods = &nogoods;
+    assignResult = assignDepthFirstParallel(ctx, search, jobs, initialState, resizedSolution, primaryPalettes,
+                                            unassigneds, unassignedPrimers);
+    search.nogoods = nullptr;
+  }
+  else if (search.params.assignAlgorithm == AssignAlgorithm::BFS) {
+    assignResult = assignBreadthFirst(ctx, search, initialState, resizedSolution, primaryPalettes, unassigneds,
+                                      unassignedPrimers);
+  }
+  else if (search.params.assignAlgorithm == AssignAlgorithm::BEAM) {
+    assignResult = assignBeamSearch(ctx, search, initialState, resizedSolution, primaryPalettes, unassigneds,
+                                    unassignedPrimers);
+  }
+  else if (search.params.assignAlgorithm == AssignAlgorithm::LOCAL) {
+    assignResult = assignLocalSearch(ctx, search, initialState, resizedSolution, primaryPalettes, unassigneds,
+                                     unassignedPrimers);
   }
   else {
-    internalerror("palette_assignment::tryAssignment unknown AssignAlgorithm");
+    internalerror("palette_assignment::runAssignment unknown AssignAlgorithm");
+  }
+
+  solution.clear();
+  solution.reserve(resizedSolution.size());
+  for (const auto &palette : resizedSolution) {
+    solution.emplace_back(palette);
+  }
+  if (assignResult == AssignResult::SUCCESS) {
+    pt_logln(ctx, stderr, "{} assigned all NormalizedPalettes successfully after {} iterations",
+             assignAlgorithmString(search.params.assignAlgorithm), search.exploredNodeCounter);
+  }
+  if (search.stats != nullptr) {
+    search.stats->exploredNodes = search.exploredNodeCounter;
+    search.stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  }
+  return assignResult;
+}
+
+/*
+ * Run one attempt with the params in `search'. This only reads from ctx, so it is safe to call from several threads at
+ * once as long as each thread brings its own AssignSearch and solution vector. DFS attempts will spread themselves
+ * across `jobs' threads. The search runs with the narrowest ColorSets that hold all of the problem's colors.
+ */
+static AssignResult runAssignment(const PorytilesContext &ctx, const AssignProblem &problem, AssignSearch &search,
+                                  std::vector<ColorSet> &solution, std::size_t jobs)
+{
+  if (problem.colorCount <= ColorSet64{}.size()) {
+    return runAssignmentWithWidth<ColorSet64>(ctx, problem, search, solution, jobs);
+  }
+  if (problem.colorCount <= ColorSet128{}.size()) {
+    return runAssignmentWithWidth<ColorSet128>(ctx, problem, search, solution, jobs);
+  }
+  return runAssignmentWithWidth<ColorSet>(ctx, problem, search, solution, jobs);
+}
+
+static std::string assignResultString(AssignResult result, bool timedOut)
+{
+  switch (result) {
+  case AssignResult::SUCCESS:
+    return "success";
+  case AssignResult::EXPLORE_CUTOFF_REACHED:
+    return "cutoff-reached";
+  case AssignResult::NO_SOLUTION_POSSIBLE:
+    return "no-solution";
+  case AssignResult::CANCELLED:
+    return timedOut ? "timed-out" : "cancelled";
+  default:
+    internalerror("palette_assignment::assignResultString unknown AssignResult");
+  }
+  // unreachable, here for compiler
+  throw std::runtime_error("palette_assignment::assignResultString reached unreachable code path");
+}
+
+/*
+ * Build the `-assign-stats' report for a finished attempt that ran with stats turned on.
+ */
+static AssignAttemptReport attemptReport(CompilerMode compilerMode, const std::string &source,
+                                         const AssignSearch &search, AssignResult result)
+{
+  AssignAttemptReport report{};
+  report.mode = compilerMode;
+  report.source = source;
+  report.matrixEntry = SIZE_MAX;
+  report.assignAlgorithm = search.params.assignAlgorithm;
+  report.exploredNodeCutoff = search.params.exploredNodeCutoff;
+  report.bestBranches = search.params.bestBranches;
+  report.smartPrune = search.params.smartPrune;
+  report.beamWidth = search.params.beamWidth;
+  report.seed = search.params.seed;
+  report.restarts = search.params.restarts;
+  report.result = assignResultString(result, search.timedOut);
+  report.won = result == AssignResult::SUCCESS;
+  report.stats = *search.stats;
+  return report;
+}
+
+static auto tryAssignment(PorytilesContext &ctx, CompilerMode compilerMode, const AssignProblem &problem,
+                          const AssignCancelToken &deadline, const std::string &source, bool printErrors)
+{
+  std::vector<ColorSet> assignedPalsSolution{};
+  AssignSearch search{assignParamsFromConfig(ctx.compilerConfig, compilerMode)};
+  search.cancelToken = &deadline;
+  AssignStats stats{};
+  if (!ctx.compilerConfig.assignStatsPath.empty()) {
+    search.stats = &stats;
+  }
+  AssignResult assignResult =
+      runAssignment(ctx, problem, search, assignedPalsSolution, ctx.compilerConfig.effectiveJobs());
+  ctx.compilerContext.exploredNodeCounter = search.exploredNodeCounter;
+  if (search.stats != nullptr) {
+    ctx.compilerContext.assignReports.push_back(attemptReport(compilerMode, source, search, assignResult));
   }
 
   if (assignResult == AssignResult::NO_SOLUTION_POSSIBLE) {
@@ -386,28 +2073,29 @@ static auto tryAssignment(PorytilesContext &ctx, CompilerMode compilerMode, cons
     if (printErrors) {
       fatalerror_noPossiblePaletteAssignment(ctx.err, ctx.compilerSrcPaths, compilerMode);
     }
-    return std::make_tuple(false, assignedPalsSolution, primaryPaletteColorSets);
+    return std::make_pair(false, assignedPalsSolution);
   }
   else if (assignResult == AssignResult::EXPLORE_CUTOFF_REACHED) {
     if (printErrors) {
-      fatalerror_assignExploreCutoffReached(ctx.err, ctx.compilerSrcPaths, compilerMode, assignAlgorithm,
-                                            exploredNodeCutoff);
+      fatalerror_assignExploreCutoffReached(ctx.err, ctx.compilerSrcPaths, compilerMode, search.params.assignAlgorithm,
+                                            search.params.exploredNodeCutoff);
     }
-    return std::make_tuple(false, assignedPalsSolution, primaryPaletteColorSets);
+    return std::make_pair(false, assignedPalsSolution);
   }
-  pt_logln(ctx, stderr, "{} assigned all NormalizedPalettes successfully after {} iterations",
-           assignAlgorithmString(assignAlgorithm), ctx.compilerContext.exploredNodeCounter);
-  return std::make_tuple(true, assignedPalsSolution, primaryPaletteColorSets);
+  else if (assignResult == AssignResult::CANCELLED) {
+    if (!search.timedOut) {
+      internalerror("palette_assignment::tryAssignment search was cancelled before its deadline");
+    }
+    if (printErrors) {
+      fatalerror_assignTimeoutReached(ctx.err, ctx.compilerSrcPaths, compilerMode, ctx.compilerConfig.assignTimeout, 1,
+                                      0, 1, paletteLowerBound(problem), problem.hardwarePaletteCount);
+    }
+    return std::make_pair(false, assignedPalsSolution);
+  }
+  return std::make_pair(true, assignedPalsSolution);
 }
 
-struct AssignParams {
-  AssignAlgorithm assignAlgorithm;
-  std::size_t exploredNodeCutoff;
-  std::size_t bestBranches;
-  bool smartPrune;
-};
-
-static const std::array<AssignParams, 48> MATRIX{
+static const std::array<AssignParams, 54> MATRIX{
     // DFS, 1 million iterations
     AssignParams{AssignAlgorithm::DFS, 1'000'000, SIZE_MAX, true},
     AssignParams{AssignAlgorithm::DFS, 1'000'000, 2, false}, AssignParams{AssignAlgorithm::DFS, 1'000'000, 3, false},
@@ -447,13 +2135,539 @@ static const std::array<AssignParams, 48> MATRIX{
     AssignParams{AssignAlgorithm::BFS, 8'000'000, SIZE_MAX, true},
     AssignParams{AssignAlgorithm::BFS, 8'000'000, 2, false}, AssignParams{AssignAlgorithm::BFS, 8'000'000, 3, false},
     AssignParams{AssignAlgorithm::BFS, 8'000'000, 4, false}, AssignParams{AssignAlgorithm::BFS, 8'000'000, 5, false},
-    AssignParams{AssignAlgorithm::BFS, 8'000'000, 6, false}};
+    AssignParams{AssignAlgorithm::BFS, 8'000'000, 6, false},
+    // DFS with Luby restarts, a burst that succeeds is cached as a plain DFS run with its seed
+    AssignParams{AssignAlgorithm::DFS, 2'000'000, SIZE_MAX, true, DEFAULT_BEAM_WIDTH, 0, true},
+    AssignParams{AssignAlgorithm::DFS, 8'000'000, SIZE_MAX, true, DEFAULT_BEAM_WIDTH, 0, true},
+    // Beam search, its memory stays bounded however long it runs so it can afford a bigger budget
+    AssignParams{AssignAlgorithm::BEAM, 2'000'000, SIZE_MAX, true, 1'000},
+    AssignParams{AssignAlgorithm::BEAM, 8'000'000, SIZE_MAX, true, 10'000},
+    // Local search as a last resort, an iteration costs a lot more than a tree node so the budgets are smaller
+    AssignParams{AssignAlgorithm::LOCAL, 100'000, SIZE_MAX, true},
+    AssignParams{AssignAlgorithm::LOCAL, 1'000'000, SIZE_MAX, true}};
+
+/*
+ * Split whatever is left of the time budget evenly across the entries still to run. Entries run `jobs' at a time, so
+ * each one gets a whole round's worth. Time an entry leaves unused rolls over to the entries after it.
+ */
+static AssignCancelToken::Clock::time_point matrixEntryDeadline(AssignCancelToken::Clock::time_point deadline,
+                                                                std::size_t index, std::size_t jobs)
+{
+  AssignCancelToken::Clock::time_point now = AssignCancelToken::Clock::now();
+  if (deadline == AssignCancelToken::Clock::time_point::max() || now >= deadline) {
+    return deadline;
+  }
+  std::size_t rounds = (MATRIX.size() - index + jobs - 1) / jobs;
+  return now + (deadline - now) / rounds;
+}
+
+/*
+ * Run the MATRIX entries as a portfolio across the configured number of jobs. Each worker claims the next untried entry.
+ * When an entry succeeds we cancel every entry after it, but entries before it keep running since one of them may still
+ * succeed. The lowest-index success always wins, so the chosen params (and hence `assign.cache') are exactly what a
+ * serial walk of the matrix would have produced, regardless of thread timing. The one exception is a deadline, which
+ * can stop an entry that would have succeeded given more time. Returns MATRIX.size() if every entry failed.
+ * `timedOutEntries' counts the entries that ran out of time, `skippedEntries' the ones that never ran at all, because an
+ * earlier entry already won or because the deadline passed before we got to them.
+ */
+static std::size_t runMatrixPortfolio(const PorytilesContext &ctx, CompilerMode compilerMode,
+                                      const AssignProblem &problem, const AssignCancelToken &deadline,
+                                      std::vector<std::vector<ColorSet>> &solutions,
+                                      std::vector<AssignParams> &finalParams, std::size_t &timedOutEntries,
+                                      std::size_t &skippedEntries, std::vector<AssignAttemptReport> &reports)
+{
+  std::size_t jobs = std::min(ctx.compilerConfig.effectiveJobs(), MATRIX.size());
+  std::array<AssignCancelToken, MATRIX.size()> cancelTokens{};
+  for (auto &token : cancelTokens) {
+    token.parent = &deadline;
+  }
+  std::atomic_size_t nextIndex{0};
+  std::atomic_size_t winningIndex{MATRIX.size()};
+  std::atomic_size_t ranEntries{0};
+  std::atomic_size_t timedOut{0};
+  std::mutex workerErrorMutex{};
+  std::exception_ptr workerError = nullptr;
+  solutions.resize(MATRIX.size());
+  finalParams.assign(std::begin(MATRIX), std::end(MATRIX));
+  bool collectStats = !ctx.compilerConfig.assignStatsPath.empty();
+  std::vector<std::optional<AssignAttemptReport>> entryReports(MATRIX.size());
+
+  auto worker = [&]() {
+    try {
+      for (std::size_t index = nextIndex++; index < MATRIX.size(); index = nextIndex++) {
+        if (index > winningIndex.load()) {
+          // An earlier entry already succeeded, so nothing we claim from here on could win
+          return;
+        }
+        if (deadline.deadlinePassed()) {
+          return;
+        }
+        AssignSearch search{MATRIX.at(index)};
+        cancelTokens.at(index).deadline = matrixEntryDeadline(deadline.effectiveDeadline(), index, jobs);
+        search.cancelToken = &cancelTokens.at(index);
+        AssignStats stats{};
+        if (collectStats) {
+          search.stats = &stats;
+        }
+        ranEntries++;
+        // The portfolio already keeps every job busy, so each entry runs single-threaded
+        AssignResult result = runAssignment(ctx, problem, search, solutions.at(index), 1);
+        // Restarting searches rewrite their params to replay the winning burst
+        finalParams.at(index) = search.params;
+        if (collectStats) {
+          entryReports.at(index) = attemptReport(compilerMode, "matrix", search, result);
+          entryReports.at(index)->matrixEntry = index;
+        }
+        if (search.timedOut) {
+          timedOut++;
+          pt_logln(ctx, stderr, "param search matrix entry {} ran out of time after {} iterations", index,
+                   search.exploredNodeCounter);
+        }
+        if (result == AssignResult::SUCCESS) {
+          std::size_t currentWinner = winningIndex.load();
+          while (index < currentWinner && !winningIndex.compare_exchange_weak(currentWinner, index)) {
+          }
+          for (std::size_t i = index + 1; i < MATRIX.size(); i++) {
+            cancelTokens.at(i).cancel();
+          }
+        }
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock{workerErrorMutex};
+      if (workerError == nullptr) {
+        workerError = std::current_exception();
+      }
+      for (auto &token : cancelTokens) {
+        token.cancel();
+      }
+    }
+  };
+
+  pt_logln(ctx, stderr, "running palette assignment param search matrix with {} job(s)", jobs);
+  std::vector<std::thread> workers{};
+  for (std::size_t i = 1; i < jobs; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : workers) {
+    thread.join();
+  }
+  if (workerError != nullptr) {
+    std::rethrow_exception(workerError);
+  }
+  timedOutEntries = timedOut.load();
+  skippedEntries = MATRIX.size() - ranEntries.load();
+  for (auto &report : entryReports) {
+    if (report.has_value()) {
+      // Several entries may succeed, but only the lowest one counts
+      report->won = report->matrixEntry == winningIndex.load();
+      reports.push_back(*report);
+    }
+  }
+  return winningIndex.load();
+}
+
+/*
+ * Besides the params, `assign.cache' keeps the palettes the last successful assignment produced. We store actual colors
+ * rather than ColorSets, since color indexes are only stable as long as the tiles don't change. If every ColorSet still
+ * fits into one of those palettes, we can reuse them as they are: no search at all, and the emitted palettes stay put.
+ */
+static std::unordered_map<std::size_t, BGR15>
+invertColorIndexMap(const std::unordered_map<BGR15, std::size_t> &colorToIndex)
+{
+  std::unordered_map<std::size_t, BGR15> indexToColor{};
+  for (const auto &[color, index] : colorToIndex) {
+    indexToColor.insert(std::pair{index, color});
+  }
+  return indexToColor;
+}
+
+static bool rebuildCachedSolution(const AssignProblem &problem, const std::vector<std::vector<BGR15>> &cachedSolution,
+                                  const std::unordered_map<BGR15, std::size_t> &colorToIndex,
+                                  std::vector<ColorSet> &solution)
+{
+  if (cachedSolution.size() != problem.hardwarePaletteCount) {
+    return false;
+  }
+  solution.clear();
+  for (const auto &palette : cachedSolution) {
+    ColorSet colorSet{};
+    for (const auto &color : palette) {
+      // Colors the tiles no longer use just drop out of the palette
+      auto index = colorToIndex.find(color);
+      if (index != colorToIndex.end()) {
+        colorSet.set(index->second);
+      }
+    }
+    if (colorSet.count() > PAL_SIZE - 1) {
+      return false;
+    }
+    solution.push_back(colorSet);
+  }
+  return true;
+}
+
+/*
+ * What is left to assign on top of the given palettes: the ColorSets that neither they nor a primary palette cover
+ * yet. Palettes only ever gain colors during the search, so everything they cover now stays covered.
+ */
+static AssignProblem uncoveredRemainder(const AssignProblem &problem, const std::vector<ColorSet> &palettes)
+{
+  auto covered = [&](const ColorSet &colorSet) {
+    return coveredByPrimary(problem.primaryPaletteColorSets, colorSet) ||
+           std::any_of(std::begin(palettes), std::end(palettes),
+                       [&colorSet](const auto &palette) { return colorSet.isSubsetOf(palette); });
+  };
+  AssignProblem remainder{problem.hardwarePaletteCount, {}, {}, problem.primaryPaletteColorSets, palettes,
+                          problem.colorCount};
+  std::copy_if(std::begin(problem.unassignedNormPalettes), std::end(problem.unassignedNormPalettes),
+               std::back_inserter(remainder.unassignedNormPalettes), std::not_fn(covered));
+  std::copy_if(std::begin(problem.unassignedPrimerPalettes), std::end(problem.unassignedPrimerPalettes),
+               std::back_inserter(remainder.unassignedPrimerPalettes), std::not_fn(covered));
+  return remainder;
+}
+
+/*
+ * The searches reorder palettes as they go, so the solution comes back in some other order than the palettes we started
+ * from. Every solution palette grew out of one starting palette though, so match each starting palette, biggest first,
+ * to the unclaimed superset that gained the fewest colors, and put it back in that slot. That keeps palette indexes, and
+ * so the emitted tiles and metatiles, from churning. If some palette finds no match we leave the order as it is.
+ */
+static void restorePaletteOrder(const std::vector<ColorSet> &startingPalettes, std::vector<ColorSet> &solution)
+{
+  std::vector<std::size_t> order(startingPalettes.size());
+  std::iota(std::begin(order), std::end(order), std::size_t{0});
+  std::stable_sort(std::begin(order), std::end(order), [&startingPalettes](std::size_t i1, std::size_t i2) {
+    return startingPalettes.at(i1).count() > startingPalettes.at(i2).count();
+  });
+  std::vector<ColorSet> restored(solution.size());
+  std::vector<bool> claimed(solution.size(), false);
+  for (std::size_t startIndex : order) {
+    const ColorSet &start = startingPalettes.at(startIndex);
+    std::size_t best = solution.size();
+    for (std::size_t i = 0; i < solution.size(); i++) {
+      if (!claimed.at(i) && start.isSubsetOf(solution.at(i)) &&
+          (best == solution.size() || solution.at(i).count() < solution.at(best).count())) {
+        best = i;
+      }
+    }
+    if (best == solution.size()) {
+      return;
+    }
+    claimed.at(best) = true;
+    restored.at(startIndex) = solution.at(best);
+  }
+  solution = restored;
+}
+
+// The remainder is usually a handful of new ColorSets, a plain DFS over every branch handles that easily
+static const AssignParams INCREMENTAL_PARAMS{AssignAlgorithm::DFS, 1'000'000, SIZE_MAX, false};
+
+static void writeAssignSolutionToConfig(CompilerConfig &config, CompilerMode compilerMode,
+                                        const std::vector<ColorSet> &solution,
+                                        const std::unordered_map<std::size_t, BGR15> &indexToColor)
+{
+  std::vector<std::vector<BGR15>> solutionColors{};
+  for (const auto &palette : solution) {
+    std::vector<BGR15> &colors = solutionColors.emplace_back();
+    for (std::size_t i = 0; i < palette.size(); i++) {
+      if (palette.test(i)) {
+        colors.push_back(indexToColor.at(i));
+      }
+    }
+  }
+  if (compilerMode == CompilerMode::PRIMARY) {
+    config.primaryCachedSolution = solutionColors;
+  }
+  else if (compilerMode == CompilerMode::SECONDARY) {
+    config.secondaryCachedSolution = solutionColors;
+  }
+  else {
+    internalerror_unknownCompilerMode("palette_assignment::writeAssignSolutionToConfig");
+  }
+}
+
+/*
+ * ColorSets that share no colors, not even through other ColorSets, can never constrain each other. They are separate
+ * problems that just happen to share the hardware palettes. One search tree interleaves them though, so backtracking
+ * inside one group keeps redoing the work of every unrelated group that was assigned before it.
+ *
+ * So when the param search matrix comes up empty, we take one more shot with the problem split up: group the ColorSets
+ * into connected components by shared colors, find the fewest palettes each component fits into, then pack all the
+ * component palettes into the hardware palettes. This is only a fallback. Solving the pieces on their own lays out the
+ * palettes differently, and tilesets that compile today should keep compiling to the same output.
+ */
+struct AssignComponent {
+  std::vector<ColorSet> normPalettes;
+  std::vector<ColorSet> primerPalettes;
+  ColorSet colors;
+};
+
+static std::size_t findColorRoot(std::array<std::size_t, ColorSet{}.size()> &parents, std::size_t color)
+{
+  while (parents.at(color) != color) {
+    parents.at(color) = parents.at(parents.at(color));
+    color = parents.at(color);
+  }
+  return color;
+}
+
+static std::vector<AssignComponent> splitIntoComponents(const AssignProblem &problem)
+{
+  auto needsSlot = [&problem](const ColorSet &colorSet) {
+    // Empty sets and sets a primary palette already covers fit anywhere, they don't belong to any component
+    return colorSet.any() && std::none_of(std::begin(problem.primaryPaletteColorSets),
+                                          std::end(problem.primaryPaletteColorSets),
+                                          [&colorSet](const auto &palette) { return colorSet.isSubsetOf(palette); });
+  };
+  auto firstColor = [](const ColorSet &colorSet) {
+    std::size_t color = 0;
+    while (!colorSet.test(color)) {
+      color++;
+    }
+    return color;
+  };
+
+  std::array<std::size_t, ColorSet{}.size()> parents{};
+  for (std::size_t color = 0; color < parents.size(); color++) {
+    parents.at(color) = color;
+  }
+  auto unionColors = [&](const ColorSet &colorSet) {
+    std::size_t root = findColorRoot(parents, firstColor(colorSet));
+    for (std::size_t color = 0; color < colorSet.size(); color++) {
+      if (colorSet.test(color)) {
+        parents.at(findColorRoot(parents, color)) = root;
+        root = findColorRoot(parents, root);
+      }
+    }
+  };
+  for (const auto &colorSet : problem.unassignedNormPalettes) {
+    if (needsSlot(colorSet)) {
+      unionColors(colorSet);
+    }
+  }
+  for (const auto &colorSet : problem.unassignedPrimerPalettes) {
+    if (needsSlot(colorSet)) {
+      unionColors(colorSet);
+    }
+  }
+
+  // Number components in order of first appearance, and keep each component's sets in the problem's order
+  std::vector<AssignComponent> components{};
+  std::unordered_map<std::size_t, std::size_t> componentOfRoot{};
+  auto componentOf = [&](const ColorSet &colorSet) -> AssignComponent & {
+    std::size_t root = findColorRoot(parents, firstColor(colorSet));
+    auto [it, inserted] = componentOfRoot.insert({root, components.size()});
+    if (inserted) {
+      components.emplace_back();
+    }
+    return components.at(it->second);
+  };
+  for (const auto &colorSet : problem.unassignedNormPalettes) {
+    if (needsSlot(colorSet)) {
+      AssignComponent &component = componentOf(colorSet);
+      component.normPalettes.push_back(colorSet);
+      component.colors |= colorSet;
+    }
+  }
+  for (const auto &colorSet : problem.unassignedPrimerPalettes) {
+    if (needsSlot(colorSet)) {
+      AssignComponent &component = componentOf(colorSet);
+      component.primerPalettes.push_back(colorSet);
+      component.colors |= colorSet;
+    }
+  }
+  return components;
+}
+
+static const AssignParams COMPONENT_PARAMS{AssignAlgorithm::DFS, 1'000'000, SIZE_MAX, true};
+
+/*
+ * Find the fewest palettes this component fits into. Components are usually small, so the searches with too few
+ * palettes tend to prove themselves impossible quickly.
+ */
+static bool solveComponent(const PorytilesContext &ctx, const AssignProblem &problem, const AssignComponent &component,
+                           const AssignCancelToken &deadline, std::vector<ColorSet> &palettes)
+{
+  std::size_t minPalettes = std::max(std::size_t{1}, (component.colors.count() + PAL_SIZE - 2) / (PAL_SIZE - 1));
+  for (std::size_t paletteCount = minPalettes; paletteCount <= problem.hardwarePaletteCount; paletteCount++) {
+    AssignProblem subproblem{paletteCount, component.normPalettes, component.primerPalettes, {}, {},
+                             problem.colorCount};
+    AssignSearch search{COMPONENT_PARAMS};
+    search.cancelToken = &deadline;
+    AssignResult result = runAssignment(ctx, subproblem, search, palettes, 1);
+    if (result == AssignResult::SUCCESS) {
+      return true;
+    }
+    if (result == AssignResult::CANCELLED) {
+      return false;
+    }
+  }
+  return false;
+}
+
+static bool assignByComponents(const PorytilesContext &ctx, const AssignProblem &problem,
+                               const AssignCancelToken &deadline, std::vector<ColorSet> &solution)
+{
+  std::vector<AssignComponent> components = splitIntoComponents(problem);
+  if (components.size() > problem.hardwarePaletteCount * (PAL_SIZE - 1)) {
+    // Every component needs at least one color, so we cannot possibly fit
+    return false;
+  }
+  pt_logln(ctx, stderr, "trying palette assignment split into {} independent component(s)", components.size());
+
+  std::vector<std::vector<ColorSet>> componentPalettes(components.size());
+  std::atomic_size_t nextIndex{0};
+  std::atomic_bool failed{false};
+  std::mutex workerErrorMutex{};
+  std::exception_ptr workerError = nullptr;
+  auto worker = [&]() {
+    try {
+      for (std::size_t index = nextIndex++; index < components.size() && !failed.load(); index = nextIndex++) {
+        if (!solveComponent(ctx, problem, components.at(index), deadline, componentPalettes.at(index))) {
+          failed.store(true);
+        }
+      }
+    }
+    catch (...) {
+      std::lock_guard<std::mutex> lock{workerErrorMutex};
+      if (workerError == nullptr) {
+        workerError = std::current_exception();
+      }
+      failed.store(true);
+    }
+  };
+  std::size_t jobs = std::min(ctx.compilerConfig.effectiveJobs(), std::max(components.size(), std::size_t{1}));
+  std::vector<std::thread> workers{};
+  for (std::size_t i = 1; i < jobs; i++) {
+    workers.emplace_back(worker);
+  }
+  worker();
+  for (auto &thread : workers) {
+    thread.join();
+  }
+  if (workerError != nullptr) {
+    std::rethrow_exception(workerError);
+  }
+  if (failed.load()) {
+    return false;
+  }
+
+  /*
+   * Now pack the component palettes into the hardware palettes, first fit decreasing. Two palettes can share a hardware
+   * palette as long as their union still fits, which is what lets several small components live in one palette.
+   */
+  std::vector<ColorSet> pieces{};
+  for (const auto &palettes : componentPalettes) {
+    std::copy_if(std::begin(palettes), std::end(palettes), std::back_inserter(pieces),
+                 [](const auto &palette) { return palette.any(); });
+  }
+  std::stable_sort(std::begin(pieces), std::end(pieces),
+                   [](const auto &cs1, const auto &cs2) { return cs1.count() > cs2.count(); });
+  solution.assign(problem.hardwarePaletteCount, ColorSet{});
+  for (const auto &piece : pieces) {
+    auto bin = std::find_if(std::begin(solution), std::end(solution),
+                            [&piece](const auto &palette) { return palette.countOr(piece) <= PAL_SIZE - 1; });
+    if (bin == std::end(solution)) {
+      solution.clear();
+      return false;
+    }
+    *bin |= piece;
+  }
+  return true;
+}
+
+// What we cache when the greedy pre-pass or the component split produces the palettes, only the algorithm gets saved
+static const AssignParams GREEDY_PARAMS{AssignAlgorithm::GREEDY, 0, SIZE_MAX, false};
+static const AssignParams COMPONENT_SPLIT_PARAMS{AssignAlgorithm::COMPONENTS, 0, SIZE_MAX, false};
+
+/*
+ * Retry whatever produced the cached palettes. Usually that is a search with the cached params, but if the greedy
+ * pre-pass or the component split won last time we rerun that instead. The whole problem search params never produced
+ * those palettes, so trying them would only fail and warn about a cache that is fine.
+ */
+static std::pair<bool, std::vector<ColorSet>> tryCachedAssignment(PorytilesContext &ctx, CompilerMode compilerMode,
+                                                                   const AssignProblem &problem,
+                                                                   const AssignCancelToken &deadline)
+{
+  AssignAlgorithm cachedAlgorithm = assignParamsFromConfig(ctx.compilerConfig, compilerMode).assignAlgorithm;
+  if (cachedAlgorithm == AssignAlgorithm::GREEDY) {
+    GreedyAssignment greedy = assignGreedy(problem);
+    return std::pair{greedy.unplacedCount == 0, greedy.palettes};
+  }
+  if (cachedAlgorithm == AssignAlgorithm::COMPONENTS) {
+    std::vector<ColorSet> componentSolution{};
+    bool success = assignByComponents(ctx, problem, deadline, componentSolution);
+    return std::pair{success, componentSolution};
+  }
+  return tryAssignment(ctx, compilerMode, problem, deadline, "cache", false);
+}
 
 std::pair<std::vector<ColorSet>, std::vector<ColorSet>>
 runPaletteAssignmentMatrix(PorytilesContext &ctx, CompilerMode compilerMode, const std::vector<ColorSet> &colorSets,
                            const std::vector<ColorSet> &primerColorSets,
                            const std::unordered_map<BGR15, std::size_t> &colorToIndex)
 {
+  AssignProblem problem = prepareAssignment(ctx, compilerMode, colorSets, primerColorSets, colorToIndex);
+  std::size_t lowerBound = paletteLowerBound(problem);
+  if (lowerBound > problem.hardwarePaletteCount) {
+    fatalerror_paletteAssignmentNeedsMorePalettes(ctx.err, ctx.compilerSrcPaths, compilerMode, lowerBound,
+                                                   problem.hardwarePaletteCount);
+  }
+
+  /*
+   * With `-assign-timeout', every attempt below shares one deadline. The first assignment of the compile starts the
+   * clock, so compile-secondary's paired primary and secondary split the timeout between them rather than each getting
+   * all of it.
+   */
+  if (ctx.compilerConfig.assignTimeout != 0 &&
+      ctx.compilerContext.assignDeadline == AssignCancelToken::Clock::time_point::max()) {
+    ctx.compilerContext.assignDeadline =
+        AssignCancelToken::Clock::now() + std::chrono::seconds{ctx.compilerConfig.assignTimeout};
+  }
+  AssignCancelToken deadline{};
+  deadline.deadline = ctx.compilerContext.assignDeadline;
+
+  // Every successful path goes through here, so `assign.cache' always gets the palettes we ended up with
+  std::unordered_map<std::size_t, BGR15> indexToColor = invertColorIndexMap(colorToIndex);
+  auto assigned = [&](const std::vector<ColorSet> &solution) {
+    writeAssignSolutionToConfig(ctx.compilerConfig, compilerMode, solution, indexToColor);
+    return std::pair{solution, problem.primaryPaletteColorSets};
+  };
+
+  /*
+   * The overrides and the cached params replay a search on the full problem, so they give the palettes they always did.
+   * The greedy pre-pass, the matrix and the component split start fresh, so they skip the subsumed ColorSets. That can
+   * more than halve the search depth on a typical tileset.
+   */
+  const AssignProblem freshProblem = withoutSubsumedColorSets(problem);
+  pt_logln(ctx, stderr, "{} of {} ColorSet(s) are subsets of another, leaving them out of fresh searches",
+           problem.unassignedNormPalettes.size() + problem.unassignedPrimerPalettes.size() -
+               freshProblem.unassignedNormPalettes.size() - freshProblem.unassignedPrimerPalettes.size(),
+           problem.unassignedNormPalettes.size() + problem.unassignedPrimerPalettes.size());
+
+  /*
+   * The greedy pre-pass runs right before the parameter search matrix, once the overrides and anything cached in
+   * `assign.cache' have had their turn, so existing projects keep the palettes their cached params give them. If it
+   * packs every ColorSet we are done, otherwise its order seeds the matrix. `-force-assign-param-matrix' asks for the
+   * full search, so it skips the pre-pass too.
+   */
+  std::optional<GreedyAssignment> greedy{};
+  auto greedyAssigned = [&]() {
+    if (!ctx.compilerConfig.greedyAssign || ctx.compilerConfig.forceParamSearchMatrix) {
+      return false;
+    }
+    greedy = assignGreedy(freshProblem);
+    if (greedy->unplacedCount == 0) {
+      pt_logln(ctx, stderr, "greedy pre-pass assigned all NormalizedPalettes, skipping the search");
+      return true;
+    }
+    pt_logln(ctx, stderr, "greedy pre-pass found no palette for {} ColorSet(s), seeding the search with its order",
+             greedy->unplacedCount);
+    return false;
+  };
+
   /*
    * First, we detect if we are in a command line override case. There are three of these.
    */
@@ -480,31 +2694,63 @@ runPaletteAssignmentMatrix(PorytilesContext &ctx, CompilerMode compilerMode, con
 
   // If user supplied any command line overrides, we don't want to run the full matrix. Instead, die upon failure.
   if (primaryOverride || secondaryOverride || pairedPrimaryOverride) {
-    auto [success, assignedPalsSolution, primaryPaletteColorSets] =
-        tryAssignment(ctx, compilerMode, colorSets, primerColorSets, colorToIndex, true);
+    auto [success, assignedPalsSolution] = tryAssignment(ctx, compilerMode, problem, deadline, "override", true);
     if (success) {
-      return std::pair{assignedPalsSolution, primaryPaletteColorSets};
+      return assigned(assignedPalsSolution);
     }
   }
 
   if ((compilerMode == CompilerMode::PRIMARY && ctx.compilerConfig.readPrimaryAssignCache) ||
       (compilerMode == CompilerMode::SECONDARY && ctx.compilerConfig.readSecondaryAssignCache)) {
     if (!ctx.compilerConfig.forceParamSearchMatrix) {
+      const auto &cachedSolution = compilerMode == CompilerMode::PRIMARY ? ctx.compilerConfig.primaryCachedSolution
+                                                                         : ctx.compilerConfig.secondaryCachedSolution;
+      std::vector<ColorSet> cachedPalsSolution{};
+      if (!cachedSolution.empty() && rebuildCachedSolution(problem, cachedSolution, colorToIndex, cachedPalsSolution)) {
+        AssignProblem remainder = uncoveredRemainder(problem, cachedPalsSolution);
+        if (remainder.unassignedNormPalettes.empty() && remainder.unassignedPrimerPalettes.empty()) {
+          pt_logln(ctx, stderr, "cached palettes still cover every tile, reusing cached palette assignment");
+          return assigned(cachedPalsSolution);
+        }
+
+        /*
+         * Some tiles changed. Rather than solve everything from scratch, which could shuffle every palette, try to fit
+         * just the new ColorSets on top of the cached palettes.
+         */
+        pt_logln(ctx, stderr, "{} ColorSet(s) not covered by the cached palettes, assigning them incrementally",
+                 remainder.unassignedNormPalettes.size() + remainder.unassignedPrimerPalettes.size());
+        std::vector<ColorSet> incrementalSolution{};
+        AssignSearch search{INCREMENTAL_PARAMS};
+        search.cancelToken = &deadline;
+        AssignStats stats{};
+        if (!ctx.compilerConfig.assignStatsPath.empty()) {
+          search.stats = &stats;
+        }
+        AssignResult result =
+            runAssignment(ctx, remainder, search, incrementalSolution, ctx.compilerConfig.effectiveJobs());
+        if (search.stats != nullptr) {
+          ctx.compilerContext.assignReports.push_back(attemptReport(compilerMode, "incremental", search, result));
+        }
+        if (result == AssignResult::SUCCESS) {
+          restorePaletteOrder(cachedPalsSolution, incrementalSolution);
+          return assigned(incrementalSolution);
+        }
+        pt_logln(ctx, stderr, "incremental assignment failed, running the full search");
+      }
+
       /*
        * If we read a cached assignment setting that corresponds to our current compilation mode, try it first to
        * potentially save a ton of time.
        */
-      auto assignmentResult = tryAssignment(ctx, compilerMode, colorSets, primerColorSets, colorToIndex, false);
-      bool success = std::get<0>(assignmentResult);
+      auto [success, assignedPalsSolution] = tryCachedAssignment(ctx, compilerMode, problem, deadline);
       if (success) {
-        auto assignedPalsSolution = std::get<1>(assignmentResult);
-        auto primaryPaletteColorSets = std::get<2>(assignmentResult);
-        return std::pair{assignedPalsSolution, primaryPaletteColorSets};
+        return assigned(assignedPalsSolution);
       }
-      if (compilerMode == CompilerMode::PRIMARY) {
+      // Running out of time says nothing about the cached params, the matrix below reports the timeout
+      if (!deadline.deadlinePassed() && compilerMode == CompilerMode::PRIMARY) {
         warn_invalidAssignCache(ctx.err, ctx.compilerConfig, ctx.compilerSrcPaths.primaryAssignCache());
       }
-      else if (compilerMode == CompilerMode::SECONDARY) {
+      else if (!deadline.deadlinePassed() && compilerMode == CompilerMode::SECONDARY) {
         warn_invalidAssignCache(ctx.err, ctx.compilerConfig, ctx.compilerSrcPaths.secondaryAssignCache());
       }
     }
@@ -518,29 +2764,1055 @@ runPaletteAssignmentMatrix(PorytilesContext &ctx, CompilerMode compilerMode, con
     }
   }
 
-  for (std::size_t index = 0; index < MATRIX.size(); index++) {
-    if (compilerMode == CompilerMode::PRIMARY) {
-      ctx.compilerConfig.primaryAssignAlgorithm = MATRIX.at(index).assignAlgorithm;
-      ctx.compilerConfig.primaryExploredNodeCutoff = MATRIX.at(index).exploredNodeCutoff;
-      ctx.compilerConfig.primaryBestBranches = MATRIX.at(index).bestBranches;
-      ctx.compilerConfig.primarySmartPrune = MATRIX.at(index).smartPrune;
-    }
-    else if (compilerMode == CompilerMode::SECONDARY) {
-      ctx.compilerConfig.secondaryAssignAlgorithm = MATRIX.at(index).assignAlgorithm;
-      ctx.compilerConfig.secondaryExploredNodeCutoff = MATRIX.at(index).exploredNodeCutoff;
-      ctx.compilerConfig.secondaryBestBranches = MATRIX.at(index).bestBranches;
-      ctx.compilerConfig.secondarySmartPrune = MATRIX.at(index).smartPrune;
-    }
-    auto [success, assignedPalsSolution, primaryPaletteColorSets] =
-        tryAssignment(ctx, compilerMode, colorSets, primerColorSets, colorToIndex, false);
-    if (success) {
-      return std::pair{assignedPalsSolution, primaryPaletteColorSets};
-    }
+  if (greedyAssigned()) {
+    // No search ran, so cache the pre-pass itself rather than leave whatever params the config had
+    writeAssignParamsToConfig(ctx.compilerConfig, compilerMode, GREEDY_PARAMS);
+    return assigned(greedy->palettes);
+  }
+
+  std::vector<std::vector<ColorSet>> solutions{};
+  std::vector<AssignParams> finalParams{};
+  std::size_t timedOutEntries = 0;
+  std::size_t skippedEntries = 0;
+  AssignProblem matrixProblem = greedy.has_value() ? greedySeededProblem(freshProblem, *greedy) : freshProblem;
+  std::size_t winningIndex = runMatrixPortfolio(ctx, compilerMode, matrixProblem, deadline, solutions, finalParams,
+                                                timedOutEntries, skippedEntries, ctx.compilerContext.assignReports);
+  if (winningIndex < MATRIX.size()) {
+    // Write the winning params back to the config, this is what emitAssignCache will save
+    writeAssignParamsToConfig(ctx.compilerConfig, compilerMode, finalParams.at(winningIndex));
+    pt_logln(ctx, stderr, "param search matrix entry {} produced the assignment", winningIndex);
+    return assigned(solutions.at(winningIndex));
   }
+  std::vector<ColorSet> componentSolution{};
+  if (assignByComponents(ctx, freshProblem, deadline, componentSolution)) {
+    pt_logln(ctx, stderr, "component split produced the assignment");
+    writeAssignParamsToConfig(ctx.compilerConfig, compilerMode, COMPONENT_SPLIT_PARAMS);
+    return assigned(componentSolution);
+  }
+
+  /*
+   * If any entry ran out of time or never got to run, the deadline is the more useful thing to report: given more time
+   * those entries might still have succeeded, so the params are not necessarily the problem. No entry won, so every
+   * skipped entry was skipped because of the deadline.
+   */
+  if (timedOutEntries > 0 || skippedEntries > 0) {
+    fatalerror_assignTimeoutReached(ctx.err, ctx.compilerSrcPaths, compilerMode, ctx.compilerConfig.assignTimeout,
+                                    timedOutEntries, skippedEntries, MATRIX.size(), lowerBound,
+                                    problem.hardwarePaletteCount);
+  }
+
   // If we got here, the matrix failed, print a sad message
   fatalerror_paletteAssignParamSearchMatrixFailed(ctx.err, ctx.compilerSrcPaths, compilerMode);
   // unreachable, here for compiler
   throw std::runtime_error("assign param matrix failed :-(");
 }
 
-} // namespace porytiles
\ No newline at end of file
+} // namespace porytiles
+
+// --------------------
+// |    TEST CASES    |
+// --------------------
+
+// The ColorSet holding every color from `first' through `last', both included
+static ColorSet colorRange(std::size_t first, std::size_t last)
+{
+  ColorSet colorSet{};
+  for (std::size_t i = first; i <= last; i++) {
+    colorSet.set(i);
+  }
+  return colorSet;
+}
+
+static ColorSet colorSetOf(std::initializer_list<std::size_t> indexes)
+{
+  ColorSet colorSet{};
+  for (std::size_t index : indexes) {
+    colorSet.set(index);
+  }
+  return colorSet;
+}
+
+/*
+ * Two palettes, 30 colors, so both must end up exactly full. Assigned biggest first, greedy puts the 8 and the 7 color
+ * sets into separate palettes, fills them to 14 and 13, and is left with 3 colors that fit nowhere.
+ */
+static std::vector<ColorSet> twoFullPalettesColorSets()
+{
+  return {colorRange(27, 29), colorRange(21, 26), colorRange(15, 20), colorRange(8, 14), colorRange(0, 7)};
+}
+
+TEST_CASE("canonicalAssignState should map permutations of the same palettes to the same state")
+{
+  ColorSet red{};
+  red.set(0);
+  ColorSet greenBlue{};
+  greenBlue.set(1);
+  greenBlue.set(2);
+  ColorSet highBits{};
+  highBits.set(200);
+  ColorSet empty{};
+
+  porytiles::AssignState state1 = {std::vector<ColorSet>{red, greenBlue, highBits, empty}, 3, 0};
+  porytiles::AssignState state2 = {std::vector<ColorSet>{highBits, empty, red, greenBlue}, 3, 0};
+  porytiles::AssignState state3 = {std::vector<ColorSet>{empty, greenBlue, highBits, red}, 3, 0};
+  porytiles::AssignState differentColors = {std::vector<ColorSet>{empty, greenBlue, highBits, greenBlue}, 3, 0};
+  porytiles::AssignState differentCount = {std::vector<ColorSet>{red, greenBlue, highBits, empty}, 2, 0};
+
+  CHECK_FALSE(state1 == state2);
+  CHECK(porytiles::canonicalAssignState(state1) == porytiles::canonicalAssignState(state2));
+  CHECK(porytiles::canonicalAssignState(state1) == porytiles::canonicalAssignState(state3));
+  CHECK_FALSE(porytiles::canonicalAssignState(state1) == porytiles::canonicalAssignState(differentColors));
+  CHECK_FALSE(porytiles::canonicalAssignState(state1) == porytiles::canonicalAssignState(differentCount));
+
+  // Canonical order sorts the palettes by their bits, most significant word first
+  porytiles::AssignState canonical = porytiles::canonicalAssignState(state2);
+  CHECK(canonical.hardwarePalettes.at(0) == empty);
+  CHECK(canonical.hardwarePalettes.at(1) == red);
+  CHECK(canonical.hardwarePalettes.at(2) == greenBlue);
+  CHECK(canonical.hardwarePalettes.at(3) == highBits);
+}
+
+TEST_CASE("HardwarePalettes should keep its fingerprint in sync as palettes change")
+{
+  ColorSet red{};
+  red.set(0);
+  ColorSet blue{};
+  blue.set(2);
+  ColorSet redBlue = red | blue;
+
+  SUBCASE("it should match a fresh build of the same palettes after a merge")
+  {
+    porytiles::HardwarePalettes palettes{std::vector<ColorSet>{red, ColorSet{}, ColorSet{}}};
+    palettes.merge(0, blue);
+    porytiles::HardwarePalettes expected{std::vector<ColorSet>{redBlue, ColorSet{}, ColorSet{}}};
+    CHECK(palettes.at(0) == redBlue);
+    CHECK(palettes.fingerprint == expected.fingerprint);
+    CHECK(palettes == expected);
+  }
+
+  SUBCASE("it should return to the original fingerprint when a palette is restored")
+  {
+    porytiles::HardwarePalettes palettes{std::vector<ColorSet>{red, blue}};
+    std::uint64_t original = palettes.fingerprint;
+    palettes.merge(1, red);
+    CHECK(palettes.fingerprint != original);
+    palettes.set(1, blue);
+    CHECK(palettes.fingerprint == original);
+  }
+
+  SUBCASE("it should not depend on palette order")
+  {
+    porytiles::HardwarePalettes palettes{std::vector<ColorSet>{red, blue, redBlue}};
+    std::uint64_t original = palettes.fingerprint;
+    palettes.swap(0, 2);
+    CHECK(palettes.fingerprint == original);
+    CHECK(palettes.at(0) == redBlue);
+  }
+
+  SUBCASE("identical palettes should not cancel each other out")
+  {
+    porytiles::HardwarePalettes twoReds{std::vector<ColorSet>{red, red}};
+    porytiles::HardwarePalettes twoBlues{std::vector<ColorSet>{blue, blue}};
+    porytiles::HardwarePalettes twoEmpty{std::vector<ColorSet>{ColorSet{}, ColorSet{}}};
+    CHECK(twoReds.fingerprint != twoBlues.fingerprint);
+    CHECK(twoReds.fingerprint != twoEmpty.fingerprint);
+  }
+}
+
+TEST_CASE("assignment searches should only take the covering branch for ColorSets that are already covered")
+{
+  porytiles::PorytilesContext ctx{};
+  /*
+   * Y and X almost fill two palettes and `sub' is a subset of X. There is one slot too few for the three single colors
+   * at the end, but no two ColorSets clash badly enough for the lower bound to notice before the last one.
+   */
+  ColorSet x{};
+  ColorSet y{};
+  for (std::size_t i = 0; i < 14; i++) {
+    x.set(i);
+    y.set(14 + i);
+  }
+  ColorSet sub{};
+  sub.set(0);
+  std::array<ColorSet, 3> singles{};
+  for (std::size_t i = 0; i < singles.size(); i++) {
+    singles.at(i).set(28 + i);
+  }
+
+  // The searches assign from the back, so this order assigns Y, then X, then sub, then the single colors
+  std::vector<ColorSet> withSubset{singles.at(0), singles.at(1), singles.at(2), sub, x, y};
+  std::vector<ColorSet> withoutSubset{singles.at(0), singles.at(1), singles.at(2), x, y};
+  porytiles::AssignParams params{porytiles::AssignAlgorithm::DFS, SIZE_MAX, SIZE_MAX, false};
+
+  auto exploredNodes = [&](porytiles::AssignAlgorithm algorithm, const std::vector<ColorSet> &unassigneds) {
+    porytiles::AssignParams algorithmParams = params;
+    algorithmParams.assignAlgorithm = algorithm;
+    porytiles::AssignSearch search{algorithmParams};
+    porytiles::AssignState state = {porytiles::HardwarePalettes{2}, unassigneds.size(), 0};
+    std::vector<ColorSet> solution{};
+    porytiles::AssignResult result =
+        algorithm == porytiles::AssignAlgorithm::DFS
+            ? porytiles::assignDepthFirst(ctx, search, state, solution, {}, unassigneds, {})
+            : porytiles::assignBreadthFirst(ctx, search, state, solution, {}, unassigneds, {});
+    CHECK(result == porytiles::AssignResult::NO_SOLUTION_POSSIBLE);
+    return search.exploredNodeCounter;
+  };
+
+  SUBCASE("depth first search should visit the subset once per path")
+  {
+    // Without the shortcut, both paths would also try putting `sub' into Y's palette and fail all over again from there
+    CHECK(exploredNodes(porytiles::AssignAlgorithm::DFS, withoutSubset) == 13);
+    CHECK(exploredNodes(porytiles::AssignAlgorithm::DFS, withSubset) == 15);
+  }
+
+  SUBCASE("breadth first search should visit the subset once")
+  {
+    // The visited set already folds the two mirrored paths into one
+    CHECK(exploredNodes(porytiles::AssignAlgorithm::BFS, withoutSubset) == 7);
+    CHECK(exploredNodes(porytiles::AssignAlgorithm::BFS, withSubset) == 8);
+  }
+}
+
+TEST_CASE("the covering branch shortcut should leave searches with restricted branching unchanged")
+{
+  porytiles::PorytilesContext ctx{};
+  /*
+   * Random problems with lots of subsets: each ColorSet takes a few colors from a small pool, so later ones often fit
+   * inside a palette that already holds an earlier one. Four palettes give restricted branching room to skip some.
+   */
+  std::mt19937 rng{6};
+  std::uniform_int_distribution<std::size_t> colorDist{0, 39};
+  std::uniform_int_distribution<std::size_t> sizeDist{1, 6};
+  std::vector<std::vector<ColorSet>> problems{};
+  for (std::size_t problem = 0; problem < 40; problem++) {
+    std::vector<ColorSet> unassigneds(16);
+    for (auto &colorSet : unassigneds) {
+      for (std::size_t size = sizeDist(rng); size > 0; size--) {
+        colorSet.set(colorDist(rng));
+      }
+    }
+    problems.push_back(unassigneds);
+  }
+
+  auto run = [&](const porytiles::AssignParams &params, const std::vector<ColorSet> &unassigneds, bool coveringMoves) {
+    porytiles::AssignSearch search{params};
+    search.coveringMoves = coveringMoves;
+    porytiles::AssignState state = {porytiles::HardwarePalettes{4}, unassigneds.size(), 0};
+    std::vector<ColorSet> solution{};
+    porytiles::AssignResult result{};
+    if (params.assignAlgorithm == porytiles::AssignAlgorithm::DFS) {
+      result = porytiles::assignDepthFirst(ctx, search, state, solution, {}, unassigneds, {});
+    }
+    else if (params.assignAlgorithm == porytiles::AssignAlgorithm::BFS) {
+      result = porytiles::assignBreadthFirst(ctx, search, state, solution, {}, unassigneds, {});
+    }
+    else {
+      result = porytiles::assignBeamSearch(ctx, search, state, solution, {}, unassigneds, {});
+    }
+    return std::tuple{result, solution, search.exploredNodeCounter};
+  };
+
+  for (const auto &params :
+       {porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, 100'000, SIZE_MAX, true},
+        porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, 100'000, 2, false},
+        porytiles::AssignParams{porytiles::AssignAlgorithm::BFS, 100'000, SIZE_MAX, true},
+        porytiles::AssignParams{porytiles::AssignAlgorithm::BFS, 100'000, 2, false},
+        porytiles::AssignParams{porytiles::AssignAlgorithm::BEAM, 100'000, 2, false, 16}}) {
+    for (const auto &unassigneds : problems) {
+      CHECK(run(params, unassigneds, true) == run(params, unassigneds, false));
+    }
+  }
+}
+
+TEST_CASE("assignByComponents should solve independent groups of ColorSets separately and pack them together")
+{
+  porytiles::PorytilesContext ctx{};
+  ctx.compilerConfig.jobs = 2;
+
+  // Water is linked together through the middle set, foliage and the rooftop never share colors with anything
+  ColorSet water1 = colorRange(0, 5);
+  ColorSet water2 = colorRange(10, 15);
+  ColorSet waterLink = colorRange(5, 10);
+  ColorSet foliage = colorRange(20, 29);
+  ColorSet rooftop = colorRange(40, 42);
+  porytiles::AssignProblem problem{3, {rooftop, water1, water2, waterLink, foliage}, {}, {}};
+  porytiles::AssignCancelToken noDeadline{};
+
+  SUBCASE("it should group ColorSets that share colors, even indirectly")
+  {
+    std::vector<porytiles::AssignComponent> components = porytiles::splitIntoComponents(problem);
+    REQUIRE(components.size() == 3);
+    CHECK(components.at(0).normPalettes == std::vector<ColorSet>{rooftop});
+    CHECK(components.at(1).normPalettes == std::vector<ColorSet>{water1, water2, waterLink});
+    CHECK(components.at(1).colors == colorRange(0, 15));
+    CHECK(components.at(2).normPalettes == std::vector<ColorSet>{foliage});
+  }
+
+  SUBCASE("it should leave out ColorSets that a primary palette already covers")
+  {
+    porytiles::AssignProblem secondaryProblem = problem;
+    secondaryProblem.primaryPaletteColorSets = {colorRange(40, 50)};
+    std::vector<porytiles::AssignComponent> components = porytiles::splitIntoComponents(secondaryProblem);
+    REQUIRE(components.size() == 2);
+    CHECK(components.at(0).normPalettes == std::vector<ColorSet>{water1, water2, waterLink});
+  }
+
+  SUBCASE("it should produce a solution where every ColorSet fits into some palette")
+  {
+    std::vector<ColorSet> solution{};
+    REQUIRE(porytiles::assignByComponents(ctx, problem, noDeadline, solution));
+    REQUIRE(solution.size() == 3);
+    for (const auto &palette : solution) {
+      CHECK(palette.count() <= porytiles::PAL_SIZE - 1);
+    }
+    for (const auto &colorSet : problem.unassignedNormPalettes) {
+      CHECK(std::any_of(std::begin(solution), std::end(solution),
+                        [&colorSet](const auto &palette) { return colorSet.isSubsetOf(palette); }));
+    }
+  }
+
+  SUBCASE("it should fail if the components cannot be packed into the hardware palettes")
+  {
+    porytiles::AssignProblem tooSmall = problem;
+    tooSmall.hardwarePaletteCount = 2;
+    std::vector<ColorSet> solution{};
+    CHECK_FALSE(porytiles::assignByComponents(ctx, tooSmall, noDeadline, solution));
+  }
+}
+
+TEST_CASE("a compile after the component split won should rerun the split from assign.cache")
+{
+  std::filesystem::path parentDir = porytiles::createTmpdir();
+  std::filesystem::path cachePath = porytiles::getTmpfilePath(parentDir, "assign.cache");
+  std::unordered_map<porytiles::BGR15, std::size_t> colorToIndex{};
+  for (std::size_t i = 0; i < 30; i++) {
+    colorToIndex.insert(std::pair{porytiles::BGR15{static_cast<std::uint16_t>(i)}, i});
+  }
+
+  // The first compile leaves the config like this when the matrix fails and the component split packs the palettes
+  porytiles::PorytilesContext firstCtx{};
+  std::vector<ColorSet> firstSolution{colorRange(0, 4) | colorRange(10, 14) | colorRange(20, 24),
+                                      colorRange(5, 9) | colorRange(15, 19) | colorRange(25, 29), ColorSet{}};
+  porytiles::writeAssignParamsToConfig(firstCtx.compilerConfig, porytiles::CompilerMode::PRIMARY,
+                                       porytiles::COMPONENT_SPLIT_PARAMS);
+  porytiles::writeAssignSolutionToConfig(firstCtx.compilerConfig, porytiles::CompilerMode::PRIMARY, firstSolution,
+                                         porytiles::invertColorIndexMap(colorToIndex));
+  std::ofstream outFile{cachePath};
+  porytiles::emitAssignCache(firstCtx, porytiles::CompilerMode::PRIMARY, outFile);
+  outFile.close();
+
+  porytiles::PorytilesContext ctx{};
+  ctx.subcommand = porytiles::Subcommand::COMPILE_PRIMARY;
+  ctx.fieldmapConfig.numPalettesInPrimary = 3;
+  ctx.err.printErrors = false;
+  ctx.err.invalidAssignCache = porytiles::WarningMode::WARN;
+  std::ifstream inFile{cachePath};
+  porytiles::importAssignmentCache(ctx, porytiles::CompilerMode::PRIMARY, porytiles::CompilerMode::PRIMARY, inFile);
+  inFile.close();
+  REQUIRE(ctx.compilerConfig.primaryAssignAlgorithm == porytiles::AssignAlgorithm::COMPONENTS);
+
+  /*
+   * After the edit no cached palette covers a ColorSet, and the one empty palette only has room for one of them, so the
+   * incremental run fails and the cache step has to solve the whole problem.
+   */
+  std::vector<ColorSet> colorSets{colorRange(0, 9), colorRange(10, 19), colorRange(20, 29)};
+  auto [palettes, primaryPalettes] =
+      porytiles::runPaletteAssignmentMatrix(ctx, porytiles::CompilerMode::PRIMARY, colorSets, {}, colorToIndex);
+  CHECK(ctx.err.warnCount == 0);
+  CHECK(ctx.compilerConfig.primaryAssignAlgorithm == porytiles::AssignAlgorithm::COMPONENTS);
+  for (const auto &colorSet : colorSets) {
+    CHECK(std::any_of(std::begin(palettes), std::end(palettes),
+                      [&colorSet](const auto &palette) { return colorSet.isSubsetOf(palette); }));
+  }
+
+  std::filesystem::remove_all(parentDir);
+}
+
+TEST_CASE("NogoodTable should evict with the clock algorithm once a bucket is full")
+{
+  porytiles::NogoodTable table{1};
+  for (std::uint64_t key = 1; key <= porytiles::NOGOOD_TABLE_WAYS; key++) {
+    table.insert(key);
+  }
+  for (std::uint64_t key = 1; key <= porytiles::NOGOOD_TABLE_WAYS; key++) {
+    CHECK(table.contains(key));
+  }
+
+  // Everything was referenced, so the hand sweeps all the way around and evicts the oldest key
+  table.insert(100);
+  CHECK_FALSE(table.contains(1));
+  CHECK(table.contains(100));
+
+  // Key 2 is now the only slot not referenced since the sweep, so it goes next
+  CHECK(table.contains(3));
+  CHECK(table.contains(4));
+  table.insert(200);
+  CHECK_FALSE(table.contains(2));
+  CHECK(table.contains(200));
+  CHECK(table.contains(3));
+  CHECK(table.contains(4));
+  CHECK(table.contains(100));
+
+  SUBCASE("clear should forget every key and reset the hand")
+  {
+    table.clear();
+    for (std::uint64_t key : {3, 4, 100, 200}) {
+      CHECK_FALSE(table.contains(key));
+    }
+    for (std::uint64_t key = 1; key <= porytiles::NOGOOD_TABLE_WAYS; key++) {
+      table.insert(key);
+    }
+    for (std::uint64_t key = 1; key <= porytiles::NOGOOD_TABLE_WAYS; key++) {
+      CHECK(table.contains(key));
+    }
+  }
+}
+
+TEST_CASE("assignDepthFirst should skip states it has already seen fail")
+{
+  porytiles::PorytilesContext ctx{};
+  // Seven disjoint sets of seven colors, three palettes can hold at most two of them each
+  std::vector<ColorSet> unassigneds{};
+  for (std::size_t set = 0; set < 7; set++) {
+    ColorSet colorSet{};
+    for (std::size_t color = 0; color < 7; color++) {
+      colorSet.set(set * 7 + color);
+    }
+    unassigneds.push_back(colorSet);
+  }
+
+  auto exploredNodes = [&](const porytiles::AssignParams &params, porytiles::NogoodTable *nogoods) {
+    porytiles::AssignSearch search{params};
+    search.nogoods = nogoods;
+    porytiles::AssignState state = {porytiles::HardwarePalettes{3}, unassigneds.size(), 0};
+    std::vector<ColorSet> solution{};
+    CHECK(porytiles::assignDepthFirst(ctx, search, state, solution, {}, unassigneds, {}) ==
+          porytiles::AssignResult::NO_SOLUTION_POSSIBLE);
+    return search.exploredNodeCounter;
+  };
+
+  SUBCASE("it should fold permutations together when branching into every palette")
+  {
+    porytiles::AssignParams params{porytiles::AssignAlgorithm::DFS, SIZE_MAX, SIZE_MAX, false};
+    porytiles::NogoodTable nogoods{porytiles::NOGOOD_TABLE_BUCKETS};
+    CHECK(exploredNodes(params, &nogoods) < exploredNodes(params, nullptr));
+  }
+
+  SUBCASE("it should still help with a constant best branches limit")
+  {
+    porytiles::AssignParams params{porytiles::AssignAlgorithm::DFS, SIZE_MAX, 2, false};
+    porytiles::NogoodTable nogoods{porytiles::NOGOOD_TABLE_BUCKETS};
+    CHECK(exploredNodes(params, &nogoods) < exploredNodes(params, nullptr));
+  }
+}
+
+TEST_CASE("nogoodKey should only fold permutations together when the search tries every palette")
+{
+  // Two palettes of the same size that share no colors, so only the input order breaks their tie
+  ColorSet redGreen{};
+  redGreen.set(0);
+  redGreen.set(1);
+  ColorSet blueCyan{};
+  blueCyan.set(2);
+  blueCyan.set(3);
+  porytiles::AssignState state = {std::vector<ColorSet>{redGreen, blueCyan}, 3, 0};
+  porytiles::AssignState swapped = {std::vector<ColorSet>{blueCyan, redGreen}, 3, 0};
+
+  porytiles::AssignSearch everyPalette{
+      porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, SIZE_MAX, SIZE_MAX, false}};
+  CHECK(porytiles::nogoodKey(everyPalette, state) == porytiles::nogoodKey(everyPalette, swapped));
+
+  porytiles::AssignSearch smartPrune{
+      porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, SIZE_MAX, SIZE_MAX, true}};
+  CHECK_FALSE(porytiles::nogoodKey(smartPrune, state) == porytiles::nogoodKey(smartPrune, swapped));
+
+  porytiles::AssignSearch constantPrune{porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, SIZE_MAX, 1, false}};
+  CHECK_FALSE(porytiles::nogoodKey(constantPrune, state) == porytiles::nogoodKey(constantPrune, swapped));
+}
+
+TEST_CASE("paletteLowerBound should count ColorSets that cannot share a palette with each other")
+{
+  // Each pair of these has a union of more than 15 colors, the small one fits next to any of them
+  ColorSet big1 = colorRange(0, 9);
+  ColorSet big2 = colorRange(10, 19);
+  ColorSet big3 = colorRange(20, 29);
+  ColorSet small = colorRange(30, 31);
+
+  SUBCASE("it should find the whole incompatible group")
+  {
+    porytiles::AssignProblem problem{2, {small, big1, big2, big3}, {}, {}};
+    CHECK(porytiles::paletteLowerBound(problem) == 3);
+  }
+
+  SUBCASE("it should ignore ColorSets that a primary palette covers")
+  {
+    porytiles::AssignProblem problem{2, {small, big1, big2, big3}, {}, {colorRange(0, 14)}};
+    CHECK(porytiles::paletteLowerBound(problem) == 2);
+  }
+
+  SUBCASE("it should let a search fail fast when the group no longer fits")
+  {
+    porytiles::PorytilesContext ctx{};
+    porytiles::AssignSearch search{porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, SIZE_MAX, SIZE_MAX, false}};
+    std::vector<ColorSet> unassigneds{small, big1, big2, big3};
+    porytiles::AssignState state = {porytiles::HardwarePalettes{2}, unassigneds.size(), 0};
+    CHECK(porytiles::remainingCannotFit(state, porytiles::primaryCoverage<ColorSet>({}, unassigneds, {}), unassigneds,
+                                        {}));
+
+    std::vector<ColorSet> solution{};
+    CHECK(porytiles::assignDepthFirst(ctx, search, state, solution, {}, unassigneds, {}) ==
+          porytiles::AssignResult::NO_SOLUTION_POSSIBLE);
+    CHECK(search.exploredNodeCounter == 1);
+  }
+}
+
+TEST_CASE("assignGreedy should pack the most constrained ColorSets first")
+{
+  // Each pair of the big ones has a union of more than 15 colors, the small one fits next to any of them
+  ColorSet big1 = colorRange(0, 9);
+  ColorSet big2 = colorRange(10, 19);
+  ColorSet big3 = colorRange(20, 29);
+  ColorSet small = colorRange(30, 31);
+
+  SUBCASE("it should place every ColorSet when the palettes have room")
+  {
+    porytiles::AssignProblem problem{3, {small, big1, big2, big3}, {}, {}};
+    porytiles::GreedyAssignment greedy = porytiles::assignGreedy(problem);
+    CHECK(greedy.unplacedCount == 0);
+    CHECK(greedy.normOrder == std::vector<ColorSet>{big1, big2, big3, small});
+    REQUIRE(greedy.palettes.size() == 3);
+    CHECK(greedy.palettes.at(0) == (big1 | small));
+    CHECK(greedy.palettes.at(1) == big2);
+    CHECK(greedy.palettes.at(2) == big3);
+  }
+
+  SUBCASE("it should carry on past a ColorSet with no room and hand its order to the searches")
+  {
+    porytiles::AssignProblem problem{2, {small, big1, big2, big3}, {}, {}};
+    porytiles::GreedyAssignment greedy = porytiles::assignGreedy(problem);
+    CHECK(greedy.unplacedCount == 1);
+    CHECK(greedy.normOrder == std::vector<ColorSet>{big1, big2, big3, small});
+
+    // The searches assign from the back, so the ColorSet the greedy pass placed first is last
+    porytiles::AssignProblem seeded = porytiles::greedySeededProblem(problem, greedy);
+    CHECK(seeded.unassignedNormPalettes == std::vector<ColorSet>{small, big3, big2, big1});
+  }
+
+  SUBCASE("it should not place ColorSets that a primary palette covers")
+  {
+    porytiles::AssignProblem problem{2, {small, big1, big2, big3}, {}, {colorRange(0, 14)}};
+    porytiles::GreedyAssignment greedy = porytiles::assignGreedy(problem);
+    CHECK(greedy.unplacedCount == 0);
+    CHECK(greedy.normOrder.front() == big1);
+    CHECK_FALSE(std::any_of(std::begin(greedy.palettes), std::end(greedy.palettes),
+                            [&big1](const auto &palette) { return palette.intersects(big1); }));
+  }
+}
+
+TEST_CASE("withoutSubsumedColorSets should drop every ColorSet that another one covers")
+{
+  ColorSet big = colorRange(0, 9);
+  ColorSet inBig = colorRange(2, 4);
+  ColorSet other = colorRange(10, 12);
+  ColorSet overlapping = colorRange(8, 11);
+
+  SUBCASE("it should keep the ColorSets no other one covers, in their order")
+  {
+    porytiles::AssignProblem problem{3, {inBig, other, overlapping, big}, {}, {colorRange(0, 14)}};
+    porytiles::AssignProblem stripped = porytiles::withoutSubsumedColorSets(problem);
+    CHECK(stripped.unassignedNormPalettes == std::vector<ColorSet>{other, overlapping, big});
+    CHECK(stripped.hardwarePaletteCount == 3);
+    CHECK(stripped.primaryPaletteColorSets == problem.primaryPaletteColorSets);
+  }
+
+  SUBCASE("it should keep one of two equal ColorSets, preferring the primer")
+  {
+    porytiles::AssignProblem problem{3, {big, other, big}, {other}, {}};
+    porytiles::AssignProblem stripped = porytiles::withoutSubsumedColorSets(problem);
+    CHECK(stripped.unassignedPrimerPalettes == std::vector<ColorSet>{other});
+    CHECK(stripped.unassignedNormPalettes == std::vector<ColorSet>{big});
+  }
+
+  SUBCASE("it should drop a primer that a regular ColorSet covers")
+  {
+    porytiles::AssignProblem problem{3, {big}, {inBig}, {}};
+    porytiles::AssignProblem stripped = porytiles::withoutSubsumedColorSets(problem);
+    CHECK(stripped.unassignedPrimerPalettes.empty());
+    CHECK(stripped.unassignedNormPalettes == std::vector<ColorSet>{big});
+  }
+}
+
+TEST_CASE("assignLocalSearch should find a valid packing that the greedy seed misses")
+{
+  porytiles::PorytilesContext ctx{};
+  std::vector<ColorSet> unassigneds = twoFullPalettesColorSets();
+  auto run = [&](std::size_t cutoff, std::vector<ColorSet> &solution) {
+    porytiles::AssignSearch search{porytiles::AssignParams{porytiles::AssignAlgorithm::LOCAL, cutoff, SIZE_MAX, true}};
+    porytiles::AssignState state = {porytiles::HardwarePalettes{2}, unassigneds.size(), 0};
+    return porytiles::assignLocalSearch(ctx, search, state, solution, {}, unassigneds, {});
+  };
+
+  SUBCASE("it should place every ColorSet into a palette that fits")
+  {
+    std::vector<ColorSet> solution{};
+    REQUIRE(run(1000, solution) == porytiles::AssignResult::SUCCESS);
+    REQUIRE(solution.size() == 2);
+    for (const auto &palette : solution) {
+      CHECK(palette.count() <= porytiles::PAL_SIZE - 1);
+    }
+    for (const auto &colorSet : unassigneds) {
+      CHECK(std::any_of(std::begin(solution), std::end(solution),
+                        [&colorSet](const auto &palette) { return colorSet.isSubsetOf(palette); }));
+    }
+  }
+
+  SUBCASE("it should be deterministic")
+  {
+    std::vector<ColorSet> solution1{};
+    std::vector<ColorSet> solution2{};
+    REQUIRE(run(1000, solution1) == porytiles::AssignResult::SUCCESS);
+    REQUIRE(run(1000, solution2) == porytiles::AssignResult::SUCCESS);
+    CHECK(solution1 == solution2);
+  }
+
+  SUBCASE("it should give up when the budget runs out on an impossible input")
+  {
+    unassigneds.push_back(colorRange(30, 30));
+    std::vector<ColorSet> solution{};
+    CHECK(run(1000, solution) == porytiles::AssignResult::EXPLORE_CUTOFF_REACHED);
+    CHECK(solution.empty());
+  }
+}
+
+TEST_CASE("assignBeamSearch should keep only the best states at each depth")
+{
+  porytiles::PorytilesContext ctx{};
+  /*
+   * No smart pruning here: none of these ColorSets share a color, so it would only ever try the first palette and the
+   * beam would never have anything to choose from.
+   */
+  std::vector<ColorSet> unassigneds = twoFullPalettesColorSets();
+  auto run = [&](std::size_t beamWidth, std::vector<ColorSet> &solution, std::size_t &nodes) {
+    porytiles::AssignSearch search{
+        porytiles::AssignParams{porytiles::AssignAlgorithm::BEAM, 1'000'000, SIZE_MAX, false, beamWidth}};
+    porytiles::AssignState state = {porytiles::HardwarePalettes{2}, unassigneds.size(), 0};
+    porytiles::AssignResult result = porytiles::assignBeamSearch(ctx, search, state, solution, {}, unassigneds, {});
+    nodes = search.exploredNodeCounter;
+    return result;
+  };
+
+  SUBCASE("a beam of one should still fill both palettes, since it prefers to leave palettes empty")
+  {
+    std::vector<ColorSet> solution{};
+    std::size_t nodes = 0;
+    REQUIRE(run(1, solution, nodes) == porytiles::AssignResult::SUCCESS);
+    REQUIRE(solution.size() == 2);
+    CHECK(solution.at(0).count() == porytiles::PAL_SIZE - 1);
+    CHECK(solution.at(1).count() == porytiles::PAL_SIZE - 1);
+    // One state per depth, plus the final one
+    CHECK(nodes == unassigneds.size() + 1);
+  }
+
+  SUBCASE("it should only claim there is no solution if it never dropped a state")
+  {
+    unassigneds.push_back(colorRange(30, 30));
+    std::vector<ColorSet> solution{};
+    std::size_t nodes = 0;
+    CHECK(run(1, solution, nodes) == porytiles::AssignResult::EXPLORE_CUTOFF_REACHED);
+    CHECK(run(1000, solution, nodes) == porytiles::AssignResult::NO_SOLUTION_POSSIBLE);
+    CHECK(solution.empty());
+  }
+}
+
+TEST_CASE("lubyTerm should follow the Luby sequence")
+{
+  std::vector<std::size_t> terms{};
+  for (std::size_t i = 1; i <= 15; i++) {
+    terms.push_back(porytiles::lubyTerm(i));
+  }
+  CHECK(terms == std::vector<std::size_t>{1, 1, 2, 1, 1, 2, 4, 1, 1, 2, 1, 1, 2, 4, 8});
+}
+
+TEST_CASE("sortPalettesForAssignment should only use the seed to break ties")
+{
+  // The first palette wins on intersection, the other three tie on both intersection and size
+  porytiles::HardwarePalettes palettes{std::vector<ColorSet>{colorRange(0, 2), colorRange(10, 11), colorRange(20, 21),
+                                                             colorRange(30, 31)}};
+  ColorSet toAssign = colorRange(0, 0);
+
+  porytiles::HardwarePalettes unseeded = palettes;
+  porytiles::sortPalettesForAssignment(unseeded, toAssign);
+  CHECK(std::equal(std::begin(unseeded), std::end(unseeded), std::begin(palettes)));
+
+  std::vector<std::vector<ColorSet>> orders{};
+  for (std::size_t restart = 1; restart <= 16; restart++) {
+    porytiles::HardwarePalettes seeded = palettes;
+    porytiles::sortPalettesForAssignment(seeded, toAssign, porytiles::restartSeed(restart));
+    CHECK(seeded[0] == palettes[0]);
+
+    porytiles::HardwarePalettes again = palettes;
+    porytiles::sortPalettesForAssignment(again, toAssign, porytiles::restartSeed(restart));
+    CHECK(seeded == again);
+    std::vector<ColorSet> order(std::begin(seeded), std::end(seeded));
+    if (std::find(std::begin(orders), std::end(orders), order) == std::end(orders)) {
+      orders.push_back(order);
+    }
+  }
+  CHECK(orders.size() > 1);
+}
+
+TEST_CASE("assignDepthFirstRestarts should rewrite its params so a plain run replays the winning burst")
+{
+  porytiles::PorytilesContext ctx{};
+  std::vector<ColorSet> unassigneds = twoFullPalettesColorSets();
+
+  porytiles::AssignParams params{porytiles::AssignAlgorithm::DFS, 1'000'000, SIZE_MAX, false};
+  params.restarts = true;
+  porytiles::AssignSearch search{params};
+  porytiles::AssignState state = {porytiles::HardwarePalettes{2}, unassigneds.size(), 0};
+  std::vector<ColorSet> solution{};
+  REQUIRE(porytiles::assignDepthFirstRestarts(ctx, search, state, solution, {}, unassigneds, {}) ==
+          porytiles::AssignResult::SUCCESS);
+  CHECK_FALSE(search.params.restarts);
+  CHECK(search.params.exploredNodeCutoff == 1'000'000);
+
+  porytiles::AssignSearch replay{search.params};
+  porytiles::AssignState replayState = {porytiles::HardwarePalettes{2}, unassigneds.size(), 0};
+  std::vector<ColorSet> replaySolution{};
+  REQUIRE(porytiles::assignDepthFirst(ctx, replay, replayState, replaySolution, {}, unassigneds, {}) ==
+          porytiles::AssignResult::SUCCESS);
+  CHECK(replaySolution == solution);
+}
+
+TEST_CASE("assignDepthFirstRestarts should only stop at a seeded burst with no solution under exhaustive branching")
+{
+  porytiles::PorytilesContext ctx{};
+  std::mt19937 rng{23};
+  std::uniform_int_distribution<std::size_t> colorDist{0, 44};
+  std::uniform_int_distribution<std::size_t> sizeDist{1, 4};
+  std::vector<ColorSet> unassigneds(48);
+  for (auto &colorSet : unassigneds) {
+    for (std::size_t size = sizeDist(rng); size > 0; size--) {
+      colorSet.set(colorDist(rng));
+    }
+  }
+  std::stable_sort(std::begin(unassigneds), std::end(unassigneds),
+                   [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
+
+  // The first burst runs out of nodes, the second gets through its whole tree, which only trying two palettes proves
+  // nothing about
+  porytiles::AssignParams params{porytiles::AssignAlgorithm::DFS, 40'000, 2, false};
+  params.restarts = true;
+  porytiles::AssignSearch search{params};
+  porytiles::AssignState state = {porytiles::HardwarePalettes{4}, unassigneds.size(), 0};
+  std::vector<ColorSet> solution{};
+  CHECK(porytiles::assignDepthFirstRestarts(ctx, search, state, solution, {}, unassigneds, {}) ==
+        porytiles::AssignResult::EXPLORE_CUTOFF_REACHED);
+  CHECK(search.exploredNodeCounter == 40'000);
+  CHECK(solution.empty());
+}
+
+TEST_CASE("cached palettes should be reused as far as they still cover the ColorSets")
+{
+  porytiles::PorytilesContext ctx{};
+  std::unordered_map<porytiles::BGR15, std::size_t> colorToIndex{};
+  for (std::size_t i = 0; i < 20; i++) {
+    colorToIndex.insert(std::pair{porytiles::BGR15{static_cast<std::uint16_t>(i)}, i});
+  }
+  porytiles::AssignProblem problem{};
+  problem.hardwarePaletteCount = 2;
+  problem.unassignedNormPalettes = {colorSetOf({0, 1}), colorSetOf({1, 2}), colorSetOf({10})};
+  // Color 5 is no longer used by any tile
+  std::vector<std::vector<porytiles::BGR15>> cachedSolution{
+      {porytiles::BGR15{0}, porytiles::BGR15{1}, porytiles::BGR15{2}, porytiles::BGR15{5}}, {porytiles::BGR15{10}}};
+  std::vector<ColorSet> solution{};
+
+  SUBCASE("rebuildCachedSolution should drop colors the tiles no longer use")
+  {
+    REQUIRE(porytiles::rebuildCachedSolution(problem, cachedSolution, colorToIndex, solution));
+    CHECK(solution == std::vector<ColorSet>{colorSetOf({0, 1, 2, 5}), colorSetOf({10})});
+
+    colorToIndex.erase(porytiles::BGR15{5});
+    REQUIRE(porytiles::rebuildCachedSolution(problem, cachedSolution, colorToIndex, solution));
+    CHECK(solution == std::vector<ColorSet>{colorSetOf({0, 1, 2}), colorSetOf({10})});
+  }
+
+  SUBCASE("rebuildCachedSolution should reject the cache if the palette count changed")
+  {
+    problem.hardwarePaletteCount = 3;
+    CHECK_FALSE(porytiles::rebuildCachedSolution(problem, cachedSolution, colorToIndex, solution));
+  }
+
+  SUBCASE("uncoveredRemainder should only keep the ColorSets that no longer fit")
+  {
+    REQUIRE(porytiles::rebuildCachedSolution(problem, cachedSolution, colorToIndex, solution));
+    porytiles::AssignProblem remainder = porytiles::uncoveredRemainder(problem, solution);
+    CHECK(remainder.unassignedNormPalettes.empty());
+
+    problem.unassignedNormPalettes.push_back(colorSetOf({10, 11}));
+    remainder = porytiles::uncoveredRemainder(problem, solution);
+    CHECK(remainder.unassignedNormPalettes == std::vector<ColorSet>{colorSetOf({10, 11})});
+    CHECK(remainder.startingPalettes == solution);
+  }
+
+  SUBCASE("an incremental run should grow the cached palettes in place")
+  {
+    REQUIRE(porytiles::rebuildCachedSolution(problem, cachedSolution, colorToIndex, solution));
+    problem.unassignedNormPalettes.push_back(colorSetOf({10, 11}));
+    porytiles::AssignProblem remainder = porytiles::uncoveredRemainder(problem, solution);
+
+    std::vector<ColorSet> incrementalSolution{};
+    porytiles::AssignSearch search{porytiles::INCREMENTAL_PARAMS};
+    REQUIRE(porytiles::runAssignment(ctx, remainder, search, incrementalSolution, 1) ==
+            porytiles::AssignResult::SUCCESS);
+    porytiles::restorePaletteOrder(solution, incrementalSolution);
+    CHECK(incrementalSolution == std::vector<ColorSet>{colorSetOf({0, 1, 2, 5}), colorSetOf({10, 11})});
+  }
+}
+
+TEST_CASE("restorePaletteOrder should put each grown palette back in the slot it started in")
+{
+  std::vector<ColorSet> startingPalettes{colorSetOf({}), colorSetOf({1}), colorSetOf({1, 2}), colorSetOf({})};
+  std::vector<ColorSet> solution{colorSetOf({1, 2, 3}), colorSetOf({1, 4}), colorSetOf({7}), colorSetOf({})};
+  porytiles::restorePaletteOrder(startingPalettes, solution);
+  CHECK(solution == std::vector<ColorSet>{colorSetOf({}), colorSetOf({1, 4}), colorSetOf({1, 2, 3}), colorSetOf({7})});
+}
+
+TEST_CASE("assignment searches should stop once their deadline passes and report that they timed out")
+{
+  using Clock = porytiles::AssignCancelToken::Clock;
+  porytiles::PorytilesContext ctx{};
+  std::vector<ColorSet> unassigneds{};
+  for (std::size_t i = 0; i < 8; i++) {
+    ColorSet colorSet{};
+    colorSet.set(i);
+    colorSet.set(i + 8);
+    unassigneds.push_back(colorSet);
+  }
+  porytiles::AssignProblem problem{4, unassigneds, {}, {}};
+  porytiles::AssignCancelToken expired{};
+  expired.deadline = Clock::now() - std::chrono::seconds{1};
+  // A token with no deadline of its own still inherits the one from its parent
+  porytiles::AssignCancelToken child{&expired};
+
+  auto run = [&](porytiles::AssignAlgorithm algorithm, std::size_t jobs, const porytiles::AssignCancelToken &token) {
+    porytiles::AssignSearch search{porytiles::AssignParams{algorithm, 1'000'000, SIZE_MAX, false}};
+    search.cancelToken = &token;
+    std::vector<ColorSet> solution{};
+    porytiles::AssignResult result = porytiles::runAssignment(ctx, problem, search, solution, jobs);
+    CHECK(search.timedOut);
+    return result;
+  };
+
+  CHECK(run(porytiles::AssignAlgorithm::DFS, 1, child) == porytiles::AssignResult::CANCELLED);
+  CHECK(run(porytiles::AssignAlgorithm::DFS, 2, child) == porytiles::AssignResult::CANCELLED);
+  CHECK(run(porytiles::AssignAlgorithm::BFS, 1, expired) == porytiles::AssignResult::CANCELLED);
+  CHECK(run(porytiles::AssignAlgorithm::BEAM, 1, expired) == porytiles::AssignResult::CANCELLED);
+}
+
+TEST_CASE("matrixEntryDeadline should split the remaining time across the remaining rounds of entries")
+{
+  using Clock = porytiles::AssignCancelToken::Clock;
+  Clock::time_point deadline = Clock::now() + std::chrono::seconds{porytiles::MATRIX.size()};
+
+  Clock::time_point before = Clock::now();
+  Clock::time_point firstDeadline = porytiles::matrixEntryDeadline(deadline, 0, 1);
+  // About a second each, give or take the time it took to get here
+  CHECK(firstDeadline - before > std::chrono::milliseconds{900});
+  CHECK(firstDeadline - before < std::chrono::milliseconds{1100});
+  CHECK(porytiles::matrixEntryDeadline(deadline, porytiles::MATRIX.size() - 1, 1) == deadline);
+  CHECK(porytiles::matrixEntryDeadline(deadline, 0, porytiles::MATRIX.size()) == deadline);
+  CHECK(porytiles::matrixEntryDeadline(Clock::time_point::max(), 0, 1) == Clock::time_point::max());
+}
+
+TEST_CASE("assignment searches should record stats for the -assign-stats report")
+{
+  porytiles::PorytilesContext ctx{};
+  std::vector<ColorSet> unassigneds{};
+  for (std::size_t i = 0; i < 8; i++) {
+    ColorSet colorSet{};
+    colorSet.set(2 * i);
+    colorSet.set(2 * i + 1);
+    unassigneds.push_back(colorSet);
+  }
+  porytiles::AssignProblem problem{4, unassigneds, {}, {}};
+  std::vector<ColorSet> solution{};
+
+  SUBCASE("depth first search should record its depth and branching")
+  {
+    porytiles::AssignStats stats{};
+    porytiles::AssignSearch search{porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, 1'000, SIZE_MAX, false}};
+    search.stats = &stats;
+    REQUIRE(porytiles::runAssignment(ctx, problem, search, solution, 1) == porytiles::AssignResult::SUCCESS);
+    CHECK(stats.exploredNodes == search.exploredNodeCounter);
+    CHECK(stats.maxDepth == unassigneds.size());
+    // Every ColorSet fits on the first try, so we expanded one node per ColorSet and never backed out of any
+    CHECK(std::accumulate(std::begin(stats.branchFactorHistogram), std::end(stats.branchFactorHistogram),
+                          std::size_t{0}) == unassigneds.size());
+    CHECK(stats.backtracksPerDepth.empty());
+  }
+
+  SUBCASE("a search that cannot fit at all should back out at the root")
+  {
+    porytiles::AssignProblem tooSmall{2, {colorRange(0, 14), colorRange(15, 29), colorRange(30, 44)}, {}, {}};
+    porytiles::AssignStats stats{};
+    porytiles::AssignSearch search{porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, 1'000, SIZE_MAX, false}};
+    search.stats = &stats;
+    CHECK(porytiles::runAssignment(ctx, tooSmall, search, solution, 1) ==
+          porytiles::AssignResult::NO_SOLUTION_POSSIBLE);
+    CHECK(stats.backtracksPerDepth == std::vector<std::size_t>{1});
+  }
+
+  SUBCASE("breadth first search should record its queues and visited set")
+  {
+    porytiles::AssignStats stats{};
+    porytiles::AssignSearch search{porytiles::AssignParams{porytiles::AssignAlgorithm::BFS, 1'000, SIZE_MAX, false}};
+    search.stats = &stats;
+    REQUIRE(porytiles::runAssignment(ctx, problem, search, solution, 1) == porytiles::AssignResult::SUCCESS);
+    CHECK(stats.maxDepth == unassigneds.size());
+    CHECK(stats.queueHighWater > 0);
+    CHECK(stats.visitedStates > 0);
+    CHECK(stats.visitedLoadFactor > 0);
+  }
+
+  SUBCASE("parallel depth first search should merge the stats from every job")
+  {
+    porytiles::AssignStats stats{};
+    porytiles::AssignSearch search{porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, 1'000, SIZE_MAX, false}};
+    search.stats = &stats;
+    REQUIRE(porytiles::runAssignment(ctx, problem, search, solution, 2) == porytiles::AssignResult::SUCCESS);
+    CHECK(stats.exploredNodes == search.exploredNodeCounter);
+    CHECK(stats.maxDepth == unassigneds.size());
+    CHECK_FALSE(stats.branchFactorHistogram.empty());
+  }
+}
+
+TEST_CASE("runAssignment should find the same solution at every ColorSet width")
+{
+  porytiles::PorytilesContext ctx{};
+  std::mt19937 rng{2024};
+  std::uniform_int_distribution<std::size_t> colorDist{0, 40};
+  std::vector<ColorSet> unassigneds{};
+  for (std::size_t i = 0; i < 14; i++) {
+    ColorSet colorSet{};
+    for (std::size_t j = 0; j < 4; j++) {
+      colorSet.set(colorDist(rng));
+    }
+    unassigneds.push_back(colorSet);
+  }
+  std::stable_sort(std::begin(unassigneds), std::end(unassigneds),
+                   [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
+
+  for (auto algorithm : {porytiles::AssignAlgorithm::DFS, porytiles::AssignAlgorithm::BFS,
+                         porytiles::AssignAlgorithm::BEAM, porytiles::AssignAlgorithm::LOCAL}) {
+    std::vector<std::pair<porytiles::AssignResult, std::vector<ColorSet>>> runs{};
+    // 41 colors fits the 64-bit sets, 100 needs the 128-bit ones and the default runs at full width
+    for (std::size_t colorCount : {std::size_t{41}, std::size_t{100}, ColorSet{}.size()}) {
+      porytiles::AssignProblem problem{4, unassigneds, {}, {}, {}, colorCount};
+      porytiles::AssignSearch search{porytiles::AssignParams{algorithm, 100'000, SIZE_MAX, false}};
+      std::vector<ColorSet> solution{};
+      porytiles::AssignResult result = porytiles::runAssignment(ctx, problem, search, solution, 1);
+      runs.emplace_back(result, solution);
+    }
+    CHECK(runs.at(0).first == porytiles::AssignResult::SUCCESS);
+    CHECK(runs.at(0) == runs.at(1));
+    CHECK(runs.at(0) == runs.at(2));
+  }
+
+  CHECK(sizeof(porytiles::BasicAssignState<porytiles::ColorSet64>) < sizeof(porytiles::AssignState));
+}
+
+TEST_CASE("runAssignment should leave ColorSets covered by a primary palette out of the search")
+{
+  porytiles::PorytilesContext ctx{};
+  std::mt19937 rng{77};
+  std::uniform_int_distribution<std::size_t> colorDist{0, 44};
+  std::vector<ColorSet> primaryPalettes(2);
+  for (std::size_t i = 0; i < 15; i++) {
+    primaryPalettes.at(0).set(i);
+    primaryPalettes.at(1).set(15 + i);
+  }
+  std::vector<ColorSet> unassigneds{};
+  std::size_t coveredCount = 0;
+  while (unassigneds.size() < 16 || coveredCount < 4) {
+    ColorSet colorSet{};
+    for (std::size_t j = 0; j < 3; j++) {
+      colorSet.set(colorDist(rng));
+    }
+    bool covered = std::any_of(std::begin(primaryPalettes), std::end(primaryPalettes),
+                               [&colorSet](const auto &palette) { return colorSet.isSubsetOf(palette); });
+    if (covered && coveredCount < 4) {
+      coveredCount++;
+      unassigneds.push_back(colorSet);
+    }
+    else if (!covered && unassigneds.size() - coveredCount < 12) {
+      unassigneds.push_back(colorSet);
+    }
+  }
+  std::stable_sort(std::begin(unassigneds), std::end(unassigneds),
+                   [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
+  porytiles::AssignParams params{porytiles::AssignAlgorithm::DFS, 100'000, SIZE_MAX, false};
+
+  // The search proper still handles primary palettes itself, so run it on the full problem for reference
+  porytiles::AssignSearch fullSearch{params};
+  porytiles::AssignState state = {porytiles::HardwarePalettes{3}, unassigneds.size(), 0};
+  std::vector<ColorSet> fullSolution{};
+  porytiles::AssignResult fullResult =
+      porytiles::assignDepthFirst(ctx, fullSearch, state, fullSolution, primaryPalettes, unassigneds, {});
+
+  porytiles::AssignProblem problem{3, unassigneds, {}, primaryPalettes, {}, 45};
+  porytiles::AssignSearch hoistedSearch{params};
+  std::vector<ColorSet> hoistedSolution{};
+  porytiles::AssignResult hoistedResult = porytiles::runAssignment(ctx, problem, hoistedSearch, hoistedSolution, 1);
+
+  CHECK(fullResult == porytiles::AssignResult::SUCCESS);
+  CHECK(hoistedResult == fullResult);
+  CHECK(hoistedSolution == fullSolution);
+  // Each covered ColorSet was a node of its own in the full search
+  CHECK(hoistedSearch.exploredNodeCounter + coveredCount <= fullSearch.exploredNodeCounter);
+}
+
+TEST_CASE("runAssignment should keep the primary palettes in the search when it does not try every palette")
+{
+  porytiles::PorytilesContext ctx{};
+  std::uniform_int_distribution<std::size_t> colorDist{0, 29};
+  std::uniform_int_distribution<std::size_t> sizeDist{1, 8};
+  std::vector<ColorSet> primaryPalettes(2);
+  for (std::size_t i = 0; i < 15; i++) {
+    primaryPalettes.at(0).set(i);
+    primaryPalettes.at(1).set(15 + i);
+  }
+
+  for (const auto &params : {porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, 100'000, SIZE_MAX, true},
+                             porytiles::AssignParams{porytiles::AssignAlgorithm::DFS, 100'000, 2, false},
+                             porytiles::AssignParams{porytiles::AssignAlgorithm::BFS, 100'000, 2, false}}) {
+    for (std::uint32_t problemIndex = 0; problemIndex < 60; problemIndex++) {
+      std::mt19937 rng{problemIndex};
+      std::vector<ColorSet> unassigneds(16);
+      for (auto &colorSet : unassigneds) {
+        for (std::size_t size = sizeDist(rng); size > 0; size--) {
+          colorSet.set(colorDist(rng));
+        }
+      }
+      std::stable_sort(std::begin(unassigneds), std::end(unassigneds),
+                       [](const auto &cs1, const auto &cs2) { return cs1.count() < cs2.count(); });
+
+      // A covered ColorSet that fails through its primary palette may still succeed through a hardware palette here
+      porytiles::AssignSearch referenceSearch{params};
+      porytiles::AssignState state = {porytiles::HardwarePalettes{3}, unassigneds.size(), 0};
+      std::vector<ColorSet> referenceSolution{};
+      porytiles::AssignResult referenceResult =
+          params.assignAlgorithm == porytiles::AssignAlgorithm::DFS
+              ? porytiles::assignDepthFirst(ctx, referenceSearch, state, referenceSolution, primaryPalettes,
+                                            unassigneds, {})
+              : porytiles::assignBreadthFirst(ctx, referenceSearch, state, referenceSolution, primaryPalettes,
+                                              unassigneds, {});
+
+      porytiles::AssignProblem problem{3, unassigneds, {}, primaryPalettes, {}, 30};
+      porytiles::AssignSearch search{params};
+      std::vector<ColorSet> solution{};
+      CHECK(porytiles::runAssignment(ctx, problem, search, solution, 1) == referenceResult);
+      CHECK(solution == referenceSolution);
+    }
+  }
+}
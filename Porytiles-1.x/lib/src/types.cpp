@@ -429,6 +429,44 @@ RGBA32 bgrToRgba(const BGR15 &bgr) noexcept
   return rgba;
 }
 
+void CompilerContext::recordColor(const BGR15 &bgr, const RGBA32 &rgba, const RGBATile &tile, std::size_t row,
+                                  std::size_t col)
+{
+  bgrToRgba.insert_or_assign(bgr, ColorProvenance{rgba, tile.type, tile.layer, tile.subtile, tile.tileIndex,
+                                                  tile.metatileIndex, provenanceName(tile.anim),
+                                                  provenanceName(tile.frame), provenanceName(tile.primer),
+                                                  static_cast<std::uint8_t>(row), static_cast<std::uint8_t>(col)});
+}
+
+std::tuple<RGBA32, RGBATile, std::size_t, std::size_t>
+CompilerContext::colorUse(const ColorProvenance &provenance) const
+{
+  RGBATile tile{};
+  tile.type = provenance.type;
+  tile.layer = provenance.layer;
+  tile.subtile = provenance.subtile;
+  tile.tileIndex = provenance.tileIndex;
+  tile.metatileIndex = provenance.metatileIndex;
+  tile.anim = provenanceNames.at(provenance.anim);
+  tile.frame = provenanceNames.at(provenance.frame);
+  tile.primer = provenanceNames.at(provenance.primer);
+  return std::tuple<RGBA32, RGBATile, std::size_t, std::size_t>{provenance.rgba, tile, provenance.row, provenance.col};
+}
+
+std::uint32_t CompilerContext::provenanceName(const std::string &name)
+{
+  // Layered and freestanding tiles have no names, skip the lookup for them
+  if (name.empty()) {
+    return 0;
+  }
+  auto [entry, inserted] =
+      provenanceNameIndexes.try_emplace(name, static_cast<std::uint32_t>(provenanceNames.size()));
+  if (inserted) {
+    provenanceNames.push_back(name);
+  }
+  return entry->second;
+}
+
 std::filesystem::path CompilerSourcePaths::modeBasedSrcPath(CompilerMode mode) const
 {
   switch (mode) {
@@ -662,6 +700,14 @@ std::string assignAlgorithmString(AssignAlgorithm algo)
     return "dfs";
   case AssignAlgorithm::BFS:
     return "bfs";
+  case AssignAlgorithm::BEAM:
+    return "beam";
+  case AssignAlgorithm::LOCAL:
+    return "local";
+  case AssignAlgorithm::GREEDY:
+    return "greedy";
+  case AssignAlgorithm::COMPONENTS:
+    return "components";
   default:
     internalerror_unknownCompilerMode("types::assignAlgorithmString");
   }
@@ -728,3 +774,47 @@ TEST_CASE("BGR15 to RGBA should upconvert RGB channels to multiples of 8")
   CHECK(porytiles::bgrToRgba(bgr2) == porytiles::RGBA32{248, 248, 248, 255});
   CHECK(porytiles::bgrToRgba(bgr3) == porytiles::RGBA32{0, 160, 96, 255});
 }
+
+TEST_CASE("CompilerContext should rebuild the tile metadata of a recorded color")
+{
+  porytiles::CompilerContext compilerContext{};
+  porytiles::RGBATile layered = porytiles::RGBA_TILE_RED;
+  layered.type = porytiles::TileType::LAYERED;
+  layered.layer = porytiles::TileLayer::MIDDLE;
+  layered.metatileIndex = 42;
+  layered.subtile = porytiles::Subtile::SOUTHEAST;
+  porytiles::RGBATile anim = porytiles::RGBA_TILE_BLUE;
+  anim.type = porytiles::TileType::ANIM;
+  anim.tileIndex = 3;
+  anim.anim = "flower";
+  anim.frame = "01.png";
+
+  compilerContext.recordColor(porytiles::BGR_RED, porytiles::RGBA_RED, layered, 2, 5);
+  compilerContext.recordColor(porytiles::BGR_BLUE, porytiles::RGBA_BLUE, anim, 7, 0);
+  anim.frame = "02.png";
+  compilerContext.recordColor(porytiles::BGR_GREEN, porytiles::RGBA_GREEN, anim, 1, 1);
+  // Names are stored once, no matter how many colors point at them
+  CHECK(compilerContext.provenanceNames.size() == 4);
+
+  auto [layeredRgba, layeredTile, layeredRow, layeredCol] =
+      compilerContext.colorUse(compilerContext.bgrToRgba.at(porytiles::BGR_RED));
+  CHECK(layeredRgba == porytiles::RGBA_RED);
+  CHECK(layeredTile.type == porytiles::TileType::LAYERED);
+  CHECK(layeredTile.layer == porytiles::TileLayer::MIDDLE);
+  CHECK(layeredTile.metatileIndex == 42);
+  CHECK(layeredTile.subtile == porytiles::Subtile::SOUTHEAST);
+  CHECK(layeredRow == 2);
+  CHECK(layeredCol == 5);
+
+  auto [animRgba, animTile, animRow, animCol] =
+      compilerContext.colorUse(compilerContext.bgrToRgba.at(porytiles::BGR_BLUE));
+  CHECK(animRgba == porytiles::RGBA_BLUE);
+  CHECK(animTile.type == porytiles::TileType::ANIM);
+  CHECK(animTile.tileIndex == 3);
+  CHECK(animTile.anim == "flower");
+  CHECK(animTile.frame == "01.png");
+  CHECK(animTile.primer.empty());
+  CHECK(animRow == 7);
+  CHECK(animCol == 0);
+  CHECK(std::get<1>(compilerContext.colorUse(compilerContext.bgrToRgba.at(porytiles::BGR_GREEN))).frame == "02.png");
+}
@@ -5,3 +5,8 @@
  * By defining DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN above, doctest will automatically include a main function that runs
  * the test harness. This file is not intended to be linked in the same executable as 'main.cpp'.
  */
+
+/*
+ * Benchmarks are test cases whose names start with `benchmark' and that are marked doctest::skip(), since they take a
+ * while and only print timings. Run them with `--no-skip -tc="benchmark*"'.
+ */